@@ -0,0 +1,34 @@
+/**
+  ******************************************************************************
+  * @file           : alarm.h
+  * @brief          : Header for alarm.c file.
+  *                   Speaker tones and LED blinking run by hardware timers.
+  ******************************************************************************
+  */
+
+#ifndef __ALARM_H
+#define __ALARM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include <stdbool.h>
+
+#define ALARM_TONE_HZ 250 // Wrong code tone
+#define ALARM_TONE_TICK_HZ 1000000 // TIM8 count rate, tones from 16 Hz up
+#define ALARM_BLINK_TICK_HZ 2000 // TIM2/TIM3 count rate, on + off up to 32 s
+
+void alarm_init(void); // Hands PC9 to TIM8 and the LEDs to TIM2/TIM3, all off
+void alarm_tone(uint32_t hz, uint32_t ms); // Sounds the speaker, TIM8 ends it on its own
+void alarm_silence(void); // Cuts a tone short
+void alarm_blink(uint32_t on_ms, uint32_t off_ms); // Blinks the LEDs, starting on, until alarm_leds()
+void alarm_leds(bool on); // Holds the LEDs on or off
+bool alarm_busy(void); // A tone or blink is running, which needs the timer clocks
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ALARM_H */
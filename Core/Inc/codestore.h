@@ -0,0 +1,116 @@
+/**
+  ******************************************************************************
+  * @file           : codestore.h
+  * @brief          : Header for codestore.c file.
+  *                   Passcodes of 4 to 10 digits in an open-addressing hash
+  *                   table of packed integers, sized at build time.
+  ******************************************************************************
+  */
+
+#ifndef __CODESTORE_H
+#define __CODESTORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CODESTORE_MIN 4 // Shortest code
+#define CODESTORE_MAX 10 // Longest code, a buffer for one needs CODESTORE_MAX + 1 with the terminator
+#define CODESTORE_PREFIXES (10 + 100 + 1000) // Every 1, 2 and 3-digit prefix
+
+// Table size, override at build time. Slots are 8 bytes each, so the
+// defaults take 32 KB and hold 3072 codes.
+#ifndef CODESTORE_SLOT_BITS
+#define CODESTORE_SLOT_BITS 12
+#endif
+#ifndef CODESTORE_LOAD
+#define CODESTORE_LOAD 75 // Percent of the slots that may fill, lower means shorter probes
+#endif
+#define CODESTORE_SLOTS (1u << CODESTORE_SLOT_BITS)
+#define CODESTORE_CAPACITY (CODESTORE_SLOTS * CODESTORE_LOAD / 100)
+
+// A code packed into one integer: the digits left-aligned to 10 places,
+// shifted up 4 bits over the length. Keys compare in the codes' dictionary
+// order, so "1234" < "12340" < "1235", and 0 is never a code.
+typedef uint64_t codestore_key_t;
+#define CODESTORE_NONE ((codestore_key_t)0)
+#define CODESTORE_END (~(codestore_key_t)0) // Above every key, to walk back from
+
+// Slot 0 means empty, removals shift later entries back so there are no
+// tombstones. A count of stored codes under each 1, 2 and 3-digit prefix is
+// kept alongside (2220 bytes), with one of each length, and one bit per slot
+// marks codes picked for removal, moving with its code (512 bytes by default).
+typedef struct {
+	codestore_key_t slots[CODESTORE_SLOTS];
+	uint32_t marks[CODESTORE_SLOTS / 32];
+	uint16_t total;
+	uint16_t marked; // Codes marked
+	uint16_t prefix[CODESTORE_PREFIXES];
+	uint16_t lengths[CODESTORE_MAX + 1]; // Codes of each length
+	uint32_t moves; // Entries shifted back by removals, a walk over the slots that saw this change may have missed one
+	uint32_t changes; // Adds, removals and clears, an index taken at another count is out of date
+} codestore_t;
+
+// Digits typed so far and how many stored codes start with them
+typedef struct {
+	uint64_t value; // Digits as a number
+	uint8_t digits;
+	uint16_t matches; // 0 once no stored code can match, past 3 digits at most the count for the first 3
+	bool found; // The digits so far are a stored code
+	uint32_t changes; // The store's changes when it was narrowed
+} codestore_cursor_t;
+
+// Stored codes in order, for browsing by position. Holds the slot of each
+// code (6 KB by default), so it is only valid until the store next changes;
+// marking codes does not count.
+typedef struct {
+	uint16_t slot[CODESTORE_CAPACITY]; // Slot of the code at each position, from 0
+	uint16_t total;
+	uint32_t changes; // The store's changes when it was sorted
+} codestore_index_t;
+
+void codestore_clear(codestore_t *store); // Removes all codes
+bool codestore_contains(const codestore_t *store, const char *code); // Checks a code
+bool codestore_add(codestore_t *store, const char *code); // false if already stored, invalid or full
+bool codestore_remove(codestore_t *store, const char *code); // false if not stored
+uint16_t codestore_total(const codestore_t *store);
+int codestore_probes(const codestore_t *store, const char *code); // Slots a lookup reads, for benchmarks
+bool codestore_match(const codestore_t *store, const char *code); // As contains, reading every slot in constant time
+
+// Picking codes to remove, then removing them all in one pass over the table
+bool codestore_mark(codestore_t *store, const char *code, bool on); // false if not stored or already so
+bool codestore_marked(const codestore_t *store, const char *code);
+void codestore_unmark(codestore_t *store); // Drops every mark
+uint16_t codestore_sweep(codestore_t *store, void (*removed)(const char *code)); // Removes the marked codes, calling removed for each unless NULL
+
+// Codes are NUL-terminated strings of CODESTORE_MIN to CODESTORE_MAX digits
+codestore_key_t codestore_key(const char *code); // CODESTORE_NONE if not a valid code
+void codestore_code(codestore_key_t key, char *code); // Back to digits, CODESTORE_MAX + 1 bytes
+
+// Walking the stored codes in order, a scan of the table per step
+codestore_key_t codestore_next(const codestore_t *store, codestore_key_t key); // First stored key above key, CODESTORE_NONE if none
+
+// The same order through an index, sorted once then O(1) per position
+void codestore_index(const codestore_t *store, codestore_index_t *index); // Sorts the stored codes into index
+codestore_key_t codestore_at(const codestore_t *store, const codestore_index_t *index, uint16_t position); // CODESTORE_NONE past the end
+bool codestore_current(const codestore_t *store, const codestore_index_t *index); // false once the store changed since the sort
+int codestore_seek(const codestore_t *store, const codestore_index_t *index, const codestore_cursor_t *prefix); // First position starting with the cursor's digits, -1 if none
+
+// Narrowing a code digit by digit, O(1) expected per digit whatever is
+// stored up to 3 digits, for digits that are a stored code and while no
+// longer code is stored. Past that, a pass over the table, ending at the
+// first code that starts with them, tells whether any still can.
+void codestore_begin(const codestore_t *store, codestore_cursor_t *cursor); // No digits, every code matches
+bool codestore_push(const codestore_t *store, codestore_cursor_t *cursor, char digit); // false if not a digit or full
+void codestore_pop(const codestore_t *store, codestore_cursor_t *cursor); // Backspace
+bool codestore_found(const codestore_cursor_t *cursor); // The digits make up a stored code
+void codestore_refresh(const codestore_t *store, codestore_cursor_t *cursor); // Narrows again if the store changed since
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CODESTORE_H */
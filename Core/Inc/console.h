@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file           : console.h
+  * @brief          : Header for console.c file.
+  *                   Command console on USART2 (PA2 TX, PA3 RX) over DMA.
+  ******************************************************************************
+  */
+
+#ifndef __CONSOLE_H
+#define __CONSOLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "codestore.h"
+#include <stdbool.h>
+
+#define CONSOLE_BAUD 115200 // 8N1
+#define CONSOLE_RX 256 // Circular receive buffer, power of two
+#define CONSOLE_TX 256 // Each of the two transmit buffers
+#define CONSOLE_LINE 40 // Longest command, longer lines are dropped
+#define CONSOLE_REPLY 64 // Longest line of output, input waits until a buffer has this much room
+#define CONSOLE_AWAKE_MS 10000 // Stop 2 waits this long after the last byte, as it loses the byte that wakes it
+#define CONSOLE_ADMIN_MS 120000 // An admin login lapses after this long without an admin command or frame
+
+typedef struct {
+	uint32_t received; // Bytes taken from the receive buffer
+	uint32_t sent; // Bytes handed to the transmit DMA
+	uint32_t commands; // Lines run
+	uint32_t overruns; // Bytes lost to a full receive buffer
+	uint32_t wakes; // Stop 2 wake-ups by a start bit, each losing its byte
+	uint32_t errors; // Framing, noise and DMA errors
+} console_stats_t;
+
+void console_init(codestore_t *store); // Starts USART2 receiving, after the codes are mounted
+void console_poll(void); // Main loop only, on EVENT_COMMS: runs complete lines, carries on long output
+bool console_sleep(void); // false while the console needs the core clock, otherwise arms the RX pin to wake Stop 2
+void console_wake(void); // EXTI3 handler, a start bit arrived in Stop 2
+const console_stats_t *console_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONSOLE_H */
@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file           : delay.h
+  * @brief          : Header for delay.c file.
+  *                   Busy-wait delays timed by the DWT cycle counter.
+  ******************************************************************************
+  */
+
+#ifndef __DELAY_H
+#define __DELAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+
+#define DELAY_POINTS 5 // Delays measured by delay_calibrate()
+
+// What delay_calibrate() measured, in the order 100 ns, 1 us, 10 us, 100 us, 1 ms
+typedef struct {
+	uint32_t clock; // SystemCoreClock during the run
+	uint32_t overhead; // Cycles a delay costs beyond its count, subtracted from now on
+	uint32_t asked[DELAY_POINTS]; // ns
+	uint32_t took[DELAY_POINTS]; // ns by CYCCNT, after the fix
+} delay_report_t;
+
+void delay_init(void); // Starts the cycle counter
+void delay_cycles(uint32_t cycles); // Waits at least this many core cycles
+void delay_ns(uint32_t ns); // Rounds up to whole cycles, up to 1 ms
+void delay_us(uint32_t us);
+void delay_ms(uint32_t ms);
+const delay_report_t *delay_calibrate(void); // Measures delay overhead and accuracy
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DELAY_H */
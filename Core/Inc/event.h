@@ -0,0 +1,56 @@
+/**
+  ******************************************************************************
+  * @file           : event.h
+  * @brief          : Header for event.c file.
+  *                   Event queue feeding the run-to-completion main loop.
+  ******************************************************************************
+  */
+
+#ifndef __EVENT_H
+#define __EVENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include <stdbool.h>
+
+#define EVENT_QUEUE 16 // Events waiting for the main loop, power of two
+
+typedef enum {
+	EVENT_KEY, // arg = key character
+	EVENT_TIMER, // arg = which timer
+	EVENT_COMMS, // arg = link specific
+	EVENT_FLASH, // A journal write finished, arg unused
+	EVENT_TYPES
+} event_type_t;
+
+typedef struct {
+	uint8_t type;
+	uint8_t arg;
+} event_t;
+
+// Handling times are DWT->CYCCNT core cycles, from taking the event to the
+// screen flushed. Only the lock's counter times the code; the simulator's
+// follows virtual time, so it has no figure for the M4 to give.
+typedef struct {
+	uint32_t handled; // Events run to completion
+	uint32_t last; // Most recent event
+	uint32_t max; // Slowest event
+	uint8_t maxtype; // Type of the slowest event
+	uint32_t maxof[EVENT_TYPES]; // Slowest event of each type
+	uint8_t depth; // Most events ever queued at once
+	uint32_t dropped; // Posts lost to a full queue
+} event_stats_t;
+
+bool event_post(uint8_t type, uint8_t arg); // Safe from interrupts, false if the queue is full
+bool event_get(event_t *ev); // Takes the oldest event, false if none is queued
+void event_done(const event_t *ev, uint32_t cycles); // Records how long an event took
+const event_stats_t *event_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EVENT_H */
@@ -0,0 +1,58 @@
+/**
+  ******************************************************************************
+  * @file           : journal.h
+  * @brief          : Header for journal.c file.
+  *                   Codes kept in internal flash as an append-only journal.
+  ******************************************************************************
+  */
+
+#ifndef __JOURNAL_H
+#define __JOURNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "codestore.h"
+#include <stdbool.h>
+
+#define JOURNAL_PAGE 2048 // Flash page
+#define JOURNAL_BANK_BASE (FLASH_BASE + 0x80000) // Bank 2, kept for data so bank 1 can run code while it is written
+#define JOURNAL_FIRST_PAGE 192 // Bank 2 page the ring starts at, so it runs to the end of flash
+#define JOURNAL_PAGES 64 // Pages in the ring, 128 KB
+#define JOURNAL_SEGMENT_PAGES 16 // Pages erased and filled together, enough for a full snapshot
+#define JOURNAL_BASE (JOURNAL_BANK_BASE + JOURNAL_FIRST_PAGE * JOURNAL_PAGE)
+#define JOURNAL_SEGMENTS (JOURNAL_PAGES / JOURNAL_SEGMENT_PAGES)
+#define JOURNAL_RECORDS (JOURNAL_SEGMENT_PAGES * JOURNAL_PAGE / 8) // Double-words per segment, header included
+#define JOURNAL_QUEUE 32 // Changes waiting for the flash, power of two
+#define JOURNAL_BATCH 16 // Adds held for one commit at most, leaving the queue room for them
+
+typedef struct {
+	uint32_t records; // Records appended since boot
+	uint32_t compactions; // Segments opened with a snapshot of the codes
+	uint32_t mounted; // Records replayed at boot, at most one segment's worth
+	uint32_t torn; // Records found half written at boot
+	uint32_t errors; // Flash operations that failed, the codes in RAM stay right
+	uint32_t overflows; // Changes that found the queue full and left it to a snapshot
+	uint8_t depth; // Most changes ever queued at once
+	uint8_t queued; // Changes waiting now, the one being programmed included
+} journal_stats_t;
+
+bool journal_mount(codestore_t *store); // Rebuilds the codes from flash, false if none were ever saved
+bool journal_add(const char *code); // Call after the store changed, queues the record, false before a mount
+bool journal_remove(const char *code);
+bool journal_clear(const char *keep); // All codes removed, then keep stored unless NULL
+void journal_begin(void); // Adds from here are held and written in batches of JOURNAL_BATCH
+void journal_commit(void); // Writes the adds held so far, and ends batching
+bool journal_ready(void); // A flash operation finished, journal_poll() starts the next
+void journal_poll(void); // Main loop only
+bool journal_busy(void); // Flash operation in flight, Stop 2 must wait
+const char *journal_record(uint32_t index, uint64_t *data); // Kind and data of a record in the mounted segment, NULL past the last
+const journal_stats_t *journal_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JOURNAL_H */
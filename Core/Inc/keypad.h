@@ -0,0 +1,48 @@
+/**
+  ******************************************************************************
+  * @file           : keypad.h
+  * @brief          : Header for keypad.c file.
+  *                   4x4 keypad scanned by timers and DMA, with a key event
+  *                   queue.
+  ******************************************************************************
+  */
+
+#ifndef __KEYPAD_H
+#define __KEYPAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include <stdbool.h>
+
+#define KEYPAD_COLS (GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4) // PB1 - PB4, outputs
+#define KEYPAD_ROWS (GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11) // PB8 - PB11, EXTI inputs
+#define KEYPAD_ROW_SHIFT 8 // PB8 is the first row
+#define KEYPAD_DEBOUNCE_MS 10 // A key reads the same this long before its press or release counts
+#define KEYPAD_SAMPLES 4 // Scans in that window, 1 to 4 for the 2-bit counters
+#define KEYPAD_SCAN_US (KEYPAD_DEBOUNCE_MS * 1000 / KEYPAD_SAMPLES) // Whole pad, one sample of every key
+#define KEYPAD_COLUMN_US (KEYPAD_SCAN_US / 4) // Each column driven this long, rows read halfway through
+#define KEYPAD_BATCH 1 // Scans captured per DMA half, one debounce pass each
+#define KEYPAD_QUEUE 32 // Key events held for the application, power of two
+#define KEYPAD_RELEASED 0x80 // Set in an event for a key let go
+
+typedef struct {
+	uint32_t scans; // Debounce passes, one per scan of the pad
+	uint32_t ghosts; // Scans ignored because keys down on two rows in two columns make a ghost possible
+	uint32_t dropped; // Events lost to a full queue
+} keypad_stats_t;
+
+void keypad_init(void); // Sets up the scan timers and DMA and arms the row interrupts
+bool keypad_getevent(unsigned char *event); // Takes the oldest press or release, false if none is queued
+bool keypad_getkey(unsigned char *key); // Takes the oldest press, dropping releases before it
+bool keypad_busy(void); // Scanning, the timers and DMA need the clocks
+uint16_t keypad_decode(const volatile uint16_t *samples, bool *ghost); // GPIOB->IDR read with each column driven, column 0 first, to a bit per key (column * 4 + row)
+const keypad_stats_t *keypad_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KEYPAD_H */
@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file           : lcd.h
+  * @brief          : Header for lcd.c file.
+  *                   HD44780 LCD behind a 74HC595 shift register, fed by
+  *                   SPI1 with TIM1-paced DMA, drawn through a RAM shadow
+  *                   and a queue the DMA interrupt drains.
+  ******************************************************************************
+  */
+
+#ifndef __LCD_H
+#define __LCD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include <stdbool.h>
+#include "lcd_screens.h"
+
+#define LCD_SLOT_US 10 // One shift register byte per slot
+#define LCD_SHORT_US 40 // Most instructions and data writes, 37 us + margin
+#define LCD_LONG_US 2000 // Clear display and return home, 1.52 ms + margin
+#define LCD_SHORT_SLOTS (LCD_SHORT_US / LCD_SLOT_US - 1) // Repeats of the last byte after one
+#define LCD_LONG_SLOTS (LCD_LONG_US / LCD_SLOT_US - 1)
+#define LCD_POWERON_MS 20 // Supply to first instruction, 15 ms at 5 V + margin
+#define LCD_BUFFER 256 // Shift register bytes per DMA transfer, refilled from the queue
+#define LCD_QUEUE 256 // Controller bytes waiting to be sent, power of two
+#define LCD_LINE 40 // DDRAM cells per line, LCD_WIDTH of them visible
+#define LCD_WIDTH 16
+#define LCD_CELLS (2 * LCD_LINE)
+
+// Controller bytes (instructions + characters) sent by lcd_flush(), and
+// how full the queue to the controller got
+typedef struct {
+	uint32_t flushes; // Flushes that found changes
+	uint32_t bytes; // Sent by all of them
+	uint16_t last; // Sent by the most recent one
+	uint16_t max; // Sent by the largest one
+	uint16_t depth; // Most bytes ever queued at once
+	uint32_t stalls; // Writes that found the queue full and slept
+	uint32_t composed; // Shift register bytes the CPU built from the queue
+	uint32_t streamed; // Shift register bytes sent straight from prebuilt screens
+} lcd_stats_t;
+
+void lcd_init(void); // Sets up SPI1, TIM1 and DMA, then resets the controller
+void lcd_flush(void); // Sends the shadow cells that changed since the last flush
+void lcd_show(lcd_screen_id_t screen); // Draws a static screen, from flash in one transfer when most cells change
+void lcd_wait(void); // Waits until every queued byte has been latched
+bool lcd_busy(void); // true until every queued byte has been latched
+void lcd_hold(uint16_t us); // Keeps the last byte on the outputs for the given time
+const lcd_stats_t *lcd_stats(void);
+
+void LCD_nibble_write(uint8_t temp, uint8_t s); //configures message for data (1) or instructions (0) with s
+void Write_SR_LCD(uint8_t temp); //writes data to lcd shift register
+void Write_Instr_LCD(uint8_t code); //applies instructions to the shadow
+void Write_Char_LCD(uint8_t code); //writes character to the shadow
+void Write_String_LCD(char *temp); //writes string to the shadow
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCD_H */
@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file           : lcd_screens.h
+  * @brief          : Static screens, sent as prebuilt shift register streams.
+  *                   Tools/lcd_streams.c turns this list into the const
+  *                   arrays in Core/Src/lcd_screens.c. The host build runs
+  *                   it and fails its tests while the copy in the tree is
+  *                   out of date, so run it after changing the list.
+  ******************************************************************************
+  */
+
+#ifndef __LCD_SCREENS_H
+#define __LCD_SCREENS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Name, top line, bottom line. A NULL bottom leaves the cursor after the top
+// line, an empty one at the start of the bottom line.
+#define LCD_SCREEN_LIST(X) \
+	X(LCD_SCREEN_SPLASH, "Digital Lock", NULL) \
+	X(LCD_SCREEN_ENTER, "Enter Code:", "") \
+	X(LCD_SCREEN_NEWCODE, "Enter New Code:", "") \
+	X(LCD_SCREEN_LOCKED, "LOCKED", "") \
+	X(LCD_SCREEN_UNLOCKED, "UNLOCKED", "10") \
+	X(LCD_SCREEN_INVALID, "INVALID CODE", NULL) \
+	X(LCD_SCREEN_ADMIN, "ADMIN", NULL) \
+	X(LCD_SCREEN_MENU1, "1 - View Codes", "A=SEL B=BACK #=>") \
+	X(LCD_SCREEN_MENU2, "2 - Add Codes", "A=SEL B=BACK #=>") \
+	X(LCD_SCREEN_MENU3, "3 - Remove Codes", "A=SEL B=BACK #=>") \
+	X(LCD_SCREEN_MENU4, "4 - Clear Codes", "A=SEL B=BACK #=>") \
+	X(LCD_SCREEN_MENU5, "5 - Bulk Add", "A=SEL B=BACK #=>") \
+	X(LCD_SCREEN_MAXCODES, "MAX CODES", "REACHED") \
+	X(LCD_SCREEN_EXISTS, "CODE EXISTS", NULL) \
+	X(LCD_SCREEN_ANOTHER, "Add another?", "A=Yes       B=No") \
+	X(LCD_SCREEN_SELECT, "SELECT CODES TO", "REMOVE") \
+	X(LCD_SCREEN_DONEHINT, "WHEN DONE,", "PRESS C") \
+	X(LCD_SCREEN_NOCODES, "0 CODES REMAIN", NULL) \
+	X(LCD_SCREEN_CLEAR, "Clear codes?", "A=Yes B=No") \
+	X(LCD_SCREEN_CLEARING, "Clearing codes.", NULL)
+
+typedef enum {
+#define LCD_SCREEN_ID(name, top, bottom) name,
+	LCD_SCREEN_LIST(LCD_SCREEN_ID)
+#undef LCD_SCREEN_ID
+	LCD_SCREENS
+} lcd_screen_id_t;
+
+typedef struct {
+	const char *top, *bottom;
+	const uint8_t *bytes; // Every visible cell, line by line, holds and the trailing slot included
+	uint16_t length;
+	uint8_t address; // Controller address counter after the stream, as a cell index
+} lcd_screen_t;
+
+extern const lcd_screen_t lcd_screens[LCD_SCREENS];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCD_SCREENS_H */
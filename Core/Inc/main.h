@@ -41,6 +41,7 @@ extern "C" {
 
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
+extern const char ADMIN[]; // Code for the admin menu and the console's login
 
 /* USER CODE END EC */
 
@@ -53,6 +54,8 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+void Delay(int delay); // Flushes the LCD, then busy-waits for the given time in ms
+void SystemClock_Config(void); // Also brings the PLL back after Stop 2
 
 /* USER CODE END EFP */
 
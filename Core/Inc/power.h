@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file           : power.h
+  * @brief          : Header for power.c file.
+  *                   Tickless Stop 2 idle with LSE-timed and keypad wake-up.
+  ******************************************************************************
+  */
+
+#ifndef __POWER_H
+#define __POWER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+
+#define POWER_STOP_MIN_MS 2 // Shorter waits use Sleep, Stop 2 entry and PLL relock cost more
+#define POWER_STOP_MAX_MS 60000 // Longest Stop 2 in one go, inside one LPTIM1 turn
+#define POWER_LPTIM_HZ 1024 // LPTIM1 count rate, LSE / 32
+
+// What power_idle() did, restore times in us
+typedef struct {
+	uint32_t stops; // Stop 2 entries
+	uint32_t sleeps; // Sleep entries, when Stop 2 was not allowed
+	uint32_t stopped; // ms spent in Stop 2, by LPTIM1
+	uint32_t restore; // Wake to PLL clock and tick back, most recent Stop 2
+	uint32_t restoremax;
+} power_stats_t;
+
+void power_init(void); // Starts the LSE, LPTIM1 follows once it is ready
+void power_idle(void); // Waits for an interrupt in the deepest mode allowed, interrupts masked
+const power_stats_t *power_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __POWER_H */
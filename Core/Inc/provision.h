@@ -0,0 +1,90 @@
+/**
+  ******************************************************************************
+  * @file           : provision.h
+  * @brief          : Header for provision.c file.
+  *                   Binary code import and export over the console UART.
+  *
+  *                   A zero byte on the console starts a session, which
+  *                   answers OPEN with DENIED unless the console is logged
+  *                   in with the admin code. Frames are
+  *                   COBS encoded and each ends with a zero byte:
+  *                     type, seq, payload (0 to PROVISION_PAYLOAD bytes),
+  *                     CRC-16/CCITT-FALSE of the bytes before it, high byte
+  *                     first
+  *                   Codes in a payload are packed as a digit count (4 to
+  *                   10) followed by the digits in BCD, high nibble first,
+  *                   an odd count padded with 0xF.
+  *
+  *                   Import: the host keeps up to PROVISION_WINDOW IMPORT
+  *                   frames in flight, numbered from 0 after OPEN, each with
+  *                   at most PROVISION_CODES codes. Each one taken in order
+  *                   is stored and journaled as one batch and answered with
+  *                   ACK carrying the next seq expected, once the journal
+  *                   has written it. A frame out of order or failing its
+  *                   CRC gets one NAK with the seq expected, and the host
+  *                   goes back to it.
+  *                   Export: the lock sends DATA frames in table order up to
+  *                   PROVISION_WINDOW ahead of the host's NEXT, then END
+  *                   with the count. NEXT carries the seq the host expects;
+  *                   the same seq twice makes the lock go back to it.
+  ******************************************************************************
+  */
+
+#ifndef __PROVISION_H
+#define __PROVISION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "codestore.h"
+
+#define PROVISION_PAYLOAD 240 // Largest payload, a whole frame fits one console transmit buffer
+#define PROVISION_WINDOW 4 // Frames in flight each way, about 80 ms of line at 115200
+#define PROVISION_IDLE_MS 3000 // Silence that ends a session, so a terminal gets the console back
+#define PROVISION_CODE_BYTES (1 + (CODESTORE_MAX + 1) / 2) // Largest packed code
+#define PROVISION_CODES 7 // Codes stored from one IMPORT frame, a window of them fits the journal queue
+#define PROVISION_FRAME (2 + PROVISION_PAYLOAD + 2 + 1 + 1) // Largest frame encoded: header, payload, CRC, one COBS code byte (under 254) and the delimiter
+
+// Host to lock
+#define PROVISION_OPEN 0x01 // Starts over at seq 0, answered with READY
+#define PROVISION_IMPORT 0x02 // Packed codes to add
+#define PROVISION_EXPORT 0x03 // Starts the DATA frames at the first code
+#define PROVISION_NEXT 0x04 // Export frames before seq arrived
+#define PROVISION_SYNC 0x05 // Answered with SYNCED once the journal has written everything
+#define PROVISION_CLOSE 0x06 // Answered with CLOSED, then the console takes text again
+
+// Lock to host
+#define PROVISION_READY 0x81 // Window, payload size, codes stored (2), capacity (2)
+#define PROVISION_ACK 0x82 // seq expected next; codes added, codes skipped since the last ACK, codes stored (2)
+#define PROVISION_NAK 0x83 // seq expected next
+#define PROVISION_DATA 0x84 // Packed codes
+#define PROVISION_END 0x85 // Codes sent (2), 1 if the codes changed during the export so it may have missed some
+#define PROVISION_SYNCED 0x86 // Codes stored (2), flash errors since boot (2)
+#define PROVISION_CLOSED 0x87
+#define PROVISION_DENIED 0x88 // OPEN without an admin login, every frame but CLOSE is ignored
+
+typedef struct {
+	uint32_t frames; // Frames taken with a good CRC
+	uint32_t bad; // Frames dropped for their CRC, length or COBS coding
+	uint32_t naks; // NAKs sent for frames out of order
+	uint32_t imported; // Codes added by IMPORT
+	uint32_t skipped; // Codes in IMPORT that were invalid, past PROVISION_CODES or found the store full
+	uint32_t exported; // Codes sent in DATA, resent ones included
+	uint32_t rewinds; // Times export went back for the host
+} provision_stats_t;
+
+void provision_init(codestore_t *store);
+void provision_start(bool admin); // Console saw a zero byte, frames follow; admin false denies the session
+bool provision_active(void); // Received bytes go to provision_take()
+uint32_t provision_take(const uint8_t *data, uint32_t len); // Decodes straight from the receive buffer, stops after each frame; bytes used, 0 if the session timed out
+uint16_t provision_send(uint8_t *out, uint16_t room); // Encodes the frames due straight into out; bytes written
+const provision_stats_t *provision_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROVISION_H */
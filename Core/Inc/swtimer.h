@@ -0,0 +1,38 @@
+/**
+  ******************************************************************************
+  * @file           : swtimer.h
+  * @brief          : Header for swtimer.c file.
+  *                   Software timers on the 1 ms HAL tick.
+  ******************************************************************************
+  */
+
+#ifndef __SWTIMER_H
+#define __SWTIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include <stdbool.h>
+
+#define SWTIMER_POOL 8 // Timers shared by the whole firmware
+#define SWTIMER_SLOTS 64 // Wheel slots, one per tick, power of two
+#define SWTIMER_NONE UINT32_MAX // swtimer_next() with no timer running
+
+typedef void (*swtimer_fn_t)(void *arg); // Runs in the SysTick interrupt
+
+int swtimer_create(swtimer_fn_t fn, void *arg); // Takes a timer from the pool, -1 if none are left
+void swtimer_start(int id, uint32_t ms, uint32_t period); // Fires on the ms-th tick from now, then every period ms (0 = once)
+void swtimer_stop(int id);
+bool swtimer_active(int id);
+uint32_t swtimer_ticks(void); // Ticks since reset
+void swtimer_tick(void); // Advances the wheel, called from SysTick_Handler
+uint32_t swtimer_next(void); // Ticks until the next timer fires, SWTIMER_NONE if none
+void swtimer_advance(uint32_t missed); // Catches up ticks missed with SysTick stopped, interrupts masked
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SWTIMER_H */
@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file           : alarm.c
+  * @brief          : Speaker and LED outputs run by hardware timers.
+  *                   TIM8 CH4 drives the speaker on PC9 with a square wave in
+  *                   PWM mode 2, low for the first half of each period so it
+  *                   rests low when the count stops at 0. One-pulse mode
+  *                   with the repetition counter set to the number of
+  *                   periods stops it after the tone's duration without an
+  *                   interrupt.
+  *                   TIM2 CH1/CH2 (PA0/PA1) and TIM3 CH2/CH3 (PC7/PC8) blink
+  *                   the LEDs in PWM mode 1, on for the first part of each
+  *                   period; forced output modes hold them steady. None of it
+  *                   needs the CPU once started, but the timers stop with
+  *                   their clocks in Stop 2, so power_idle() checks
+  *                   alarm_busy().
+  ******************************************************************************
+  */
+
+// Includes
+#include "alarm.h"
+
+// Output compare modes, OCxM
+#define OC_LOW 4u // Forced inactive
+#define OC_HIGH 5u // Forced active
+#define OC_PWM1 6u // Active while CNT < CCR
+#define OC_PWM2 7u // Active once CNT >= CCR
+
+#define TONE_PERIODS 0x10000u // Repetition counter is 16 bits
+#define BLINK_TICKS 0x10000u // TIM3 counts 16 bits
+
+// Sets the output mode of all four LED channels
+static void ledmode(uint32_t mode)
+{
+	TIM2->CCMR1 = (mode << TIM_CCMR1_OC1M_Pos) | (mode << TIM_CCMR1_OC2M_Pos);
+	TIM3->CCMR1 = mode << TIM_CCMR1_OC2M_Pos;
+	TIM3->CCMR2 = mode << TIM_CCMR2_OC3M_Pos;
+}
+
+// Stops both LED timers where they are
+static void ledstop(void)
+{
+	TIM2->CR1 &= ~TIM_CR1_CEN;
+	TIM3->CR1 &= ~TIM_CR1_CEN;
+}
+
+// Moves the speaker and LED pins over to their timers, everything off
+void alarm_init(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	__HAL_RCC_GPIOC_CLK_ENABLE();
+	__HAL_RCC_TIM2_CLK_ENABLE();
+	__HAL_RCC_TIM3_CLK_ENABLE();
+	__HAL_RCC_TIM8_CLK_ENABLE();
+
+	// Timers first, so the pins come over low
+	TIM8->CR1 = 0;
+	TIM8->CNT = 0;
+	TIM8->CCMR2 = OC_LOW << TIM_CCMR2_OC4M_Pos;
+	TIM8->CCER = TIM_CCER_CC4E;
+	TIM8->BDTR = TIM_BDTR_MOE;
+	TIM2->CR1 = 0;
+	TIM3->CR1 = 0;
+	ledmode(OC_LOW);
+	TIM2->CCER = TIM_CCER_CC1E | TIM_CCER_CC2E;
+	TIM3->CCER = TIM_CCER_CC2E | TIM_CCER_CC3E;
+
+	/*Configure LED GPIO pins : PA0 + PA1 (TIM2_CH1/CH2)*/
+	GPIO_InitStruct.Pin = GPIO_PIN_0 | GPIO_PIN_1;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.Alternate = GPIO_AF1_TIM2;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+	/*Configure LED GPIO pins : PC7 + PC8 (TIM3_CH2/CH3)*/
+	GPIO_InitStruct.Pin = GPIO_PIN_7 | GPIO_PIN_8;
+	GPIO_InitStruct.Alternate = GPIO_AF2_TIM3;
+	HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+
+	/*Configure speaker GPIO pin : PC9 (TIM8_CH4)*/
+	GPIO_InitStruct.Pin = GPIO_PIN_9;
+	GPIO_InitStruct.Alternate = GPIO_AF3_TIM8;
+	HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+}
+
+// Starts a square wave of hz for ms. Tones longer than 65536 periods are cut there.
+void alarm_tone(uint32_t hz, uint32_t ms)
+{
+	uint32_t period, periods;
+
+	alarm_silence();
+	if (hz == 0 || ms == 0) {
+		return;
+	}
+	period = ALARM_TONE_TICK_HZ / hz;
+	period = period < 2 ? 2 : (period > 0x10000 ? 0x10000 : period);
+	periods = (uint32_t)(((uint64_t)hz * ms + 999) / 1000);
+	periods = periods > TONE_PERIODS ? TONE_PERIODS : periods;
+
+	TIM8->PSC = SystemCoreClock / ALARM_TONE_TICK_HZ - 1;
+	TIM8->ARR = period - 1;
+	TIM8->CCR4 = period / 2;
+	TIM8->RCR = periods - 1;
+	TIM8->EGR = TIM_EGR_UG; // Loads PSC and the repetition count
+	TIM8->SR = 0;
+	TIM8->CCMR2 = OC_PWM2 << TIM_CCMR2_OC4M_Pos;
+	TIM8->CR1 = TIM_CR1_OPM | TIM_CR1_CEN;
+}
+
+// Stops the tone and holds the speaker low
+void alarm_silence(void)
+{
+	TIM8->CR1 = 0;
+	TIM8->CCMR2 = OC_LOW << TIM_CCMR2_OC4M_Pos;
+}
+
+// Blinks all LEDs together, on for on_ms then off for off_ms
+void alarm_blink(uint32_t on_ms, uint32_t off_ms)
+{
+	uint32_t on = on_ms * (ALARM_BLINK_TICK_HZ / 1000);
+	uint32_t period = on + off_ms * (ALARM_BLINK_TICK_HZ / 1000);
+
+	if (period == 0) {
+		alarm_leds(false);
+		return;
+	}
+	period = period > BLINK_TICKS ? BLINK_TICKS : period;
+
+	ledstop();
+	TIM2->PSC = TIM3->PSC = SystemCoreClock / ALARM_BLINK_TICK_HZ - 1;
+	TIM2->ARR = TIM3->ARR = period - 1;
+	TIM2->CCR1 = TIM2->CCR2 = on;
+	TIM3->CCR2 = TIM3->CCR3 = on;
+	TIM2->EGR = TIM_EGR_UG;
+	TIM3->EGR = TIM_EGR_UG;
+	ledmode(OC_PWM1);
+
+	// Started back to back, the two halves stay in step to a few cycles
+	TIM2->CR1 = TIM_CR1_CEN;
+	TIM3->CR1 = TIM_CR1_CEN;
+}
+
+// Stops any blinking and holds the LEDs
+void alarm_leds(bool on)
+{
+	ledstop();
+	ledmode(on == true ? OC_HIGH : OC_LOW);
+}
+
+// Checks whether a timer is still driving an output
+bool alarm_busy(void)
+{
+	return (TIM8->CR1 & TIM_CR1_CEN) != 0 || (TIM2->CR1 & TIM_CR1_CEN) != 0;
+}
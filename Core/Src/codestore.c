@@ -0,0 +1,538 @@
+/**
+  ******************************************************************************
+  * @file           : codestore.c
+  * @brief          : Passcodes of 4 to 10 digits in an open-addressing hash
+  *                   table. Each code is packed into one 64-bit key and
+  *                   hashed by multiplication to its home slot; collisions
+  *                   probe the following slots in turn. The table never
+  *                   fills past CODESTORE_LOAD percent, so a lookup reads a
+  *                   couple of slots on average with 1 code stored or
+  *                   thousands. Removal shifts back the entries after the
+  *                   gap that would no longer be found past it, so probe
+  *                   runs stay as short as if the removed code had never
+  *                   been added.
+  *                   Codes picked for removal carry a mark bit that moves
+  *                   with them; a sweep then removes them all in one pass,
+  *                   putting each survivor back as near its home slot as
+  *                   the gaps now allow, O(slots) however many go.
+  *                   A count of stored codes under every 1, 2 and 3-digit
+  *                   prefix is kept alongside, so code entry can narrow the
+  *                   candidates as each digit is typed; past 3 digits each
+  *                   digit is one lookup of the code typed so far, and
+  *                   unless that finds it or no longer code is stored, a
+  *                   pass over the table that ends at the first code going
+  *                   on from those digits.
+  *                   For browsing, an index lists the slots in key order.
+  *                   It is heap sorted in place when a browser opens, after
+  *                   which any position is one read and a prefix is a
+  *                   binary search, since the codes under a prefix are one
+  *                   run of positions.
+  ******************************************************************************
+  */
+
+// Includes
+#include "codestore.h"
+#include "string.h"
+
+#define SLOT_MASK (CODESTORE_SLOTS - 1)
+#define PREFIX_DIGITS 3 // Longest prefix with counts
+
+#if CODESTORE_LOAD < 1 || CODESTORE_LOAD > 95
+#error "CODESTORE_LOAD must leave empty slots to end every probe"
+#endif
+
+static const uint16_t prefixbase[] = {0, 0, 10, 110}; // Where each prefix length starts in the counts
+static const uint64_t scale[] = { // 10^n, to left-align n fewer digits
+	1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+	10000000ull, 100000000ull, 1000000000ull, 10000000000ull
+};
+
+// Packs digits with their count into a key
+static codestore_key_t pack(uint64_t value, int digits)
+{
+	return ((value * scale[CODESTORE_MAX - digits]) << 4) | (codestore_key_t)digits;
+}
+
+// First slot a key is looked for in, Fibonacci hashing on the top bits
+static uint32_t home(codestore_key_t key)
+{
+	return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - CODESTORE_SLOT_BITS));
+}
+
+// Slot holding key, -1 if it is not stored. probes counts the slots read.
+static int find(const codestore_t *store, codestore_key_t key, int *probes)
+{
+	uint32_t slot = home(key);
+
+	for (int n = 1; ; n++) {
+		if (store->slots[slot] == key || store->slots[slot] == CODESTORE_NONE) {
+			if (probes != NULL) {
+				*probes = n;
+			}
+			return store->slots[slot] == key ? (int)slot : -1;
+		}
+		slot = (slot + 1) & SLOT_MASK;
+	}
+}
+
+// Adds change (+1 or -1) to the counts over a key
+static void count(codestore_t *store, codestore_key_t key, int change)
+{
+	for (int digits = 1; digits <= PREFIX_DIGITS; digits++) {
+		store->prefix[prefixbase[digits] + (key >> 4) / scale[CODESTORE_MAX - digits]] += change;
+	}
+	store->lengths[key & 0xF] += change;
+	store->total += change;
+	store->changes++;
+}
+
+// Stores a key, false if it was already stored or the table is at its load limit
+static bool insert(codestore_t *store, codestore_key_t key)
+{
+	uint32_t slot = home(key);
+
+	while (store->slots[slot] != CODESTORE_NONE) {
+		if (store->slots[slot] == key) { // Duplicate
+			return false;
+		}
+		slot = (slot + 1) & SLOT_MASK;
+	}
+	if (store->total >= CODESTORE_CAPACITY) {
+		return false;
+	}
+	store->slots[slot] = key;
+	count(store, key, 1);
+	return true;
+}
+
+// Mark bit of a slot
+static bool marked(const codestore_t *store, uint32_t slot)
+{
+	return (store->marks[slot >> 5] >> (slot & 31)) & 1u;
+}
+
+static void setmark(codestore_t *store, uint32_t slot, bool on)
+{
+	if (on) {
+		store->marks[slot >> 5] |= 1u << (slot & 31);
+	} else {
+		store->marks[slot >> 5] &= ~(1u << (slot & 31));
+	}
+}
+
+// Moves an entry and its mark to an empty slot
+static void move(codestore_t *store, uint32_t from, uint32_t to)
+{
+	store->slots[to] = store->slots[from];
+	setmark(store, to, marked(store, from));
+	store->slots[from] = CODESTORE_NONE;
+	setmark(store, from, false);
+	store->moves++;
+}
+
+// Empties a slot, moving back each later entry in the run whose home is not
+// between the gap and where it sits, so every lookup still reaches it
+static void erase(codestore_t *store, uint32_t gap)
+{
+	uint32_t slot = gap;
+
+	count(store, store->slots[gap], -1);
+	if (marked(store, gap)) {
+		setmark(store, gap, false);
+		store->marked--;
+	}
+	store->slots[gap] = CODESTORE_NONE;
+	for (;;) {
+		slot = (slot + 1) & SLOT_MASK;
+		if (store->slots[slot] == CODESTORE_NONE) {
+			break;
+		}
+		if (((slot - home(store->slots[slot])) & SLOT_MASK) >= ((slot - gap) & SLOT_MASK)) {
+			move(store, slot, gap);
+			gap = slot;
+		}
+	}
+}
+
+// Clears every code
+void codestore_clear(codestore_t *store)
+{
+	memset(store->slots, 0, sizeof(store->slots));
+	memset(store->marks, 0, sizeof(store->marks));
+	memset(store->prefix, 0, sizeof(store->prefix));
+	memset(store->lengths, 0, sizeof(store->lengths));
+	store->total = 0;
+	store->marked = 0;
+	store->changes++;
+}
+
+// Converts a code to its key, CODESTORE_NONE unless it is 4 to 10 digits
+codestore_key_t codestore_key(const char *code)
+{
+	uint64_t value = 0;
+	int digits = 0;
+
+	for (; code[digits] != '\0'; digits++) {
+		if (code[digits] < '0' || code[digits] > '9' || digits == CODESTORE_MAX) {
+			return CODESTORE_NONE;
+		}
+		value = value * 10 + (code[digits] - '0');
+	}
+	if (digits < CODESTORE_MIN) {
+		return CODESTORE_NONE;
+	}
+	return pack(value, digits);
+}
+
+// Converts a key back to its digits
+void codestore_code(codestore_key_t key, char *code)
+{
+	int digits = (int)(key & 15);
+	uint64_t value;
+
+	if (digits < CODESTORE_MIN || digits > CODESTORE_MAX) {
+		code[0] = '\0';
+		return;
+	}
+	value = (key >> 4) / scale[CODESTORE_MAX - digits];
+	code[digits] = '\0';
+	for (int i = digits - 1; i >= 0; i--) {
+		code[i] = '0' + (value % 10);
+		value /= 10;
+	}
+}
+
+// Checks if a code is stored
+bool codestore_contains(const codestore_t *store, const char *code)
+{
+	codestore_key_t key = codestore_key(code);
+
+	return key != CODESTORE_NONE && find(store, key, NULL) >= 0;
+}
+
+// Stores a code, false if it was already stored, is not a code or the store is full
+bool codestore_add(codestore_t *store, const char *code)
+{
+	codestore_key_t key = codestore_key(code);
+
+	return key != CODESTORE_NONE && insert(store, key);
+}
+
+// Removes a code, false if it was not stored
+bool codestore_remove(codestore_t *store, const char *code)
+{
+	codestore_key_t key = codestore_key(code);
+	int slot;
+
+	if (key == CODESTORE_NONE || (slot = find(store, key, NULL)) < 0) {
+		return false;
+	}
+	erase(store, (uint32_t)slot);
+	return true;
+}
+
+// Returns number of stored codes
+uint16_t codestore_total(const codestore_t *store)
+{
+	return store->total;
+}
+
+// Counts the slots a lookup of code reads, 0 if it is not a code
+int codestore_probes(const codestore_t *store, const char *code)
+{
+	codestore_key_t key = codestore_key(code);
+	int probes = 0;
+
+	if (key != CODESTORE_NONE) {
+		find(store, key, &probes);
+	}
+	return probes;
+}
+
+// Marks or unmarks a stored code for removal, false if it is not stored or
+// already was
+bool codestore_mark(codestore_t *store, const char *code, bool on)
+{
+	codestore_key_t key = codestore_key(code);
+	int slot;
+
+	if (key == CODESTORE_NONE || (slot = find(store, key, NULL)) < 0 || marked(store, (uint32_t)slot) == on) {
+		return false;
+	}
+	setmark(store, (uint32_t)slot, on);
+	store->marked += on ? 1 : -1;
+	return true;
+}
+
+// Checks if a code is marked for removal
+bool codestore_marked(const codestore_t *store, const char *code)
+{
+	codestore_key_t key = codestore_key(code);
+	int slot;
+
+	return key != CODESTORE_NONE && (slot = find(store, key, NULL)) >= 0 && marked(store, (uint32_t)slot);
+}
+
+// Drops every mark
+void codestore_unmark(codestore_t *store)
+{
+	memset(store->marks, 0, sizeof(store->marks));
+	store->marked = 0;
+}
+
+// Removes every marked code in one pass. It starts after a slot that was
+// empty before any removal, which no probe run crosses, so each entry's
+// home comes before it in the pass. Marked entries are emptied; every other
+// one is lifted out and put back at the first free slot from its home,
+// which is never past where it was, so what has been passed stays
+// reachable. Each survivor costs its own probe length.
+uint16_t codestore_sweep(codestore_t *store, void (*removed)(const char *code))
+{
+	char code[CODESTORE_MAX + 1];
+	uint32_t start = 0;
+	uint16_t gone = 0;
+
+	if (store->marked == 0) {
+		return 0;
+	}
+	while (store->slots[start] != CODESTORE_NONE) {
+		start++;
+	}
+	for (uint32_t n = 1; n <= CODESTORE_SLOTS; n++) {
+		uint32_t slot = (start + n) & SLOT_MASK, to;
+		codestore_key_t key = store->slots[slot];
+
+		if (key == CODESTORE_NONE) {
+			continue;
+		}
+		if (marked(store, slot)) {
+			store->slots[slot] = CODESTORE_NONE;
+			setmark(store, slot, false);
+			count(store, key, -1);
+			gone++;
+			if (removed != NULL) {
+				codestore_code(key, code);
+				removed(code);
+			}
+			continue;
+		}
+		to = home(key);
+		while (to != slot && store->slots[to] != CODESTORE_NONE) {
+			to = (to + 1) & SLOT_MASK;
+		}
+		if (to != slot) {
+			move(store, slot, to);
+		}
+	}
+	store->marked = 0;
+	return gone;
+}
+
+// 1 if two keys are equal, without a branch
+static uint32_t same(codestore_key_t a, codestore_key_t b)
+{
+	uint64_t diff = a ^ b;
+	uint32_t folded = (uint32_t)diff | (uint32_t)(diff >> 32);
+
+	return ((folded | (0u - folded)) >> 31) ^ 1u;
+}
+
+// Checks for a code by comparing it with every slot, four per pass, with
+// no branch on what the slots hold, so a check takes the same time whether
+// the code is stored, where it sits and however full the table is
+bool codestore_match(const codestore_t *store, const char *code)
+{
+	codestore_key_t key = codestore_key(code);
+	const codestore_key_t *slot = store->slots;
+	uint32_t hits = 0;
+
+	for (uint32_t i = 0; i < CODESTORE_SLOTS; i += 4) {
+		hits |= same(slot[i], key) | same(slot[i + 1], key) | same(slot[i + 2], key) | same(slot[i + 3], key);
+	}
+	return (hits & (key != CODESTORE_NONE)) != 0;
+}
+
+// Finds the first stored key above key, CODESTORE_NONE if there is none
+codestore_key_t codestore_next(const codestore_t *store, codestore_key_t key)
+{
+	codestore_key_t best = CODESTORE_END;
+
+	for (uint32_t slot = 0; slot < CODESTORE_SLOTS; slot++) {
+		if (store->slots[slot] > key && store->slots[slot] < best) {
+			best = store->slots[slot];
+		}
+	}
+	return best == CODESTORE_END ? CODESTORE_NONE : best;
+}
+
+// Moves the index entry at down the heap of the first n entries, below the
+// larger of its children until neither is above it
+static void sift(const codestore_t *store, uint16_t *slot, int at, int n)
+{
+	uint16_t held = slot[at];
+	int child;
+
+	while ((child = 2 * at + 1) < n) {
+		if (child + 1 < n && store->slots[slot[child + 1]] > store->slots[slot[child]]) {
+			child++;
+		}
+		if (store->slots[slot[child]] <= store->slots[held]) {
+			break;
+		}
+		slot[at] = slot[child];
+		at = child;
+	}
+	slot[at] = held;
+}
+
+// Lists the stored codes' slots in key order, heap sort with no extra memory
+void codestore_index(const codestore_t *store, codestore_index_t *index)
+{
+	int n = 0;
+
+	for (uint32_t slot = 0; slot < CODESTORE_SLOTS; slot++) {
+		if (store->slots[slot] != CODESTORE_NONE) {
+			index->slot[n++] = (uint16_t)slot;
+		}
+	}
+	for (int i = n / 2 - 1; i >= 0; i--) {
+		sift(store, index->slot, i, n);
+	}
+	for (int i = n - 1; i > 0; i--) {
+		uint16_t top = index->slot[0];
+
+		index->slot[0] = index->slot[i];
+		index->slot[i] = top;
+		sift(store, index->slot, 0, i);
+	}
+	index->total = (uint16_t)n;
+	index->changes = store->changes;
+}
+
+// Checks the index still lists what is stored
+bool codestore_current(const codestore_t *store, const codestore_index_t *index)
+{
+	return index->changes == store->changes;
+}
+
+// Key at a position in the index, CODESTORE_NONE past the end
+codestore_key_t codestore_at(const codestore_t *store, const codestore_index_t *index, uint16_t position)
+{
+	return position < index->total ? store->slots[index->slot[position]] : CODESTORE_NONE;
+}
+
+// Finds the first position whose code starts with the cursor's digits. The
+// lowest key that can is the digits left-aligned with their own count as the
+// length, so shorter codes that read the same padded with zeros stay below.
+int codestore_seek(const codestore_t *store, const codestore_index_t *index, const codestore_cursor_t *prefix)
+{
+	codestore_key_t low = pack(prefix->value, prefix->digits);
+	uint64_t span = scale[CODESTORE_MAX - prefix->digits];
+	int first = 0, last = index->total;
+
+	if (prefix->matches == 0) {
+		return -1; // The counts already say nothing starts with it
+	}
+	while (first < last) {
+		int middle = (first + last) / 2;
+
+		if (store->slots[index->slot[middle]] < low) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+	if (first == index->total || (store->slots[index->slot[first]] >> 4) / span != prefix->value) {
+		return -1;
+	}
+	return first;
+}
+
+// Checks for a stored code longer than the cursor's digits that starts with
+// them, stopping at the first, and not reading the table at all when no
+// code that long is stored. Those are the keys from the digits' own key up
+// to the next prefix's digits, below any length there, so no shorter code
+// reads as one.
+static bool started(const codestore_t *store, const codestore_cursor_t *cursor)
+{
+	codestore_key_t low = pack(cursor->value, cursor->digits);
+	codestore_key_t high = pack(cursor->value + 1, cursor->digits) & ~(codestore_key_t)0xF;
+	uint16_t longer = 0;
+
+	for (int digits = cursor->digits + 1; digits <= CODESTORE_MAX; digits++) {
+		longer += store->lengths[digits];
+	}
+	if (longer == 0) {
+		return false;
+	}
+	for (uint32_t slot = 0; slot < CODESTORE_SLOTS; slot++) {
+		if (store->slots[slot] >= low && store->slots[slot] < high) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Works out what the cursor's digits can still match
+static void narrow(const codestore_t *store, codestore_cursor_t *cursor)
+{
+	cursor->found = cursor->digits >= CODESTORE_MIN && find(store, pack(cursor->value, cursor->digits), NULL) >= 0;
+	if (cursor->digits == 0) {
+		cursor->matches = store->total;
+	} else if (cursor->digits <= PREFIX_DIGITS) {
+		cursor->matches = store->prefix[prefixbase[cursor->digits] + cursor->value];
+	} else {
+		uint64_t first = cursor->value / scale[cursor->digits - PREFIX_DIGITS];
+
+		cursor->matches = store->prefix[prefixbase[PREFIX_DIGITS] + first];
+		if (cursor->matches > 0 && cursor->found == false && started(store, cursor) == false) {
+			cursor->matches = 0; // The counts stop at 3 digits, the table says none go on from here
+		}
+	}
+	cursor->changes = store->changes;
+}
+
+// Starts narrowing with no digits typed
+void codestore_begin(const codestore_t *store, codestore_cursor_t *cursor)
+{
+	cursor->value = 0;
+	cursor->digits = 0;
+	narrow(store, cursor);
+}
+
+// Takes one more digit, false if it is not a digit or the code is at its longest
+bool codestore_push(const codestore_t *store, codestore_cursor_t *cursor, char digit)
+{
+	if (digit < '0' || digit > '9' || cursor->digits == CODESTORE_MAX) {
+		return false;
+	}
+	cursor->value = cursor->value * 10 + (digit - '0');
+	cursor->digits++;
+	narrow(store, cursor);
+	return true;
+}
+
+// Drops the last digit
+void codestore_pop(const codestore_t *store, codestore_cursor_t *cursor)
+{
+	if (cursor->digits > 0) {
+		cursor->value /= 10;
+		cursor->digits--;
+		narrow(store, cursor);
+	}
+}
+
+// Checks whether the digits make up a stored code
+bool codestore_found(const codestore_cursor_t *cursor)
+{
+	return cursor->found;
+}
+
+// Works the cursor out again if codes were added or removed since its last
+// digit, say over the console while the code was being typed
+void codestore_refresh(const codestore_t *store, codestore_cursor_t *cursor)
+{
+	if (cursor->changes != store->changes) {
+		narrow(store, cursor);
+	}
+}
@@ -0,0 +1,585 @@
+/**
+  ******************************************************************************
+  * @file           : console.c
+  * @brief          : Command console on USART2 at CONSOLE_BAUD, 8N1.
+  *                   DMA1 channel 6 receives into a circular buffer without
+  *                   the CPU; the half, full and idle-line events only note
+  *                   how far it got and post EVENT_COMMS, so a line is read
+  *                   and run from the main loop like any other event and
+  *                   never holds up the keypad. Output is queued into one of
+  *                   two buffers while DMA1 channel 7 sends the other.
+  *                   Listings longer than a buffer are written a few lines at
+  *                   a time as the buffers drain, and input waits meanwhile.
+  *                   Commands: help, list, add <code>, remove <code>, stats,
+  *                   log, cycles <code>, login <code> and logout. Changes
+  *                   go through the journal as keypad edits do. list, add,
+  *                   remove and log, like a provisioning session, need a
+  *                   login with the ADMIN code first, which lapses after
+  *                   CONSOLE_ADMIN_MS without one of them. A zero byte,
+  *                   which no terminal sends, hands the bytes after it to
+  *                   provision.c as binary frames, read in place from the
+  *                   receive buffer, until the host closes the session or
+  *                   goes quiet.
+  *                   USART2 stops with the clocks in Stop 2, so just before
+  *                   it the RX pin is armed on EXTI line 3 instead: the
+  *                   start bit of the next byte wakes the core, that byte is
+  *                   lost, and the console then stays out of Stop 2 for
+  *                   CONSOLE_AWAKE_MS. A host should send a newline and wait
+  *                   for the prompt before typing.
+  ******************************************************************************
+  */
+
+// Includes
+#include "console.h"
+#include "stdio.h"
+#include "stdarg.h"
+#include "string.h"
+#include "journal.h"
+#include "event.h"
+#include "power.h"
+#include "keypad.h"
+#include "provision.h"
+
+#if PROVISION_FRAME > CONSOLE_TX
+#error "A provisioning frame must fit one transmit buffer"
+#endif
+
+UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+
+static codestore_t *codes = NULL;
+
+static uint8_t rx[CONSOLE_RX];
+static volatile uint32_t rxtotal = 0; // Bytes the DMA had written at the last receive event
+static uint16_t rxlast = 0; // Buffer position of that event, interrupts only
+static uint32_t rxtaken = 0; // Bytes taken by console_poll()
+static volatile bool rxlost = false; // Reception restarted, drop what is pending
+static volatile uint32_t lastrx = 0; // HAL tick of the last byte or wake-up
+
+static char line[CONSOLE_LINE + 1]; // Command being typed
+static uint8_t linelen = 0;
+static bool toolong = false; // Line overflowed, dropped at its end
+static bool lastcr = false; // Previous byte was CR, so an LF after it is not another line
+static bool admin = false; // Logged in with the ADMIN code
+static uint32_t adminat; // HAL tick of the last admin command or frame
+
+static uint8_t txbuf[2][CONSOLE_TX + 1]; // + 1 for the terminator vsnprintf() writes
+static uint16_t txlen = 0; // Bytes queued in txbuf[txfill]
+static uint8_t txfill = 0;
+static volatile bool sending = false;
+static volatile bool posted = false; // EVENT_COMMS queued and not yet handled
+
+static bool (*more)(void) = NULL; // Output still to come, false once written
+static uint32_t step; // How far it got
+static codestore_key_t listed; // Last code the listing wrote
+static console_stats_t stats;
+
+// Posts one EVENT_COMMS at a time, from interrupts
+static void post(void)
+{
+	if (posted == false) {
+		posted = true;
+		if (event_post(EVENT_COMMS, 0) == false) {
+			posted = false;
+		}
+	}
+}
+
+// Restarts reception at the start of the buffer
+static void receive(void)
+{
+	rxlast = 0;
+	if (HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx, CONSOLE_RX) != HAL_OK) {
+		stats.errors++;
+	}
+}
+
+// Room left in the buffer being filled
+static uint16_t room(void)
+{
+	return CONSOLE_TX - txlen;
+}
+
+// Queues formatted text, cut short if it does not fit
+static void print(const char *format, ...)
+{
+	va_list args;
+	int n;
+
+	va_start(args, format);
+	n = vsnprintf((char *)&txbuf[txfill][txlen], (size_t)room() + 1, format, args);
+	va_end(args);
+	if (n > 0) {
+		txlen += n < room() ? (uint16_t)n : room();
+	}
+}
+
+// Sends the filled buffer unless the other one is still going out
+static void flush(void)
+{
+	if (sending == true || txlen == 0) {
+		return;
+	}
+	sending = true;
+	if (HAL_UART_Transmit_DMA(&huart2, txbuf[txfill], txlen) != HAL_OK) {
+		sending = false;
+		stats.errors++;
+		return;
+	}
+	stats.sent += txlen;
+	txfill ^= 1;
+	txlen = 0;
+}
+
+// Codes in order, a few lines per call. Walking by key rather than by slot
+// keeps the listing right when keypad edits move codes in between.
+static bool listmore(void)
+{
+	char code[CODESTORE_MAX + 1];
+
+	while (room() >= CONSOLE_REPLY) {
+		listed = codestore_next(codes, listed);
+		if (listed == CODESTORE_NONE) {
+			print("%u codes\r\n", (unsigned)step);
+			return false;
+		}
+		codestore_code(listed, code);
+		print("%s\r\n", code);
+		step++;
+	}
+	return true;
+}
+
+// Records of the journal's active segment, a few lines per call
+static bool logmore(void)
+{
+	char code[CODESTORE_MAX + 1];
+	const char *kind;
+	uint64_t data;
+
+	while (room() >= CONSOLE_REPLY) {
+		kind = journal_record(step, &data);
+		if (kind == NULL) {
+			print("%u records\r\n", (unsigned)step);
+			return false;
+		}
+		if (strcmp(kind, "header") == 0 || strcmp(kind, "commit") == 0 || strcmp(kind, "torn") == 0) {
+			print("%5u %-6s %lu\r\n", (unsigned)step, kind, (unsigned long)data);
+		} else {
+			codestore_code(data, code);
+			print("%5u %-6s %s\r\n", (unsigned)step, kind, code);
+		}
+		step++;
+	}
+	return true;
+}
+
+// Figures from each module, a line per call
+static bool statsmore(void)
+{
+	const journal_stats_t *journal = journal_stats();
+	const event_stats_t *events = event_stats();
+	const power_stats_t *power = power_stats();
+	const keypad_stats_t *keypad = keypad_stats();
+
+	while (room() >= CONSOLE_REPLY) {
+		switch (step++) {
+			case 0:
+				print("codes %u/%u\r\n", (unsigned)codestore_total(codes), (unsigned)CODESTORE_CAPACITY);
+				break;
+			case 1:
+				print("journal records %lu, compactions %lu, errors %lu\r\n", (unsigned long)journal->records,
+					(unsigned long)journal->compactions, (unsigned long)journal->errors);
+				break;
+			case 2:
+				print("events %lu, dropped %lu, deepest queue %u\r\n", (unsigned long)events->handled,
+					(unsigned long)events->dropped, (unsigned)events->depth);
+				break;
+			case 3:
+				print("event cycles %lu, keys %lu, timers %lu\r\n", (unsigned long)events->max,
+					(unsigned long)events->maxof[EVENT_KEY], (unsigned long)events->maxof[EVENT_TIMER]);
+				break;
+			case 4:
+				print("stops %lu, sleeps %lu, stopped %lu ms\r\n", (unsigned long)power->stops,
+					(unsigned long)power->sleeps, (unsigned long)power->stopped);
+				break;
+			case 5:
+				print("keypad scans %lu, ghosts %lu, dropped %lu\r\n", (unsigned long)keypad->scans,
+					(unsigned long)keypad->ghosts, (unsigned long)keypad->dropped);
+				break;
+			default:
+				print("console in %lu, out %lu, overruns %lu, wakes %lu, errors %lu\r\n",
+					(unsigned long)stats.received, (unsigned long)stats.sent, (unsigned long)stats.overruns,
+					(unsigned long)stats.wakes, (unsigned long)stats.errors);
+				return false;
+		}
+	}
+	return true;
+}
+
+// Checks for an admin login used within CONSOLE_ADMIN_MS, and keeps it going
+static bool loggedin(void)
+{
+	if (admin == true && HAL_GetTick() - adminat >= CONSOLE_ADMIN_MS) {
+		admin = false;
+	}
+	if (admin == true) {
+		adminat = HAL_GetTick();
+	}
+	return admin;
+}
+
+// Logs in with the whole ADMIN code, not up to the first wrong digit
+static void login(const char *code)
+{
+	if (code != NULL && codestore_key(code) != CODESTORE_NONE && codestore_key(code) == codestore_key(ADMIN)) {
+		admin = true;
+		adminat = HAL_GetTick();
+		print("logged in\r\n");
+	} else {
+		admin = false;
+		print("wrong code\r\n");
+	}
+}
+
+// Adds or removes one code, journaled as the keypad screens do
+static void edit(const char *command, const char *code)
+{
+	bool adding = strcmp(command, "add") == 0;
+
+	if (code == NULL || codestore_key(code) == CODESTORE_NONE) {
+		print("%s: %d to %d digits\r\n", command, CODESTORE_MIN, CODESTORE_MAX);
+	} else if (adding == true && codestore_add(codes, code) == true) {
+		journal_add(code);
+		print("added %s, %u codes\r\n", code, (unsigned)codestore_total(codes));
+	} else if (adding == true) {
+		print("%s\r\n", codestore_contains(codes, code) ? "already stored" : "no room");
+	} else if (codestore_contains(codes, code) == false) {
+		print("not stored\r\n");
+	} else if (codestore_total(codes) == 1) {
+		print("last code, kept\r\n"); // The lock always has one
+	} else {
+		codestore_remove(codes, code);
+		journal_remove(code);
+		print("removed %s, %u codes\r\n", code, (unsigned)codestore_total(codes));
+	}
+}
+
+// Times checking a code in DWT cycles: narrowing the entry cursor digit by
+// digit and reading it on A as the keypad does, one hash lookup, and the
+// constant-time scan of every slot. The simulator's counter follows virtual
+// time, so only the lock's figures mean anything.
+static void cycles(const char *code)
+{
+	codestore_cursor_t cursor;
+	uint32_t start, typed, read, lookup, scan;
+	volatile bool sink;
+
+	if (code == NULL || codestore_key(code) == CODESTORE_NONE) {
+		print("cycles: %d to %d digits\r\n", CODESTORE_MIN, CODESTORE_MAX);
+		return;
+	}
+	start = DWT->CYCCNT;
+	codestore_begin(codes, &cursor);
+	for (int d = 0; code[d] != '\0'; d++) {
+		codestore_push(codes, &cursor, code[d]);
+	}
+	typed = DWT->CYCCNT - start;
+	start = DWT->CYCCNT;
+	sink = codestore_found(&cursor);
+	read = DWT->CYCCNT - start;
+	start = DWT->CYCCNT;
+	sink = codestore_contains(codes, code);
+	lookup = DWT->CYCCNT - start;
+	start = DWT->CYCCNT;
+	sink = codestore_match(codes, code);
+	scan = DWT->CYCCNT - start;
+	print("cursor %lu + A %lu, hash %lu, scan %lu cycles\r\n", (unsigned long)typed, (unsigned long)read,
+		(unsigned long)lookup, (unsigned long)scan);
+}
+
+// Runs one command line
+static void run(char *text)
+{
+	char *command = strtok(text, " ");
+	char *arg = strtok(NULL, " ");
+
+	if (command == NULL) { // Only spaces
+		return;
+	}
+	stats.commands++;
+	step = 0;
+	if (strcmp(command, "help") == 0) {
+		print("list, add <code>, remove <code>, stats, log, cycles <code>, login <code>, logout\r\n");
+	} else if (strcmp(command, "login") == 0) {
+		login(arg);
+	} else if (strcmp(command, "logout") == 0) {
+		admin = false;
+		print("logged out\r\n");
+	} else if ((strcmp(command, "list") == 0 || strcmp(command, "add") == 0 || strcmp(command, "remove") == 0 ||
+		strcmp(command, "log") == 0) && loggedin() == false) {
+		print("%s: login first\r\n", command);
+	} else if (strcmp(command, "list") == 0) {
+		listed = CODESTORE_NONE;
+		more = listmore;
+	} else if (strcmp(command, "add") == 0 || strcmp(command, "remove") == 0) {
+		edit(command, arg);
+	} else if (strcmp(command, "stats") == 0) {
+		more = statsmore;
+	} else if (strcmp(command, "log") == 0) {
+		more = logmore;
+	} else if (strcmp(command, "cycles") == 0) {
+		cycles(arg);
+	} else {
+		print("%s: unknown, try help\r\n", command);
+	}
+}
+
+// Takes one received byte: echoes it, edits the line, runs it on CR or LF
+static void take(uint8_t byte)
+{
+	bool cr = lastcr;
+
+	lastcr = byte == '\r';
+	if (byte == '\r' || byte == '\n') {
+		if (byte == '\n' && cr == true) {
+			return;
+		}
+		print("\r\n");
+		line[linelen] = '\0';
+		if (linelen > 0 && toolong == false) {
+			run(line);
+		} else if (toolong == true) {
+			print("too long\r\n");
+		}
+		linelen = 0;
+		toolong = false;
+		if (more == NULL) {
+			print("> ");
+		}
+	} else if (byte == '\b' || byte == 0x7F) {
+		if (linelen > 0) {
+			linelen--;
+			print("\b \b");
+		}
+	} else if (byte == 0) { // Binary frames follow
+		linelen = 0;
+		toolong = false;
+		provision_start(loggedin());
+	} else if (byte >= ' ' && byte <= '~') {
+		if (linelen < CONSOLE_LINE) {
+			line[linelen++] = (char)byte;
+			print("%c", byte);
+		} else {
+			toolong = true;
+		}
+	}
+}
+
+// Hands received bytes to a provisioning session, up to the end of a frame
+// or of the buffer, then queues its reply. The prompt comes back once the
+// session ends.
+static void frames(uint32_t total)
+{
+	uint32_t at = rxtaken % CONSOLE_RX, len = total - rxtaken, used;
+
+	if (len > CONSOLE_RX - at) {
+		len = CONSOLE_RX - at;
+	}
+	used = provision_take(&rx[at], len);
+	if (used > 0) {
+		loggedin(); // A session keeps the login going
+	}
+	rxtaken += used;
+	stats.received += used;
+	txlen += provision_send(&txbuf[txfill][txlen], room());
+	if (provision_active() == false) {
+		print("\r\n> ");
+	}
+}
+
+// Sets up USART2, its two DMA channels and the RX pin wake-up, then starts
+// receiving
+void console_init(codestore_t *store)
+{
+	codes = store;
+	provision_init(store);
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	// Overrun detection off, so a late main loop loses bytes rather than
+	// stopping reception
+	huart2.Instance = USART2;
+	huart2.Init.BaudRate = CONSOLE_BAUD;
+	huart2.Init.WordLength = UART_WORDLENGTH_8B;
+	huart2.Init.StopBits = UART_STOPBITS_1;
+	huart2.Init.Parity = UART_PARITY_NONE;
+	huart2.Init.Mode = UART_MODE_TX_RX;
+	huart2.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+	huart2.Init.OverSampling = UART_OVERSAMPLING_16;
+	huart2.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+	huart2.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_RXOVERRUNDISABLE_INIT;
+	huart2.AdvancedInit.OverrunDisable = UART_ADVFEATURE_OVERRUN_DISABLE;
+	if (HAL_UART_Init(&huart2) != HAL_OK) {
+		Error_Handler();
+	}
+
+	// DMA1 channel 6, request 2 = USART2_RX, circular into rx
+	hdma_usart2_rx.Instance = DMA1_Channel6;
+	hdma_usart2_rx.Init.Request = DMA_REQUEST_2;
+	hdma_usart2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	hdma_usart2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
+	hdma_usart2_rx.Init.Priority = DMA_PRIORITY_LOW;
+	if (HAL_DMA_Init(&hdma_usart2_rx) != HAL_OK) {
+		Error_Handler();
+	}
+	__HAL_LINKDMA(&huart2, hdmarx, hdma_usart2_rx);
+
+	// DMA1 channel 7, request 2 = USART2_TX, one buffer per transfer
+	hdma_usart2_tx.Instance = DMA1_Channel7;
+	hdma_usart2_tx.Init.Request = DMA_REQUEST_2;
+	hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_usart2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_usart2_tx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_usart2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_usart2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_usart2_tx.Init.Mode = DMA_NORMAL;
+	hdma_usart2_tx.Init.Priority = DMA_PRIORITY_LOW;
+	if (HAL_DMA_Init(&hdma_usart2_tx) != HAL_OK) {
+		Error_Handler();
+	}
+	__HAL_LINKDMA(&huart2, hdmatx, hdma_usart2_tx);
+
+	HAL_NVIC_SetPriority(DMA1_Channel6_IRQn, 2, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+	HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 2, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+	HAL_NVIC_SetPriority(USART2_IRQn, 2, 0);
+	HAL_NVIC_EnableIRQ(USART2_IRQn);
+
+	// Line 3 follows PA3 (EXTICR1 resets to port A) on a falling edge, the
+	// start bit. It stays masked until console_sleep() arms it.
+	EXTI->FTSR1 |= EXTI_FTSR1_FT3;
+	HAL_NVIC_SetPriority(EXTI3_IRQn, 2, 0);
+	HAL_NVIC_EnableIRQ(EXTI3_IRQn);
+
+	lastrx = HAL_GetTick() - CONSOLE_AWAKE_MS; // Nobody has typed yet, Stop 2 may start once the banner is out
+	receive();
+	print("\r\nDigital Lock console, help for commands\r\n> ");
+	flush();
+}
+
+// Takes what the DMA received and runs complete lines, then carries on with
+// long output. Input waits while output is pending or a buffer lacks room
+// for a reply.
+void console_poll(void)
+{
+	uint32_t total;
+
+	posted = false;
+	if (codes == NULL) {
+		return;
+	}
+	if (rxlost == true) {
+		rxlost = false;
+		rxtaken = rxtotal;
+		linelen = 0;
+	}
+	total = rxtotal;
+	if (total - rxtaken > CONSOLE_RX) { // Written over before it was read
+		stats.overruns += total - rxtaken - CONSOLE_RX;
+		rxtaken = total - CONSOLE_RX;
+	}
+	while (rxtaken != total && more == NULL && room() >= CONSOLE_REPLY) {
+		if (provision_active() == true) {
+			frames(total);
+			continue;
+		}
+		take(rx[rxtaken % CONSOLE_RX]);
+		rxtaken++;
+		stats.received++;
+	}
+	txlen += provision_send(&txbuf[txfill][txlen], room());
+	if (more != NULL && more() == false) {
+		more = NULL;
+		print("> ");
+	}
+	flush();
+}
+
+// Checks whether Stop 2 would cut the console off. When it would not, the RX
+// pin is armed so a start bit wakes the core.
+bool console_sleep(void)
+{
+	if (codes == NULL) {
+		return true;
+	}
+	if (sending == true || posted == true || HAL_GetTick() - lastrx < CONSOLE_AWAKE_MS) {
+		return false;
+	}
+	EXTI->PR1 = EXTI_PR1_PIF3;
+	EXTI->IMR1 |= EXTI_IMR1_IM3;
+	return true;
+}
+
+// Start bit out of Stop 2, the byte is lost but the ones after it are not
+void console_wake(void)
+{
+	EXTI->IMR1 &= ~EXTI_IMR1_IM3;
+	lastrx = HAL_GetTick();
+	stats.wakes++;
+}
+
+// Returns the console figures
+const console_stats_t *console_stats(void)
+{
+	return &stats;
+}
+
+// Reception reached the half or end of the buffer, or the line went idle.
+// Half and end events come at least every half buffer, so the distance from
+// the last position is never ambiguous.
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	if (huart->Instance != USART2) {
+		return;
+	}
+	rxtotal += (uint16_t)(Size + CONSOLE_RX - rxlast) % CONSOLE_RX;
+	rxlast = Size % CONSOLE_RX;
+	lastrx = HAL_GetTick();
+	post();
+}
+
+// A buffer went out, the main loop sends the other one
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if (huart->Instance != USART2) {
+		return;
+	}
+	sending = false;
+	post();
+}
+
+// Framing or noise errors leave reception running. Anything that stopped it
+// restarts it, and what was pending is dropped.
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	if (huart->Instance != USART2) {
+		return;
+	}
+	stats.errors++;
+	if (huart->RxState == HAL_UART_STATE_READY) {
+		rxtotal = (rxtotal + CONSOLE_RX - 1) & ~(uint32_t)(CONSOLE_RX - 1); // Buffer start again
+		receive();
+		rxlost = true;
+		post();
+	}
+	if (huart->gState == HAL_UART_STATE_READY && sending == true) {
+		sending = false;
+		post();
+	}
+}
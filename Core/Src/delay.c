@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * @file           : delay.c
+  * @brief          : Busy-wait delays timed by the DWT cycle counter.
+  *                   CYCCNT counts core clock cycles, so a delay is exact
+  *                   whatever the optimisation level and follows
+  *                   SystemCoreClock when the clock changes. The count is
+  *                   compared as an unsigned difference, which stays right
+  *                   across the 2^32 wrap (53 s at 80 MHz).
+  ******************************************************************************
+  */
+
+// Includes
+#include "delay.h"
+
+#define CHUNK_MS 1000 // Longest single count, well inside the wrap at any clock
+
+static uint32_t overhead = 0; // Call and loop exit cycles, from delay_calibrate()
+static delay_report_t report;
+
+// Core clock in MHz, the divisions stay 32-bit
+static uint32_t mhz(void)
+{
+	return SystemCoreClock / 1000000;
+}
+
+// Enables the trace block and starts CYCCNT from zero
+void delay_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+// Spins until CYCCNT has moved on by cycles (weak so the host simulator can swap in virtual time)
+__weak void delay_cycles(uint32_t cycles)
+{
+	uint32_t start = DWT->CYCCNT;
+
+	cycles = cycles > overhead ? cycles - overhead : 0;
+	while ((DWT->CYCCNT - start) < cycles) {
+	}
+}
+
+// Waits at least ns nanoseconds, for delays under 1 ms
+void delay_ns(uint32_t ns)
+{
+	delay_cycles((ns * mhz() + 999) / 1000);
+}
+
+// Waits at least us microseconds
+void delay_us(uint32_t us)
+{
+	delay_cycles(us * mhz());
+}
+
+// Waits at least ms milliseconds
+void delay_ms(uint32_t ms)
+{
+	while (ms > CHUNK_MS) {
+		delay_cycles(CHUNK_MS * 1000 * mhz());
+		ms -= CHUNK_MS;
+	}
+	delay_cycles(ms * 1000 * mhz());
+}
+
+// Times a spread of delays against CYCCNT with interrupts masked. The cost
+// of a bare call is taken off every later delay, then each point is
+// measured again to show what is left.
+const delay_report_t *delay_calibrate(void)
+{
+	static const uint32_t points[DELAY_POINTS] = {100, 1000, 10000, 100000, 1000000};
+	uint32_t primask = __get_PRIMASK();
+	uint32_t start, reads;
+
+	__disable_irq();
+	overhead = 0;
+
+	// Cost of reading CYCCNT twice in a row, not part of any delay
+	start = DWT->CYCCNT;
+	reads = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	delay_cycles(0);
+	report.overhead = DWT->CYCCNT - start - reads;
+	report.clock = SystemCoreClock;
+	overhead = report.overhead;
+
+	for (int i = 0; i < DELAY_POINTS; i++) {
+		start = DWT->CYCCNT;
+		delay_ns(points[i]);
+		report.asked[i] = points[i];
+		report.took[i] = (DWT->CYCCNT - start - reads) * 1000 / mhz();
+	}
+	__set_PRIMASK(primask);
+	return &report;
+}
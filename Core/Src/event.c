@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file           : event.c
+  * @brief          : Event queue feeding the run-to-completion main loop.
+  *                   Interrupts post timer and comms events; the main loop
+  *                   takes them one at a time, runs each to completion and
+  *                   sleeps when none are left. The loop times every event,
+  *                   so the worst case handling time is kept per type.
+  ******************************************************************************
+  */
+
+// Includes
+#include "event.h"
+
+static volatile event_t queue[EVENT_QUEUE];
+static volatile uint8_t head = 0, tail = 0;
+static event_stats_t stats;
+
+// Adds an event from any context, dropping it if the queue is full
+bool event_post(uint8_t type, uint8_t arg)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint8_t next, depth;
+	bool posted = false;
+
+	__disable_irq();
+	next = (head + 1) & (EVENT_QUEUE - 1);
+	if (next == tail) {
+		stats.dropped++;
+	} else {
+		queue[head].type = type;
+		queue[head].arg = arg;
+		head = next;
+		depth = (head - tail) & (EVENT_QUEUE - 1);
+		if (depth > stats.depth) {
+			stats.depth = depth;
+		}
+		posted = true;
+	}
+	__set_PRIMASK(primask);
+	return posted;
+}
+
+// Takes the oldest event, main loop only
+bool event_get(event_t *ev)
+{
+	if (tail == head) {
+		return false;
+	}
+	ev->type = queue[tail].type;
+	ev->arg = queue[tail].arg;
+	tail = (tail + 1) & (EVENT_QUEUE - 1);
+	return true;
+}
+
+// Records the handling time of an event
+void event_done(const event_t *ev, uint32_t cycles)
+{
+	stats.handled++;
+	stats.last = cycles;
+	if (cycles > stats.max) {
+		stats.max = cycles;
+		stats.maxtype = ev->type;
+	}
+	if (ev->type < EVENT_TYPES && cycles > stats.maxof[ev->type]) {
+		stats.maxof[ev->type] = cycles;
+	}
+}
+
+// Returns the queue and handling time figures
+const event_stats_t *event_stats(void)
+{
+	return &stats;
+}
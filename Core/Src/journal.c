@@ -0,0 +1,526 @@
+/**
+  ******************************************************************************
+  * @file           : journal.c
+  * @brief          : Codes kept in internal flash as an append-only journal.
+  *                   A ring of JOURNAL_PAGES pages at the end of bank 2 is
+  *                   split into segments of JOURNAL_SEGMENT_PAGES pages.
+  *                   Each change to the codes appends one double-word record
+  *                   to the active segment. When it fills, the next segment
+  *                   in the ring is erased and opened with a snapshot of the
+  *                   codes (one record per stored code) ended by a commit
+  *                   record. Segments are reused in turn,
+  *                   so erases spread evenly over the ring, and the older
+  *                   segment stays intact until the snapshot has committed,
+  *                   so losing power at any point keeps either the old or
+  *                   the new codes. Boot reads the segment headers and
+  *                   replays the newest committed segment only, so mount
+  *                   time is bounded by one segment however many records
+  *                   were ever written.
+  *                   The ring is in bank 2 and the code runs from bank 1,
+  *                   so erasing and programming do not stall instruction
+  *                   fetch. Changes are queued and written one operation at
+  *                   a time with the interrupt-driven HAL calls; the flash
+  *                   interrupt flags each completion and the main loop starts
+  *                   the next, as the HAL stays locked inside its callbacks.
+  *                   A snapshot reads the codes as it goes while the UI keeps
+  *                   changing them. That is safe because every change is
+  *                   still queued behind the commit, and replaying an add,
+  *                   remove or clear over a state that already has it changes
+  *                   nothing. The one change it cannot see past is a removal
+  *                   shifting a code back over the slots already copied, so
+  *                   the snapshot starts over if one did. Changes still
+  *                   queued when power is lost are lost with it.
+  *                   Bulk enrollment writes its adds in batches: they wait
+  *                   in the queue, unless the flash is already busy, until
+  *                   JOURNAL_BATCH have gathered or the batch is committed,
+  *                   then go out back to back ended by one commit record. Boot applies a
+  *                   batch only when its commit is there, so a batch cut
+  *                   short by power loss is lost whole.
+  ******************************************************************************
+  */
+
+// Includes
+#include "journal.h"
+
+#define MAGIC 0x4C4E524Au // "JRNL", low word of a segment header
+#define ERASED 0xFFFFFFFFFFFFFFFFull
+#define SEGMENT_BYTES (JOURNAL_SEGMENT_PAGES * JOURNAL_PAGE)
+
+// Records: 48 bits of data, then the type and a CRC-8 of the other 7 bytes
+#define REC_CODE 1 // Snapshot, data = a stored key
+#define REC_COMMIT 2 // Snapshot complete, data = segment sequence << 16 | codes stored;
+                     // after the snapshot, a batch complete, data = REC_BATCH records before it
+#define REC_ADD 3 // data = key
+#define REC_REMOVE 4 // data = key
+#define REC_CLEAR 5 // data = key kept, CODESTORE_NONE for none
+#define REC_BATCH 6 // data = key, added once the commit after it is in
+
+#if CODESTORE_CAPACITY + 2 > JOURNAL_RECORDS
+#error "A segment must hold a full snapshot"
+#endif
+
+typedef enum {
+	STEP_IDLE,
+	STEP_APPEND, // Programming the record at the queue head
+	STEP_ERASE, // Erasing the segment a snapshot goes into
+	STEP_SNAPSHOT // Programming the header, codes and commit
+} step_t;
+
+static codestore_t *codes = NULL; // Codes the journal mirrors
+static int active = -1; // Segment being appended to, -1 until one is written
+static uint32_t position = 0; // Next free record in it
+static uint32_t sequence = 0; // Its sequence number, newer segments count up
+static uint64_t queue[JOURNAL_QUEUE]; // Records waiting for the flash
+static uint8_t head = 0, queued = 0;
+static bool batching = false; // Between journal_begin() and journal_commit()
+static uint8_t batched = 0; // REC_BATCH records queued since the last batch commit
+static bool snapshot = false; // Records were dropped or a segment went bad, open a new one
+static bool stalled = false; // A snapshot failed, wait for the next change to retry
+static step_t step = STEP_IDLE;
+static int target; // Segment the snapshot goes into
+static uint32_t slot; // Next record in it
+static int entry; // Next table slot to copy, -1 for the header
+static uint32_t moves; // The store's moves when the snapshot began
+static volatile bool done = false; // Set by the flash interrupt
+static volatile bool failed = false;
+static journal_stats_t stats;
+
+// Records of a segment as they read from flash
+static const volatile uint64_t *segment(int s)
+{
+	return (const volatile uint64_t *)(uintptr_t)(JOURNAL_BASE + (uint32_t)s * SEGMENT_BYTES);
+}
+
+// CRC-8 (polynomial 0x07) of the 7 bytes above the check byte
+static uint8_t crc8(uint64_t rec)
+{
+	uint8_t crc = 0;
+
+	for (int i = 8; i < 64; i += 8) {
+		crc ^= (uint8_t)(rec >> i);
+		for (int b = 0; b < 8; b++) {
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static uint64_t pack(uint8_t type, uint64_t data)
+{
+	uint64_t rec = (data << 16) | ((uint32_t)type << 8);
+
+	return rec | crc8(rec);
+}
+
+// Checks a record was written in full
+static bool intact(uint64_t rec)
+{
+	uint8_t type = (uint8_t)(rec >> 8);
+
+	return rec != ERASED && type >= REC_CODE && type <= REC_BATCH && (uint8_t)rec == crc8(rec);
+}
+
+// Starts writing one double-word, the interrupt reports how it went
+static void program(int s, uint32_t at, uint64_t rec)
+{
+	uint32_t addr = JOURNAL_BASE + (uint32_t)s * SEGMENT_BYTES + at * 8;
+
+	if (HAL_FLASH_Program_IT(FLASH_TYPEPROGRAM_DOUBLEWORD, addr, rec) != HAL_OK) {
+		failed = true;
+		done = true;
+	}
+}
+
+// Starts erasing the pages of one segment
+static void erase(int s)
+{
+	FLASH_EraseInitTypeDef init;
+
+	init.TypeErase = FLASH_TYPEERASE_PAGES;
+	init.Banks = FLASH_BANK_2;
+	init.Page = JOURNAL_FIRST_PAGE + (uint32_t)s * JOURNAL_SEGMENT_PAGES;
+	init.NbPages = JOURNAL_SEGMENT_PAGES;
+	if (HAL_FLASHEx_Erase_IT(&init) != HAL_OK) {
+		failed = true;
+		done = true;
+	}
+}
+
+static void start(void);
+
+// Programs the next record of the snapshot: header, the code in each used
+// slot, then the commit. Slots are read as they go out; if a removal moved
+// codes meanwhile, the segment is erased and the snapshot taken again.
+static void snapshotnext(void)
+{
+	if (entry < 0) {
+		moves = codes->moves;
+		program(target, slot, ((uint64_t)(sequence + 1) << 32) | MAGIC);
+		return;
+	}
+	while (entry < (int)CODESTORE_SLOTS && codes->slots[entry] == CODESTORE_NONE) {
+		entry++;
+	}
+	if (entry < (int)CODESTORE_SLOTS) {
+		program(target, slot, pack(REC_CODE, codes->slots[entry]));
+	} else if (codes->moves != moves) {
+		snapshot = true;
+		start();
+	} else {
+		program(target, slot, pack(REC_COMMIT, ((uint64_t)(sequence + 1) << 16) | codestore_total(codes)));
+	}
+}
+
+// Starts the next flash operation, or locks the flash when there is none.
+// A full or bad segment is replaced by a snapshot first; the queued records
+// follow it.
+static void start(void)
+{
+	if (stalled == true || (queued == 0 && snapshot == false)) {
+		step = STEP_IDLE;
+		HAL_FLASH_Lock();
+		return;
+	}
+	HAL_FLASH_Unlock();
+	__HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+	if (snapshot == true || active < 0 || position >= JOURNAL_RECORDS) {
+		snapshot = false; // Anything dropped from here on needs another one
+		target = (active + 1) % JOURNAL_SEGMENTS;
+		step = STEP_ERASE;
+		erase(target);
+	} else {
+		step = STEP_APPEND;
+		program(active, position, queue[head]);
+	}
+}
+
+// Queues one change and gets the flash going if it is idle, unless it is an
+// add held for its batch commit. A full queue is dropped, since a snapshot
+// taken after it has every change in it, except the record being programmed,
+// which journal_poll() still takes off the head when it is done.
+static bool append(uint8_t type, codestore_key_t key)
+{
+	if (codes == NULL) {
+		return false;
+	}
+	if (queued == JOURNAL_QUEUE) {
+		queued = step == STEP_APPEND ? 1 : 0;
+		snapshot = true;
+		stats.overflows++;
+	} else {
+		queue[(head + queued) % JOURNAL_QUEUE] = pack(type, key);
+		queued++;
+		if (queued > stats.depth) {
+			stats.depth = queued;
+		}
+	}
+	stalled = false;
+	if (step == STEP_IDLE && type != REC_BATCH) {
+		start();
+	}
+	return true;
+}
+
+// Queues the commit for the adds held since the last one, which sets them writing
+static void seal(void)
+{
+	uint8_t n = batched;
+
+	if (n > 0) {
+		batched = 0;
+		append(REC_COMMIT, n);
+	}
+}
+
+// Flash operation completed, from the HAL interrupt handler. Erases report
+// each page; only the last one ends the operation.
+void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+	if (step == STEP_ERASE && ReturnValue != 0xFFFFFFFFU) {
+		return;
+	}
+	done = true;
+}
+
+void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+	failed = true;
+	done = true;
+}
+
+// Checks whether the flash interrupt has left work for journal_poll()
+bool journal_ready(void)
+{
+	return done;
+}
+
+// Takes the result of the finished operation and starts the next one
+void journal_poll(void)
+{
+	bool ok;
+
+	if (done == false) {
+		return;
+	}
+	ok = failed == false;
+	done = false;
+	failed = false;
+
+	if (ok == false) {
+		stats.errors++;
+	}
+	switch (step) {
+		case STEP_APPEND:
+			position++; // A failed slot is left behind either way
+			if (ok == true) {
+				head = (head + 1) % JOURNAL_QUEUE;
+				queued--;
+				stats.records++;
+			} else { // Move on to a clean segment rather than trust this one
+				snapshot = true;
+			}
+			break;
+		case STEP_ERASE:
+		case STEP_SNAPSHOT:
+			if (ok == false) { // The old segment is still the one mounted
+				snapshot = true;
+				stalled = true;
+				break;
+			}
+			if (step == STEP_ERASE) {
+				step = STEP_SNAPSHOT;
+				slot = 0;
+				entry = -1;
+			} else if (entry == (int)CODESTORE_SLOTS) { // Commit is in
+				active = target;
+				position = slot + 1;
+				sequence++;
+				stats.compactions++;
+				break;
+			} else {
+				slot++;
+				entry++;
+			}
+			snapshotnext();
+			return;
+		default:
+			break;
+	}
+	start();
+}
+
+// Checks whether a flash operation is still running
+bool journal_busy(void)
+{
+	return step != STEP_IDLE;
+}
+
+// Reads record index of the active segment for a log dump. Returns its kind
+// and sets data to the key of a code, add, remove, clear or batch, the count
+// of a commit, or the sequence of the header. NULL past the last record.
+const char *journal_record(uint32_t index, uint64_t *data)
+{
+	static const char *const kinds[] = {"torn", "code", "commit", "add", "remove", "clear", "batch"};
+	uint64_t rec;
+
+	if (active < 0 || index >= JOURNAL_RECORDS) {
+		return NULL;
+	}
+	rec = segment(active)[index];
+	if (rec == ERASED) {
+		return NULL;
+	}
+	if (index == 0) {
+		*data = rec >> 32;
+		return "header";
+	}
+	if (intact(rec) == false) {
+		*data = 0;
+		return kinds[0];
+	}
+	*data = (uint8_t)(rec >> 8) == REC_COMMIT ? (rec >> 16) & 0xFFFF : rec >> 16;
+	return kinds[(uint8_t)(rec >> 8)];
+}
+
+// Rebuilds the codes from one segment, false if its snapshot never committed
+static bool replay(int s, uint32_t seq)
+{
+	const volatile uint64_t *recs = segment(s);
+	bool committed = false;
+	uint32_t index;
+	char code[CODESTORE_MAX + 1];
+
+	codestore_clear(codes);
+	for (index = 1; index < JOURNAL_RECORDS; index++) {
+		uint64_t rec = recs[index];
+		uint8_t type = (uint8_t)(rec >> 8);
+		uint64_t data = rec >> 16;
+
+		if (rec == ERASED) { // End of the log
+			break;
+		}
+		if (intact(rec) == false) { // Power lost while it was written
+			stats.torn++;
+			continue;
+		}
+		if (committed == false) {
+			if (type == REC_CODE) {
+				codestore_code(data, code);
+				codestore_add(codes, code);
+			} else if (type == REC_COMMIT && (uint32_t)(data >> 16) == seq) {
+				committed = true;
+			}
+			continue;
+		}
+		switch (type) {
+			case REC_ADD:
+			case REC_REMOVE:
+				codestore_code(data, code);
+				if (type == REC_ADD) {
+					codestore_add(codes, code);
+				} else {
+					codestore_remove(codes, code);
+				}
+				break;
+			case REC_CLEAR:
+				codestore_clear(codes);
+				if (data != CODESTORE_NONE) {
+					codestore_code(data, code);
+					codestore_add(codes, code);
+				}
+				break;
+			case REC_COMMIT: // A batch is in, its adds are the REC_BATCH records just before
+				for (uint32_t back = index - 1, n = (uint32_t)data; n > 0 && back > 0; back--, n--) {
+					uint64_t add = recs[back];
+
+					if (intact(add) == false || (uint8_t)(add >> 8) != REC_BATCH) {
+						break; // Records the commit does not cover, or a batch cut short
+					}
+					codestore_code(add >> 16, code);
+					codestore_add(codes, code);
+				}
+				break;
+		}
+	}
+	stats.mounted += index;
+	if (committed == false) {
+		codestore_clear(codes);
+		return false;
+	}
+	active = s;
+	position = index;
+	sequence = seq;
+	return true;
+}
+
+// Finds the newest segment with a committed snapshot and replays it
+bool journal_mount(codestore_t *store)
+{
+	uint32_t seqs[JOURNAL_SEGMENTS];
+	bool valid[JOURNAL_SEGMENTS];
+
+	codes = store;
+	active = -1;
+	position = 0;
+	sequence = 0;
+	head = 0;
+	queued = 0;
+	batching = false;
+	batched = 0;
+	snapshot = false;
+	stalled = false;
+	step = STEP_IDLE;
+	done = false;
+	failed = false;
+	codestore_clear(codes);
+
+	HAL_NVIC_SetPriority(FLASH_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(FLASH_IRQn);
+
+	for (int s = 0; s < JOURNAL_SEGMENTS; s++) {
+		uint64_t header = segment(s)[0];
+
+		valid[s] = (uint32_t)header == MAGIC;
+		seqs[s] = (uint32_t)(header >> 32);
+	}
+
+	// Newest first, falling back to an older one if a snapshot was cut short
+	for (int tries = 0; tries < JOURNAL_SEGMENTS; tries++) {
+		int newest = -1;
+
+		for (int s = 0; s < JOURNAL_SEGMENTS; s++) {
+			if (valid[s] && (newest < 0 || (int32_t)(seqs[s] - seqs[newest]) > 0)) {
+				newest = s;
+			}
+		}
+		if (newest < 0) {
+			break;
+		}
+		if (replay(newest, seqs[newest]) == true) {
+			return true;
+		}
+		valid[newest] = false;
+
+		// Whatever replaced it must still count up from it
+		if ((int32_t)(seqs[newest] - sequence) > 0) {
+			sequence = seqs[newest];
+		}
+	}
+	return false;
+}
+
+// Records a code added to the store, held for its batch when batching
+bool journal_add(const char *code)
+{
+	codestore_key_t key = codestore_key(code);
+
+	if (key == CODESTORE_NONE) {
+		return false;
+	}
+	if (batching == false) {
+		return append(REC_ADD, key);
+	}
+	if (append(REC_BATCH, key) == false) {
+		return false;
+	}
+	if (++batched == JOURNAL_BATCH) {
+		seal();
+	}
+	return true;
+}
+
+// Records a code removed from the store, after any adds held before it
+bool journal_remove(const char *code)
+{
+	codestore_key_t key = codestore_key(code);
+
+	seal();
+	return key != CODESTORE_NONE && append(REC_REMOVE, key);
+}
+
+// Records the store emptied, with keep the one code left in it
+bool journal_clear(const char *keep)
+{
+	seal();
+	return append(REC_CLEAR, keep != NULL ? codestore_key(keep) : CODESTORE_NONE);
+}
+
+// Starts holding adds for batch commits
+void journal_begin(void)
+{
+	batching = true;
+}
+
+// Commits the adds held so far and goes back to writing each change alone
+void journal_commit(void)
+{
+	seal();
+	batching = false;
+}
+
+// Returns the journal figures
+const journal_stats_t *journal_stats(void)
+{
+	stats.queued = queued;
+	return &stats;
+}
@@ -0,0 +1,313 @@
+/**
+  ******************************************************************************
+  * @file           : keypad.c
+  * @brief          : 4x4 keypad scanned by timers and DMA.
+  *                   While idle all columns are driven high and a press raises
+  *                   a row EXTI. The row interrupts are then masked and the
+  *                   scanner starts: each TIM6 update has DMA1 channel 3 write
+  *                   the next column pattern to GPIOB->BSRR, and TIM7, half a
+  *                   column period behind, has DMA1 channel 4 copy
+  *                   GPIOB->IDR into a circular capture buffer. Each half of
+  *                   that buffer holds KEYPAD_BATCH whole scans; its interrupt
+  *                   runs the debounce pass. The pass packs a scan into one
+  *                   bit per key, straight from the one IDR reading taken
+  *                   with each column driven. Keys down on two rows in each
+  *                   of two columns can also make a key that is up read as
+  *                   down (ghosting), so such a scan is ignored until it clears;
+  *                   a const table flags row readings that share two rows.
+  *                   The pass then steps a 2-bit vertical counter for all
+  *                   16 keys at once: bit 0 of every counter in one word, bit
+  *                   1 in another. A key whose reading differs from its state
+  *                   counts down, one that agrees reloads, and one that has
+  *                   differed for KEYPAD_SAMPLES scans in a row, exactly
+  *                   KEYPAD_DEBOUNCE_MS, flips and is reported. Presses and
+  *                   releases go into a single producer single consumer
+  *                   queue, so keys typed while the application is busy wait
+  *                   there. Once every key is up the scanner stops and the
+  *                   row interrupts are armed again, so Stop 2 is only held
+  *                   off while the pad is in use.
+  ******************************************************************************
+  */
+
+// Includes
+#include "keypad.h"
+
+#define CAPTURE (2 * KEYPAD_BATCH * 4) // Row samples, one per column, in two halves
+
+#if KEYPAD_SAMPLES < 1 || KEYPAD_SAMPLES > 4
+#error "KEYPAD_SAMPLES must fit the 2-bit counters"
+#endif
+
+// Counter reload, KEYPAD_SAMPLES - 1, one word per bit
+#define RELOAD0 (((KEYPAD_SAMPLES - 1) & 1) ? 0xFFFFu : 0u)
+#define RELOAD1 (((KEYPAD_SAMPLES - 1) & 2) ? 0xFFFFu : 0u)
+
+DMA_HandleTypeDef hdma_tim6_up;
+DMA_HandleTypeDef hdma_tim7_up;
+
+// Row readings with two or more rows high
+static const uint8_t several[16] = {0, 0, 0, 1, 0, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1};
+
+// Keys by pad bit, column * 4 + row
+static const unsigned char keymap[16] =
+	{'1', '4', '7', '*',
+	'2', '5', '8', '0',
+	'3', '6', '9', '#',
+	'A', 'B', 'C', 'D'};
+
+static uint32_t drive[4]; // BSRR words in the order TIM6 writes them, columns 1, 2, 3 then 0
+static volatile uint16_t capture[CAPTURE]; // GPIOB->IDR halfway through each column, from column 0
+
+// Single producer (scan interrupt) single consumer (main) queue. Only the
+// producer writes head and only the consumer writes tail, each after the
+// slot it covers, so neither side needs to mask interrupts.
+static volatile unsigned char queue[KEYPAD_QUEUE];
+static volatile uint8_t head = 0, tail = 0;
+static keypad_stats_t stats;
+
+// Debounce state, touched only by the scan interrupt, bit per key
+static uint16_t state = 0; // Keys down as reported
+static uint16_t count0 = RELOAD0, count1 = RELOAD1; // Scans left before each key may flip, low and high bits
+static uint8_t quiet = 0; // Scans in a row with every key open
+static volatile bool scanning = false;
+
+// BSRR word driving one column high and the others low
+static uint32_t column(int col)
+{
+	uint32_t pin = GPIO_PIN_1 << col;
+
+	return ((KEYPAD_COLS & ~pin) << 16) | pin;
+}
+
+// Drives one column and starts both timers, TIM6 a whole column period from
+// its next write and TIM7 half of one from its first read
+static void startscan(void)
+{
+	scanning = true;
+	count0 = RELOAD0;
+	count1 = RELOAD1;
+	quiet = 0;
+	GPIOB->BSRR = column(0);
+	HAL_DMA_Start(&hdma_tim6_up, (uint32_t)drive, (uint32_t)&GPIOB->BSRR, 4);
+	HAL_DMA_Start_IT(&hdma_tim7_up, (uint32_t)&GPIOB->IDR, (uint32_t)capture, CAPTURE);
+	TIM6->CNT = 0;
+	TIM7->CNT = (TIM7->ARR + 1) / 2;
+	TIM6->CR1 = TIM_CR1_CEN;
+	TIM7->CR1 = TIM_CR1_CEN;
+}
+
+// Re-enables the row interrupts, catching a press that came while masked
+static void armrows(void)
+{
+	__HAL_GPIO_EXTI_CLEAR_IT(KEYPAD_ROWS);
+	EXTI->IMR1 |= KEYPAD_ROWS;
+	if ((GPIOB->IDR & KEYPAD_ROWS) != 0) {
+		EXTI->IMR1 &= ~KEYPAD_ROWS;
+		startscan();
+	}
+}
+
+// Every key is up, idle the columns high and wait for the next edge
+static void stopscan(void)
+{
+	TIM6->CR1 = 0;
+	TIM7->CR1 = 0;
+	HAL_DMA_Abort(&hdma_tim6_up);
+	HAL_DMA_Abort(&hdma_tim7_up);
+	GPIOB->BSRR = KEYPAD_COLS;
+	scanning = false;
+	armrows();
+}
+
+// Adds an event to the queue, dropping it if the application has fallen behind
+static void push(unsigned char event)
+{
+	uint8_t next = (head + 1) & (KEYPAD_QUEUE - 1);
+
+	if (next == tail) {
+		stats.dropped++;
+		return;
+	}
+	queue[head] = event;
+	__DMB(); // Slot written before the consumer can see it
+	head = next;
+}
+
+// Packs one scan into a bit per key and looks for a rectangle of keys down,
+// two columns sharing two rows, where one of them may be a ghost
+uint16_t keypad_decode(const volatile uint16_t *samples, bool *ghost)
+{
+	uint8_t rows[4], shared = 0;
+	uint16_t pad = 0;
+
+	for (int col = 0; col < 4; col++) {
+		rows[col] = (uint8_t)((samples[col] & KEYPAD_ROWS) >> KEYPAD_ROW_SHIFT);
+		pad |= (uint16_t)(rows[col] << (4 * col));
+		for (int other = 0; other < col; other++) {
+			shared |= several[rows[col] & rows[other]];
+		}
+	}
+	*ghost = shared != 0;
+	return pad;
+}
+
+// Debounce pass over one scan of row samples
+static void debounce(const volatile uint16_t *samples)
+{
+	uint16_t pad, delta, flip, reload, borrow;
+	bool ghost;
+
+	pad = keypad_decode(samples, &ghost);
+	stats.scans++;
+	quiet = pad != 0 ? 0 : quiet + (quiet < KEYPAD_SAMPLES);
+	if (ghost) { // Hold what was reported until the pad reads unambiguously
+		stats.ghosts++;
+		pad = state;
+	}
+
+	// Keys at 0 that still differ flip; the rest count down or reload
+	delta = pad ^ state;
+	flip = delta & ~(count0 | count1);
+	reload = ~delta | flip;
+	borrow = ~count0;
+	count0 = (reload & RELOAD0) | (~reload & ~count0);
+	count1 = (reload & RELOAD1) | (~reload & (count1 ^ borrow));
+	state ^= flip;
+
+	// Report each key that went down or came up
+	for (int bit = 0; flip != 0; bit++, flip >>= 1) {
+		if (flip & 1) {
+			push(keymap[bit] | ((state & (1u << bit)) ? 0 : KEYPAD_RELEASED));
+		}
+	}
+}
+
+// Half of the capture buffer is full
+static void captured(const volatile uint16_t *half)
+{
+	for (int scan = 0; scan < KEYPAD_BATCH; scan++) {
+		debounce(half + 4 * scan);
+	}
+	if (state == 0 && quiet >= KEYPAD_SAMPLES) {
+		stopscan();
+	}
+}
+
+static void firsthalf(DMA_HandleTypeDef *hdma)
+{
+	captured(capture);
+}
+
+static void secondhalf(DMA_HandleTypeDef *hdma)
+{
+	captured(capture + CAPTURE / 2);
+}
+
+// Sets up the scan timers and DMA, then idles the columns high
+void keypad_init(void)
+{
+	__HAL_RCC_TIM6_CLK_ENABLE();
+	__HAL_RCC_TIM7_CLK_ENABLE();
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	for (int col = 0; col < 4; col++) {
+		drive[col] = column((col + 1) & 3);
+	}
+
+	// TIM6 and TIM7 count microseconds and wrap once per column, raising a
+	// DMA request at each update
+	TIM6->CR1 = 0;
+	TIM7->CR1 = 0;
+	TIM6->PSC = TIM7->PSC = SystemCoreClock / 1000000 - 1;
+	TIM6->ARR = TIM7->ARR = KEYPAD_COLUMN_US - 1;
+	TIM6->EGR = TIM_EGR_UG;
+	TIM7->EGR = TIM_EGR_UG;
+	TIM6->SR = TIM7->SR = 0;
+	TIM6->DIER = TIM_DIER_UDE;
+	TIM7->DIER = TIM_DIER_UDE;
+
+	// DMA1 channel 3, request 6 = TIM6_UP, column patterns to GPIOB->BSRR
+	hdma_tim6_up.Instance = DMA1_Channel3;
+	hdma_tim6_up.Init.Request = DMA_REQUEST_6;
+	hdma_tim6_up.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_tim6_up.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_tim6_up.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_tim6_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+	hdma_tim6_up.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+	hdma_tim6_up.Init.Mode = DMA_CIRCULAR;
+	hdma_tim6_up.Init.Priority = DMA_PRIORITY_MEDIUM;
+	if (HAL_DMA_Init(&hdma_tim6_up) != HAL_OK) {
+		Error_Handler();
+	}
+
+	// DMA1 channel 4, request 5 = TIM7_UP, GPIOB->IDR to the capture buffer
+	hdma_tim7_up.Instance = DMA1_Channel4;
+	hdma_tim7_up.Init.Request = DMA_REQUEST_5;
+	hdma_tim7_up.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	hdma_tim7_up.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_tim7_up.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_tim7_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+	hdma_tim7_up.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+	hdma_tim7_up.Init.Mode = DMA_CIRCULAR;
+	hdma_tim7_up.Init.Priority = DMA_PRIORITY_MEDIUM;
+	if (HAL_DMA_Init(&hdma_tim7_up) != HAL_OK) {
+		Error_Handler();
+	}
+	hdma_tim7_up.XferHalfCpltCallback = firsthalf;
+	hdma_tim7_up.XferCpltCallback = secondhalf;
+	HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+
+	state = 0;
+	scanning = false;
+	GPIOB->BSRR = KEYPAD_COLS;
+	armrows();
+}
+
+// Takes the oldest queued event
+bool keypad_getevent(unsigned char *event)
+{
+	if (tail == head) {
+		return false;
+	}
+	*event = queue[tail];
+	__DMB(); // Slot read before the producer can reuse it
+	tail = (tail + 1) & (KEYPAD_QUEUE - 1);
+	return true;
+}
+
+// Takes the oldest queued press
+bool keypad_getkey(unsigned char *key)
+{
+	unsigned char event;
+
+	while (keypad_getevent(&event) == true) {
+		if ((event & KEYPAD_RELEASED) == 0) {
+			*key = event;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Returns true while the pad is being scanned
+bool keypad_busy(void)
+{
+	return scanning;
+}
+
+// Returns the scan, ghost and dropped event counts
+const keypad_stats_t *keypad_stats(void)
+{
+	return &stats;
+}
+
+// Row edge, scan until every key is up again
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	if ((GPIO_Pin & KEYPAD_ROWS) == 0) {
+		return;
+	}
+	EXTI->IMR1 &= ~KEYPAD_ROWS;
+	startscan();
+}
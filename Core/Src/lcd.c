@@ -0,0 +1,505 @@
+/**
+  ******************************************************************************
+  * @file           : lcd.c
+  * @brief          : LCD shadow framebuffer and transport over SPI1 and DMA.
+  *                   The Write_*_LCD calls only draw into a RAM copy of the
+  *                   DDRAM. lcd_flush() compares it with what the controller
+  *                   holds and sends just the changed cells, moving the
+  *                   address only where a run of changes is broken, so a
+  *                   clear and redraw of a similar screen costs a few bytes.
+  *                   Instructions and characters only go into a ring of
+  *                   controller bytes, so a caller returns as soon as they
+  *                   are queued. The DMA complete interrupt drains the ring,
+  *                   splitting each byte into the nibbles, RS and EN the
+  *                   shift register carries, into a buffer it then sends.
+  *                   Static screens skip that: Tools/lcd_streams.c builds
+  *                   the bytes for each one ahead of time, every visible
+  *                   cell line by line, and when most cells change
+  *                   lcd_show() queues the screen so DMA sends them
+  *                   straight from flash, for no CPU work at all. A screen
+  *                   close to the one shown sends just the cells that
+  *                   differ.
+  *                   TIM1 paces the send at
+  *                   one byte per LCD_SLOT_US: each wrap matches CH1's compare
+  *                   at 0, whose DMA request writes the next byte to SPI1
+  *                   (SCK PA5, MOSI PB5), and
+  *                   CH3 in PWM mode 2 raises the latch on PA10 half a slot
+  *                   later, once the byte is in. Controller execution times
+  *                   (37 us, 1.52 ms for clear and home) are covered by
+  *                   repeating the last byte, so the CPU never waits on the
+  *                   display; a writer only sleeps when the ring is full.
+  ******************************************************************************
+  */
+
+// Includes
+#include "lcd.h"
+#include "string.h"
+
+DMA_HandleTypeDef hdma_tim1_ch1;
+
+// Ring entries: an instruction is its code alone, the rest are flagged
+#define LCD_DATA 0x100 // Character
+#define LCD_RAW 0x200 // Shift register byte sent as it is
+#define LCD_HOLD 0x400 // Slots to repeat the last byte for
+#define LCD_STREAM 0x800 // Prebuilt screen, sent as it is
+
+static uint16_t ring[LCD_QUEUE];
+static volatile uint16_t head = 0, tail = 0;
+static uint8_t buffer[LCD_BUFFER + 1]; // + 1 for the trailing slot
+static volatile bool sending = false;
+static uint8_t last = 0; // Most recently sent byte
+static uint16_t holding = 0; // Repeats of it still owed, carried between buffers
+
+// Transport slots taken by one instruction or character (4 nibble bytes
+// then the hold), and by a clear
+#define LCD_BYTE_SLOTS (4 + LCD_SHORT_SLOTS)
+#define LCD_CLEAR_SLOTS (4 + LCD_LONG_SLOTS)
+
+static char shadow[LCD_CELLS]; // What the firmware has drawn
+static char shown[LCD_CELLS]; // What the controller holds
+static uint8_t cursor = 0; // Shadow address counter, cell index 0-79
+static uint8_t address = 0; // Controller address counter
+static bool cursoron = false; // Cursor or blink shown, so its position matters
+static bool dirty = false; // Shadow written since the last flush
+static uint16_t count = 0; // Controller bytes sent by the current flush
+static lcd_stats_t stats;
+
+// Fills the buffer from the ring, a controller byte at a time, then the
+// repeats that give it its execution time
+static uint16_t expand(void)
+{
+	uint16_t len = 0;
+
+	while (len < LCD_BUFFER) {
+		if (holding > 0) {
+			buffer[len++] = last;
+			holding--;
+		} else if (tail == head || (ring[tail] & LCD_STREAM)) {
+			break;
+		} else if (ring[tail] & LCD_HOLD) {
+			holding = ring[tail] & 0xFF;
+			tail = (tail + 1) & (LCD_QUEUE - 1);
+		} else if (ring[tail] & LCD_RAW) {
+			buffer[len++] = last = (uint8_t)ring[tail];
+			tail = (tail + 1) & (LCD_QUEUE - 1);
+		} else if (len + 4 <= LCD_BUFFER) {
+			uint8_t code = (uint8_t)ring[tail], rs = (ring[tail] & LCD_DATA) ? 0x01 : 0x00;
+
+			buffer[len++] = (code & 0xF0) | rs | 0x02; // EN high, then low to clock the nibble in
+			buffer[len++] = (code & 0xF0) | rs;
+			buffer[len++] = (uint8_t)(code << 4) | rs | 0x02;
+			buffer[len++] = last = (uint8_t)(code << 4) | rs;
+			holding = (rs == 0 && code <= 0x03) ? LCD_LONG_SLOTS : LCD_SHORT_SLOTS; // Clear and home take longer
+			tail = (tail + 1) & (LCD_QUEUE - 1);
+		} else {
+			break;
+		}
+	}
+	return len;
+}
+
+// Sends the next buffer's worth from the ring, or a prebuilt screen once it
+// is next, interrupts masked
+static void send(void)
+{
+	const uint8_t *from = buffer;
+	uint16_t len = expand();
+
+	if (len > 0) {
+		// DMA completes as the final byte goes out, one slot before its latch,
+		// so a copy of it follows to keep TIM1 running until then
+		buffer[len] = buffer[len - 1];
+		len++;
+		stats.composed += len;
+	} else if (tail != head) { // Only a screen stops expand() short, its trailing slot is built in
+		const lcd_screen_t *screen = &lcd_screens[ring[tail] & 0xFF];
+
+		from = screen->bytes;
+		len = screen->length;
+		last = from[len - 1];
+		tail = (tail + 1) & (LCD_QUEUE - 1);
+		stats.streamed += len;
+	} else {
+		sending = false;
+		return;
+	}
+
+	sending = true;
+	HAL_DMA_Start_IT(&hdma_tim1_ch1, (uint32_t)from, (uint32_t)&SPI1->DR, len);
+	TIM1->CNT = 0;
+	TIM1->CR1 |= TIM_CR1_CEN;
+}
+
+// Buffer latched, stop pacing and go on with whatever the ring holds
+static void sent(DMA_HandleTypeDef *hdma)
+{
+	TIM1->CR1 &= ~TIM_CR1_CEN;
+	send();
+}
+
+// Queues one ring entry, sleeping only if the ring is full
+static void queue(uint16_t entry)
+{
+	uint16_t next, depth;
+
+	__disable_irq();
+	next = (head + 1) & (LCD_QUEUE - 1);
+	if (next == tail) {
+		stats.stalls++;
+	}
+	while (next == tail) {
+		__WFI();
+		__enable_irq();
+		__disable_irq();
+	}
+	ring[head] = entry;
+	head = next;
+	depth = (head - tail) & (LCD_QUEUE - 1);
+	if (depth > stats.depth) {
+		stats.depth = depth;
+	}
+	if (sending == false) {
+		send();
+	}
+	__enable_irq();
+}
+
+// Queues one instruction for the controller
+static void instr(uint8_t code)
+{
+	queue(code);
+	count++;
+}
+
+// Queues one character for the controller
+static void data(uint8_t code)
+{
+	queue(LCD_DATA | code);
+	count++;
+}
+
+// Converts a cell index to its DDRAM address (line 2 starts at 0x40)
+static uint8_t ddram(uint8_t cell)
+{
+	return cell < LCD_LINE ? cell : 0x40 + cell - LCD_LINE;
+}
+
+// Converts a DDRAM address to its cell index
+static uint8_t cell(uint8_t addr)
+{
+	return addr >= 0x40 ? LCD_LINE + (addr - 0x40) % LCD_LINE : addr % LCD_LINE;
+}
+
+// Sets up the shift register transport and runs the controller reset
+void lcd_init(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	__HAL_RCC_GPIOB_CLK_ENABLE();
+	__HAL_RCC_SPI1_CLK_ENABLE();
+	__HAL_RCC_TIM1_CLK_ENABLE();
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	/*Configure LCD GPIO pins : PA5 (SPI1_SCK) + PB5 (SPI1_MOSI)*/
+	GPIO_InitStruct.Pin = GPIO_PIN_5;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+	GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+	HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+	/*Configure LCD GPIO pin : PA10 (TIM1_CH3, latch)*/
+	GPIO_InitStruct.Pin = GPIO_PIN_10;
+	GPIO_InitStruct.Alternate = GPIO_AF1_TIM1;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+	// SPI1: transmit-only master, mode 0, MSB first, 8-bit, PCLK2/8 = 10 MHz
+	SPI1->CR1 = SPI_CR1_BIDIMODE | SPI_CR1_BIDIOE | SPI_CR1_SSM | SPI_CR1_SSI |
+		SPI_CR1_BR_1 | SPI_CR1_MSTR;
+	SPI1->CR2 = (7 << SPI_CR2_DS_Pos);
+	SPI1->CR1 |= SPI_CR1_SPE;
+
+	// TIM1: one slot per period, DMA request on the CH1 compare at the wrap,
+	// latch pulse on CH3. TIM1_UP would take DMA1 channel 6, which USART2_RX
+	// needs for the console.
+	TIM1->CR1 = 0;
+	TIM1->PSC = 0;
+	TIM1->ARR = SystemCoreClock / 1000000 * LCD_SLOT_US - 1;
+	TIM1->CCR1 = 0;
+	TIM1->CCR3 = (TIM1->ARR + 1) / 2; // 8 bits at 10 MHz take 0.8 us
+	TIM1->CCMR2 = TIM_CCMR2_OC3M_2 | TIM_CCMR2_OC3M_1 | TIM_CCMR2_OC3M_0; // PWM mode 2, high from CCR3
+	TIM1->CCER = TIM_CCER_CC3E;
+	TIM1->BDTR = TIM_BDTR_MOE;
+	TIM1->EGR = TIM_EGR_UG;
+	TIM1->SR = 0;
+	TIM1->DIER = TIM_DIER_CC1DE;
+
+	// DMA1 channel 2, request 7 = TIM1_CH1, memory to SPI1->DR
+	hdma_tim1_ch1.Instance = DMA1_Channel2;
+	hdma_tim1_ch1.Init.Request = DMA_REQUEST_7;
+	hdma_tim1_ch1.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_tim1_ch1.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_tim1_ch1.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_tim1_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_tim1_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_tim1_ch1.Init.Mode = DMA_NORMAL;
+	hdma_tim1_ch1.Init.Priority = DMA_PRIORITY_HIGH;
+	if (HAL_DMA_Init(&hdma_tim1_ch1) != HAL_OK) {
+		Error_Handler();
+	}
+	hdma_tim1_ch1.XferCpltCallback = sent;
+	HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+
+	/* LCD controller reset sequence, HD44780 datasheet minimum waits held on the wire*/
+	Delay(LCD_POWERON_MS);
+	LCD_nibble_write(0x30,0);
+	lcd_hold(4100);
+	LCD_nibble_write(0x30,0);
+	lcd_hold(100);
+	LCD_nibble_write(0x30,0);
+	lcd_hold(LCD_SHORT_US);
+	LCD_nibble_write(0x20,0);
+	lcd_hold(LCD_SHORT_US);
+	instr(0x28); /* set 4 bit data LCD - two line display - 5x8 font*/
+	instr(0x0C); /* turn on display, turn off cursor*/
+	instr(0x01); /* clear display screen and return to home position*/
+	instr(0x06); /* set write direction */
+
+	// Controller and shadow both start blank with the address at 0
+	memset(shadow, ' ', sizeof(shadow));
+	memset(shown, ' ', sizeof(shown));
+	cursor = 0;
+	address = 0;
+	cursoron = false;
+	dirty = false;
+	count = 0;
+}
+
+// Bytes needed to bring the controller from base (shown or blank) to the shadow
+static uint16_t changes(bool blank)
+{
+	uint16_t bytes = 0;
+	uint8_t at = blank ? 0 : address;
+
+	for (uint8_t i = 0; i < LCD_CELLS; i++) {
+		if (shadow[i] != (blank ? ' ' : shown[i])) {
+			bytes += (at != i) ? 2 : 1;
+			at = (i + 1) % LCD_CELLS;
+		}
+	}
+	return bytes;
+}
+
+// Checks if a clear and the cells with text beat sending the cells that
+// differ, which takes most of the screen going blank
+static bool clearing(void)
+{
+	return LCD_CLEAR_SLOTS + changes(true) * LCD_BYTE_SLOTS < changes(false) * LCD_BYTE_SLOTS;
+}
+
+// Counts the visible cells the shadow changes
+static uint8_t differing(void)
+{
+	uint8_t cells = 0;
+
+	for (uint8_t i = 0; i < LCD_WIDTH; i++) {
+		cells += shadow[i] != shown[i];
+		cells += shadow[LCD_LINE + i] != shown[LCD_LINE + i];
+	}
+	return cells;
+}
+
+// Sends the cells that differ from what the controller holds
+void lcd_flush(void)
+{
+	if (dirty == false) {
+		return;
+	}
+	dirty = false;
+	count = 0;
+
+	// When most of the screen goes blank, a clear and the few cells left
+	// is quicker than blanking them one at a time
+	if (clearing() == true) {
+		instr(0x01);
+		memset(shown, ' ', sizeof(shown));
+		address = 0;
+	}
+
+	for (uint8_t i = 0; i < LCD_CELLS; i++) {
+		if (shadow[i] == shown[i]) {
+			continue;
+		}
+		if (address != i) { // Only move when the previous write did not end here
+			instr(0x80 | ddram(i));
+		}
+		data(shadow[i]);
+		shown[i] = shadow[i];
+		address = (i + 1) % LCD_CELLS;
+	}
+
+	// A visible cursor has to end up where the firmware left it
+	if (cursoron == true && address != cursor) {
+		instr(0x80 | ddram(cursor));
+		address = cursor;
+	}
+
+	if (count > 0) {
+		stats.flushes++;
+		stats.bytes += count;
+		stats.last = count;
+		if (count > stats.max) {
+			stats.max = count;
+		}
+	}
+}
+
+// Draws a static screen into the shadow and, when it changes most visible
+// cells, queues its prebuilt bytes. Otherwise the screen is close enough to
+// the one shown that sending the cells that differ is quicker.
+void lcd_show(lcd_screen_id_t id)
+{
+	const lcd_screen_t *screen = &lcd_screens[id];
+
+	memset(shadow, ' ', sizeof(shadow));
+	memcpy(shadow, screen->top, strlen(screen->top));
+	cursor = (uint8_t)strlen(screen->top);
+	if (screen->bottom != NULL) {
+		memcpy(&shadow[LCD_LINE], screen->bottom, strlen(screen->bottom));
+		cursor = LCD_LINE + (uint8_t)strlen(screen->bottom);
+	}
+	dirty = true;
+
+	if (differing() <= LCD_WIDTH) { // Half the visible cells or fewer
+		lcd_flush(); // The cells that differ, or only the cursor to move
+		return;
+	}
+	queue(LCD_STREAM | id);
+	memcpy(shown, shadow, LCD_WIDTH);
+	memcpy(&shown[LCD_LINE], &shadow[LCD_LINE], LCD_WIDTH);
+	address = screen->address;
+	dirty = memcmp(shown, shadow, sizeof(shown)) != 0; // Text past the visible cells, blanked next flush
+	count = 2 + 2 * LCD_WIDTH; // The address of each line, then its cells
+
+	// A visible cursor has to end up where the screen leaves it
+	if (cursoron == true && address != cursor) {
+		instr(0x80 | ddram(cursor));
+		address = cursor;
+	}
+
+	stats.flushes++;
+	stats.bytes += count;
+	stats.last = count;
+	if (count > stats.max) {
+		stats.max = count;
+	}
+}
+
+// Returns the bytes-per-flush and queue counters
+const lcd_stats_t *lcd_stats(void)
+{
+	return &stats;
+}
+
+// Waits until the last queued byte has been latched
+void lcd_wait(void)
+{
+	__disable_irq();
+	while (sending == true) {
+		__WFI();
+		__enable_irq();
+		__disable_irq();
+	}
+	__enable_irq();
+}
+
+// Checks if the transport is still sending, so TIM1 and DMA must keep running
+bool lcd_busy(void)
+{
+	return sending;
+}
+
+// Repeats the last byte so the controller gets the given time before the next
+void lcd_hold(uint16_t us)
+{
+	for (int slots = (us - 1) / LCD_SLOT_US; slots > 0; slots -= 0xFF) {
+		queue(LCD_HOLD | (slots > 0xFF ? 0xFF : slots));
+	}
+}
+
+// Writes to the LCD
+void Write_SR_LCD(uint8_t temp)
+{
+	queue(LCD_RAW | temp);
+}
+
+
+// Sets up the nibbles for writing to LCD
+void LCD_nibble_write(uint8_t temp, uint8_t s)
+{
+	/*writing instruction*/
+	if (s==0){
+		temp=temp&0xF0;
+		temp=temp|0x02; /*RS (bit 0) = 0 for Command EN (bit1)=high */
+		Write_SR_LCD(temp);
+		temp=temp&0xFD; /*RS (bit 0) = 0 for Command EN (bit1) = low*/
+		Write_SR_LCD(temp); }
+	/*writing data*/
+	else if (s==1) {
+		temp=temp&0xF0;
+		temp=temp|0x03; /*RS(bit 0)=1 for data EN (bit1) = high*/
+		Write_SR_LCD(temp);
+		temp=temp&0xFD; /*RS(bit 0)=1 for data EN(bit1) = low*/
+		Write_SR_LCD(temp);
+}}
+
+// Applies an instruction to the shadow. Clear, home and cursor moves only
+// change the shadow; anything else flushes and goes to the controller.
+// Writes always move right, the only entry mode this firmware uses.
+void Write_Instr_LCD(uint8_t code)
+{
+	if (code == 0x01) { // Clear display
+		memset(shadow, ' ', sizeof(shadow));
+		cursor = 0;
+		dirty = true;
+	} else if ((code & 0xFE) == 0x02) { // Return home
+		cursor = 0;
+	} else if (code & 0x80) { // Set DDRAM address
+		cursor = cell(code & 0x7F);
+	} else if ((code & 0xF8) == 0x10) { // Cursor shift, bit 2 = right
+		cursor = (cursor + ((code & 0x04) ? 1 : LCD_CELLS - 1)) % LCD_CELLS;
+	} else {
+		if ((code & 0xF8) == 0x08) { // Display on/off control
+			cursoron = (code & 0x03) != 0;
+		}
+		lcd_flush();
+		instr(code);
+	}
+	if (cursoron == true) {
+		dirty = true; // Cursor position alone needs a flush
+	}
+}
+
+
+// Draws a character into the shadow at the cursor
+void Write_Char_LCD(uint8_t code)
+{
+	shadow[cursor] = code;
+	cursor = (cursor + 1) % LCD_CELLS;
+	dirty = true;
+}
+
+
+// Writes strings to LCD
+void Write_String_LCD(char *temp)
+{
+	int i=0;
+	while(temp[i]!=0)
+	{
+		Write_Char_LCD(temp[i]);
+		i=i+1;
+	}
+}
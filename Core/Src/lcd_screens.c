@@ -0,0 +1,413 @@
+/**
+  ******************************************************************************
+  * @file           : lcd_screens.c
+  * @brief          : Shift register streams for the static screens listed
+  *                   in lcd_screens.h. Generated by Tools/lcd_streams.c,
+  *                   do not edit.
+  ******************************************************************************
+  */
+
+#include "lcd_screens.h"
+
+// "Digital Lock", NULL, 239 bytes
+static const uint8_t lcd_screen_splash[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61,
+	0x93, 0x91, 0x91, 0x91, 0x91, 0x63, 0x61, 0x73, 0x71, 0x71, 0x71, 0x71, 0x63, 0x61, 0x93, 0x91,
+	0x91, 0x91, 0x91, 0x73, 0x71, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x13, 0x11, 0x11, 0x11,
+	0x11, 0x63, 0x61, 0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43,
+	0x41, 0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x63, 0x61, 0x33,
+	0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xB3, 0xB1, 0xB1, 0xB1, 0xB1, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "Enter Code:", "", 239 bytes
+static const uint8_t lcd_screen_enter[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x63, 0x61,
+	0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x73, 0x71, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x53, 0x51,
+	0x51, 0x51, 0x51, 0x73, 0x71, 0x23, 0x21, 0x21, 0x21, 0x21, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x63,
+	0x61, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x33, 0x31, 0xA3,
+	0xA1, 0xA1, 0xA1, 0xA1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "Enter New Code:", "", 239 bytes
+static const uint8_t lcd_screen_newcode[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x63, 0x61,
+	0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x73, 0x71, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x53, 0x51,
+	0x51, 0x51, 0x51, 0x73, 0x71, 0x23, 0x21, 0x21, 0x21, 0x21, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x43, 0x41, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x73,
+	0x71, 0x73, 0x71, 0x71, 0x71, 0x71, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x33,
+	0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x63, 0x61, 0x43, 0x41, 0x41,
+	0x41, 0x41, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x33, 0x31, 0xA3, 0xA1, 0xA1, 0xA1, 0xA1,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "LOCKED", "", 239 bytes
+static const uint8_t lcd_screen_locked[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x43, 0x41,
+	0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xB3, 0xB1,
+	0xB1, 0xB1, 0xB1, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41,
+	0x41, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "UNLOCKED", "10", 239 bytes
+static const uint8_t lcd_screen_unlocked[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x53, 0x51, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41,
+	0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x43, 0x41, 0xF3, 0xF1,
+	0xF1, 0xF1, 0xF1, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xB3, 0xB1, 0xB1, 0xB1,
+	0xB1, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41, 0x41, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x33, 0x31,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x33, 0x31, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "INVALID CODE", NULL, 239 bytes
+static const uint8_t lcd_screen_invalid[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x93, 0x91, 0x91, 0x91, 0x91, 0x43, 0x41,
+	0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x53, 0x51, 0x63, 0x61, 0x61, 0x61, 0x61, 0x43, 0x41, 0x13, 0x11,
+	0x11, 0x11, 0x11, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x43, 0x41, 0x93, 0x91, 0x91, 0x91,
+	0x91, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41, 0x41, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43,
+	0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x43, 0x41, 0x43,
+	0x41, 0x41, 0x41, 0x41, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "ADMIN", NULL, 239 bytes
+static const uint8_t lcd_screen_admin[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x13, 0x11, 0x11, 0x11, 0x11, 0x43, 0x41,
+	0x43, 0x41, 0x41, 0x41, 0x41, 0x43, 0x41, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41, 0x93, 0x91,
+	0x91, 0x91, 0x91, 0x43, 0x41, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "1 - View Codes", "A=SEL B=BACK #=>", 239 bytes
+static const uint8_t lcd_screen_menu1[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x33, 0x31, 0x13, 0x11, 0x11, 0x11, 0x11, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x53, 0x51, 0x63, 0x61, 0x61, 0x61, 0x61, 0x63, 0x61, 0x93, 0x91, 0x91, 0x91,
+	0x91, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x73, 0x71, 0x73, 0x71, 0x71, 0x71, 0x71, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xF3,
+	0xF1, 0xF1, 0xF1, 0xF1, 0x63, 0x61, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x53, 0x51, 0x51,
+	0x51, 0x51, 0x73, 0x71, 0x33, 0x31, 0x31, 0x31, 0x31, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x53, 0x51, 0x33, 0x31,
+	0x31, 0x31, 0x31, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1,
+	0xC1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x33,
+	0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x13,
+	0x11, 0x11, 0x11, 0x11, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xB3, 0xB1, 0xB1,
+	0xB1, 0xB1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x33, 0x31, 0x31, 0x31, 0x31,
+	0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x33, 0x31, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0xE1
+};
+
+// "2 - Add Codes", "A=SEL B=BACK #=>", 239 bytes
+static const uint8_t lcd_screen_menu2[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x33, 0x31, 0x23, 0x21, 0x21, 0x21, 0x21, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x43, 0x41, 0x13, 0x11, 0x11, 0x11, 0x11, 0x63, 0x61, 0x43, 0x41, 0x41, 0x41,
+	0x41, 0x63, 0x61, 0x43, 0x41, 0x41, 0x41, 0x41, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43,
+	0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x63, 0x61, 0x43,
+	0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x73, 0x71, 0x33, 0x31, 0x31,
+	0x31, 0x31, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x53, 0x51, 0x33, 0x31,
+	0x31, 0x31, 0x31, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1,
+	0xC1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x33,
+	0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x13,
+	0x11, 0x11, 0x11, 0x11, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xB3, 0xB1, 0xB1,
+	0xB1, 0xB1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x33, 0x31, 0x31, 0x31, 0x31,
+	0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x33, 0x31, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0xE1
+};
+
+// "3 - Remove Codes", "A=SEL B=BACK #=>", 239 bytes
+static const uint8_t lcd_screen_menu3[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x33, 0x31, 0x33, 0x31, 0x31, 0x31, 0x31, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x53, 0x51, 0x23, 0x21, 0x21, 0x21, 0x21, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51,
+	0x51, 0x63, 0x61, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x73,
+	0x71, 0x63, 0x61, 0x61, 0x61, 0x61, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xF3, 0xF1, 0xF1,
+	0xF1, 0xF1, 0x63, 0x61, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51,
+	0x73, 0x71, 0x33, 0x31, 0x31, 0x31, 0x31, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x53, 0x51, 0x33, 0x31,
+	0x31, 0x31, 0x31, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1,
+	0xC1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x33,
+	0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x13,
+	0x11, 0x11, 0x11, 0x11, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xB3, 0xB1, 0xB1,
+	0xB1, 0xB1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x33, 0x31, 0x31, 0x31, 0x31,
+	0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x33, 0x31, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0xE1
+};
+
+// "4 - Clear Codes", "A=SEL B=BACK #=>", 239 bytes
+static const uint8_t lcd_screen_menu4[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x33, 0x31, 0x43, 0x41, 0x41, 0x41, 0x41, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xC3, 0xC1, 0xC1, 0xC1,
+	0xC1, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x63, 0x61, 0x13, 0x11, 0x11, 0x11, 0x11, 0x73,
+	0x71, 0x23, 0x21, 0x21, 0x21, 0x21, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x33,
+	0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x63, 0x61, 0x43, 0x41, 0x41,
+	0x41, 0x41, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x73, 0x71, 0x33, 0x31, 0x31, 0x31, 0x31,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x53, 0x51, 0x33, 0x31,
+	0x31, 0x31, 0x31, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1,
+	0xC1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x33,
+	0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x13,
+	0x11, 0x11, 0x11, 0x11, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xB3, 0xB1, 0xB1,
+	0xB1, 0xB1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x33, 0x31, 0x31, 0x31, 0x31,
+	0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x33, 0x31, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0xE1
+};
+
+// "5 - Bulk Add", "A=SEL B=BACK #=>", 239 bytes
+static const uint8_t lcd_screen_menu5[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x33, 0x31, 0x53, 0x51, 0x51, 0x51, 0x51, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x73, 0x71, 0x53, 0x51, 0x51, 0x51,
+	0x51, 0x63, 0x61, 0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x63, 0x61, 0xB3, 0xB1, 0xB1, 0xB1, 0xB1, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x13, 0x11, 0x11, 0x11, 0x11, 0x63, 0x61, 0x43,
+	0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x43, 0x41, 0x41, 0x41, 0x41, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x53, 0x51, 0x33, 0x31,
+	0x31, 0x31, 0x31, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1,
+	0xC1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x33,
+	0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x13,
+	0x11, 0x11, 0x11, 0x11, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xB3, 0xB1, 0xB1,
+	0xB1, 0xB1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x33, 0x31, 0x31, 0x31, 0x31,
+	0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x33, 0x31, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0xE1
+};
+
+// "MAX CODES", "REACHED", 239 bytes
+static const uint8_t lcd_screen_maxcodes[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x53, 0x51, 0x83, 0x81, 0x81, 0x81, 0x81, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xF3, 0xF1, 0xF1, 0xF1,
+	0xF1, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41, 0x41, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x53,
+	0x51, 0x33, 0x31, 0x31, 0x31, 0x31, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x53, 0x51,
+	0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0x13, 0x11,
+	0x11, 0x11, 0x11, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0x83, 0x81, 0x81, 0x81,
+	0x81, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41, 0x41, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "CODE EXISTS", NULL, 239 bytes
+static const uint8_t lcd_screen_exists[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41,
+	0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41, 0x41, 0x43, 0x41, 0x53, 0x51,
+	0x51, 0x51, 0x51, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51,
+	0x51, 0x53, 0x51, 0x83, 0x81, 0x81, 0x81, 0x81, 0x43, 0x41, 0x93, 0x91, 0x91, 0x91, 0x91, 0x53,
+	0x51, 0x33, 0x31, 0x31, 0x31, 0x31, 0x53, 0x51, 0x43, 0x41, 0x41, 0x41, 0x41, 0x53, 0x51, 0x33,
+	0x31, 0x31, 0x31, 0x31, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "Add another?", "A=Yes       B=No", 239 bytes
+static const uint8_t lcd_screen_another[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x13, 0x11, 0x11, 0x11, 0x11, 0x63, 0x61,
+	0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x43, 0x41, 0x41, 0x41, 0x41, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x63, 0x61, 0x13, 0x11, 0x11, 0x11, 0x11, 0x63, 0x61, 0xE3, 0xE1, 0xE1, 0xE1,
+	0xE1, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x73, 0x71, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63,
+	0x61, 0x83, 0x81, 0x81, 0x81, 0x81, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x73, 0x71, 0x23,
+	0x21, 0x21, 0x21, 0x21, 0x33, 0x31, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x53, 0x51, 0x93, 0x91,
+	0x91, 0x91, 0x91, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x73, 0x71, 0x33, 0x31, 0x31, 0x31,
+	0x31, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1,
+	0x43, 0x41, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0xF1
+};
+
+// "SELECT CODES TO", "REMOVE", 239 bytes
+static const uint8_t lcd_screen_select[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x53, 0x51, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41,
+	0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x43, 0x41, 0x53, 0x51,
+	0x51, 0x51, 0x51, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x53, 0x51, 0x43, 0x41, 0x41, 0x41,
+	0x41, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43,
+	0x41, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41, 0x41, 0x43, 0x41, 0x53,
+	0x51, 0x51, 0x51, 0x51, 0x53, 0x51, 0x33, 0x31, 0x31, 0x31, 0x31, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x53, 0x51, 0x43, 0x41, 0x41, 0x41, 0x41, 0x43, 0x41, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x53, 0x51,
+	0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xD3, 0xD1,
+	0xD1, 0xD1, 0xD1, 0x43, 0x41, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x53, 0x51, 0x63, 0x61, 0x61, 0x61,
+	0x61, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "WHEN DONE,", "PRESS C", 239 bytes
+static const uint8_t lcd_screen_donehint[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x53, 0x51, 0x73, 0x71, 0x71, 0x71, 0x71, 0x43, 0x41,
+	0x83, 0x81, 0x81, 0x81, 0x81, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xE3, 0xE1,
+	0xE1, 0xE1, 0xE1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41,
+	0x41, 0x43, 0x41, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x43, 0x41, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x43,
+	0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x23, 0x21, 0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x53, 0x51,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x53, 0x51, 0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x53, 0x51,
+	0x51, 0x51, 0x51, 0x53, 0x51, 0x33, 0x31, 0x31, 0x31, 0x31, 0x53, 0x51, 0x33, 0x31, 0x31, 0x31,
+	0x31, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "0 CODES REMAIN", NULL, 239 bytes
+static const uint8_t lcd_screen_nocodes[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x33, 0x31, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x43, 0x41, 0xF3, 0xF1,
+	0xF1, 0xF1, 0xF1, 0x43, 0x41, 0x43, 0x41, 0x41, 0x41, 0x41, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51,
+	0x51, 0x53, 0x51, 0x33, 0x31, 0x31, 0x31, 0x31, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x53,
+	0x51, 0x23, 0x21, 0x21, 0x21, 0x21, 0x43, 0x41, 0x53, 0x51, 0x51, 0x51, 0x51, 0x43, 0x41, 0xD3,
+	0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41, 0x13, 0x11, 0x11, 0x11, 0x11, 0x43, 0x41, 0x93, 0x91, 0x91,
+	0x91, 0x91, 0x43, 0x41, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "Clear codes?", "A=Yes B=No", 239 bytes
+static const uint8_t lcd_screen_clear[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61,
+	0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x63, 0x61, 0x13, 0x11,
+	0x11, 0x11, 0x11, 0x73, 0x71, 0x23, 0x21, 0x21, 0x21, 0x21, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x63, 0x61, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x63,
+	0x61, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x73, 0x71, 0x33,
+	0x31, 0x31, 0x31, 0x31, 0x33, 0x31, 0xF3, 0xF1, 0xF1, 0xF1, 0xF1, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41,
+	0x13, 0x11, 0x11, 0x11, 0x11, 0x33, 0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x53, 0x51, 0x93, 0x91,
+	0x91, 0x91, 0x91, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x73, 0x71, 0x33, 0x31, 0x31, 0x31,
+	0x31, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x43, 0x41, 0x23, 0x21, 0x21, 0x21, 0x21, 0x33,
+	0x31, 0xD3, 0xD1, 0xD1, 0xD1, 0xD1, 0x43, 0x41, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x63, 0x61, 0xF3,
+	0xF1, 0xF1, 0xF1, 0xF1, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+// "Clearing codes.", NULL, 239 bytes
+static const uint8_t lcd_screen_clearing[] = {
+	0x82, 0x80, 0x02, 0x00, 0x00, 0x00, 0x00, 0x43, 0x41, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61,
+	0xC3, 0xC1, 0xC1, 0xC1, 0xC1, 0x63, 0x61, 0x53, 0x51, 0x51, 0x51, 0x51, 0x63, 0x61, 0x13, 0x11,
+	0x11, 0x11, 0x11, 0x73, 0x71, 0x23, 0x21, 0x21, 0x21, 0x21, 0x63, 0x61, 0x93, 0x91, 0x91, 0x91,
+	0x91, 0x63, 0x61, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1, 0x63, 0x61, 0x73, 0x71, 0x71, 0x71, 0x71, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x63, 0x61, 0x33, 0x31, 0x31, 0x31, 0x31, 0x63, 0x61, 0xF3,
+	0xF1, 0xF1, 0xF1, 0xF1, 0x63, 0x61, 0x43, 0x41, 0x41, 0x41, 0x41, 0x63, 0x61, 0x53, 0x51, 0x51,
+	0x51, 0x51, 0x73, 0x71, 0x33, 0x31, 0x31, 0x31, 0x31, 0x23, 0x21, 0xE3, 0xE1, 0xE1, 0xE1, 0xE1,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0xC2, 0xC0, 0x02, 0x00, 0x00, 0x00, 0x00, 0x23, 0x21,
+	0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01,
+	0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01,
+	0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23,
+	0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01,
+	0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01,
+	0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x23, 0x21, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01
+};
+
+const lcd_screen_t lcd_screens[LCD_SCREENS] = {
+	{"Digital Lock", NULL, lcd_screen_splash, sizeof(lcd_screen_splash), 56},
+	{"Enter Code:", "", lcd_screen_enter, sizeof(lcd_screen_enter), 56},
+	{"Enter New Code:", "", lcd_screen_newcode, sizeof(lcd_screen_newcode), 56},
+	{"LOCKED", "", lcd_screen_locked, sizeof(lcd_screen_locked), 56},
+	{"UNLOCKED", "10", lcd_screen_unlocked, sizeof(lcd_screen_unlocked), 56},
+	{"INVALID CODE", NULL, lcd_screen_invalid, sizeof(lcd_screen_invalid), 56},
+	{"ADMIN", NULL, lcd_screen_admin, sizeof(lcd_screen_admin), 56},
+	{"1 - View Codes", "A=SEL B=BACK #=>", lcd_screen_menu1, sizeof(lcd_screen_menu1), 56},
+	{"2 - Add Codes", "A=SEL B=BACK #=>", lcd_screen_menu2, sizeof(lcd_screen_menu2), 56},
+	{"3 - Remove Codes", "A=SEL B=BACK #=>", lcd_screen_menu3, sizeof(lcd_screen_menu3), 56},
+	{"4 - Clear Codes", "A=SEL B=BACK #=>", lcd_screen_menu4, sizeof(lcd_screen_menu4), 56},
+	{"5 - Bulk Add", "A=SEL B=BACK #=>", lcd_screen_menu5, sizeof(lcd_screen_menu5), 56},
+	{"MAX CODES", "REACHED", lcd_screen_maxcodes, sizeof(lcd_screen_maxcodes), 56},
+	{"CODE EXISTS", NULL, lcd_screen_exists, sizeof(lcd_screen_exists), 56},
+	{"Add another?", "A=Yes       B=No", lcd_screen_another, sizeof(lcd_screen_another), 56},
+	{"SELECT CODES TO", "REMOVE", lcd_screen_select, sizeof(lcd_screen_select), 56},
+	{"WHEN DONE,", "PRESS C", lcd_screen_donehint, sizeof(lcd_screen_donehint), 56},
+	{"0 CODES REMAIN", NULL, lcd_screen_nocodes, sizeof(lcd_screen_nocodes), 56},
+	{"Clear codes?", "A=Yes B=No", lcd_screen_clear, sizeof(lcd_screen_clear), 56},
+	{"Clearing codes.", NULL, lcd_screen_clearing, sizeof(lcd_screen_clearing), 56},
+};
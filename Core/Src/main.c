@@ -20,48 +20,143 @@
 #include "stdio.h"
 #include "stdbool.h"
 #include "string.h"
+#include "codestore.h"
+#include "journal.h"
+#include "keypad.h"
+#include "lcd.h"
+#include "swtimer.h"
+#include "delay.h"
+#include "power.h"
+#include "alarm.h"
+#include "event.h"
+#include "console.h"
 
 // Init Functions
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
-void SysTick_Initialize(uint32_t);
 
 // Delay Function
 void Delay(int delay);
 
-// Keypad Functions
-unsigned char detectkey(void);
-bool iskeypressed(void);
-void codeentry(char* entry, bool admin);
-
-// LCD Functions
-void LCD_nibble_write(uint8_t temp, uint8_t s); //configures message for data (1) or instructions (0) with s
-void Write_SR_LCD(uint8_t temp); //writes data to lcd shift register
-void Write_Instr_LCD(uint8_t code); //writes instructions to LCD
-void Write_Char_LCD(uint8_t code); //writes character to LCD
-void Write_String_LCD(char *temp); //writes string to LCD
-
-// Passcode Functions
-uint8_t checkcode(char* entry, char codes[][4], uint16_t total); // Validates codes, 0 = incorrect, 1 = correct, 2 = admin
-uint16_t editcodes(char codes[][4], uint16_t total, bool mode); // Add/Removes codes
-void clearcodes(char codes[][4]); // Clear all codes
-void displaycodes(char codes[][4], uint16_t total); // Display available codes
-
 // LED Functions
 void setleds(GPIO_PinState); // Sets LED states
 void flashleds(bool state); // Flashes LEDs if true is passed
 
-// Speaker Functions
-void buzz(int time); // Buzz speaker for given time in ms
+// Application states. A screen either takes keys or waits on the screen
+// timer, never both, so a timer event always belongs to the screen shown.
+typedef struct {
+	void (*key)(unsigned char key); // NULL leaves keys queued in the keypad driver
+	void (*timeout)(void); // Screen timer expired
+} state_t;
+
+#define TIMER_SCREEN 0 // EVENT_TIMER arg of the screen timer
+
+// Event loop
+static bool nextevent(event_t* ev); // Takes a timer or comms event, then a key if the screen takes keys
+static void dispatch(const event_t* ev); // Hands an event to the current state
+static void screenexpired(void* arg); // Screen timer callback
+static void show(const char* top, const char* bottom); // Clears and draws both lines
+static void wait(uint32_t ms, void (*then)(void)); // Moves on after ms
+static void waited(void);
+static void message(const char* top, const char* bottom, uint32_t ms, void (*then)(void)); // Shows a screen for ms
+static void notice(lcd_screen_id_t screen, uint32_t ms, void (*then)(void)); // Shows a static screen for ms
+
+// Code entry on the bottom line
+static void askcode(bool admin, void (*done)(void));
+static void entrykey(unsigned char key);
+static void erase(int count); // Blanks characters left of the cursor
+static void changecode(void);
+static void retype(void);
 
-// Admin functions
-uint16_t adminmenu(char codes[][4], uint16_t total);
+// Lock screens
+static void splash(void);
+static void firstcode(void);
+static void initialcode(void);
+static void locked(void);
+static void checkentry(void);
+static uint8_t verdict(void); // Result of the typed code, worked out digit by digit
+static void invalid(void);
+static void unlocked(void);
+static void countdown(void);
+
+// Admin screens
+static void admin(void);
+static void menu(void);
+static void menukey(unsigned char key);
+static void openbrowser(const char* hint); // Sorts the codes and starts at the first
+static void freshen(void); // Sorts again if the console changed the codes
+static void field(char* shown, uint8_t addr, const char* text); // Writes one browser field if it changed
+static void drawcode(const char* mark); // Browser screen for the current code
+static bool browsekey(unsigned char key); // Moves through the codes, false if the key is not for that
+static void viewcodes(void);
+static void viewkey(unsigned char key);
+static void addcodes(void);
+static void added(void);
+static void askanother(void);
+static void another(unsigned char key);
+static void removecodes(void);
+static void removehint(void);
+static void browse(void);
+static void removekey(unsigned char key);
+static void removed(void);
+static void remaining(void);
+static void bulkcodes(void);
+static void bulkline(const char* status); // Status and running total on top, next code below
+static void bulkadd(void);
+static void bulkend(void);
+static void clearcodes(void);
+static void clearkey(unsigned char key);
+static void cleared(void);
+static void newcode(void);
+static void replacecodes(void);
 
 // Global Variables
-const int CODESIZE = 5; // Sets max codes, max 999, min 1
-const char ADMIN[4] = {'2' , '5', '8', '0'}; // Used for admin functions of lock
+const int CODESIZE = CODESTORE_CAPACITY; // Sets max codes, max CODESTORE_CAPACITY, min 1
+const char ADMIN[] = "2580"; // Used for admin functions of lock, CODESTORE_MIN to CODESTORE_MAX digits
 bool seecode = false; // Controls wether digits are shown as numbers or stars by default
 
+static int screentimer = -1; // Software timer for timed screens
+static codestore_t codes; // Stores all codes for comparison (static, too big for the stack)
+static const state_t* state = NULL;
+static void (*after)(void) = NULL; // Where the screen timer leads
+static int unlockedcount = 0, count = 0; // Unlocks so far, countdown seconds left
+static uint8_t menuitem = 1; // Admin menu option shown
+static int totalremoved = 0; // Codes marked in the remove browser
+static int bulkadded = 0; // Codes added since bulk enrollment started
+
+// Code browser, over an index of the codes in order so stepping, jumping to
+// a typed index and searching by a typed prefix cost the same at any size
+static struct {
+	codestore_index_t index; // Sorted as the browser opens, nothing changes the codes while it is shown
+	uint16_t position; // Code shown, from 0
+	uint8_t width; // Digits in the index field, 3 or as many as the last index has
+	codestore_cursor_t typed; // Prefix typed, or the index after D
+	char query[CODESTORE_MAX + 1]; // The same digits, for the bottom line
+	bool jumping; // D pressed, digits are an index
+	bool missed; // Nothing found for the digits typed
+	const char* hint; // Bottom line when nothing is typed
+	bool drawn; // Screen cleared for the browser and fields below are on it
+	char shown[4][17]; // Mark, index, code and bottom line as on the LCD
+} browser;
+
+// Code being typed
+static struct {
+	char code[CODESTORE_MAX + 1]; // NUL-terminated
+	uint8_t length;
+	bool admin; // The admin code may be entered
+	void (*done)(void); // Called once A confirms at least CODESTORE_MIN digits
+	codestore_cursor_t cursor; // Stored codes the digits so far can still become
+	void (*back)(void); // Called by B with nothing typed, NULL if B only erases
+} entry = {"", 0, false, NULL, {0, 0, 0, false, 0}, NULL};
+
+static const state_t waiting = {NULL, waited};
+static const state_t entering = {entrykey, NULL};
+static const state_t menuing = {menukey, NULL};
+static const state_t viewing = {viewkey, NULL};
+static const state_t asking = {another, NULL};
+static const state_t selecting = {removekey, NULL};
+static const state_t confirming = {clearkey, NULL};
+
 /**
   * @brief  The application entry point.
   * @retval int
@@ -74,124 +169,65 @@ int main(void)
   SystemClock_Config();
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
-	
+	delay_init();
+	delay_calibrate(); // Report stays in delay.c for the debugger
+	power_init();
+	keypad_init();
+	alarm_init();
+
+	// Software timer for timed screens
+	screentimer = swtimer_create(screenexpired, NULL);
+	if (screentimer < 0) {
+		Error_Handler();
+	}
+
 	// Variables
-	char codes[CODESIZE][4]; // Stores all codes for comparison
-	char entry[4] = {' ' , ' ', ' ', ' '}; // Stores current code
-	uint16_t totalcodes = 0;
-	char* line = NULL;
-	char num[3], unlocked[16];
-	int lockstate = 0, unlockedcount = 0;
-		
+	event_t ev;
+	uint32_t start;
+
+	// Codes saved before the last power cycle
+	journal_mount(&codes);
+
 	// Reset LED
-	flashleds(false);
 	setleds(GPIO_PIN_RESET);
-	
-/* LCD controller reset sequence*/ 
-	Delay(20);
-	LCD_nibble_write(0x30,0);
-	Delay(5);
-	LCD_nibble_write(0x30,0);
-	Delay(1);
-	LCD_nibble_write(0x30,0);
-	Delay(1);
-	LCD_nibble_write(0x20,0);
-	Delay(1);
-	Write_Instr_LCD(0x28); /* set 4 bit data LCD - two line display - 5x8 font*/
-	Write_Instr_LCD(0x0C); /* turn on display, turn off cursor*/
-	Write_Instr_LCD(0x01); /* clear display screen and return to home position*/
-	Write_Instr_LCD(0x06); /* set write direction */
-	
-	// Write Digital Lock to screen
-	line = "Digital Lock";
-	Write_String_LCD(line);
-	Delay(1500);
-	Write_Instr_LCD(0x01); // Clear Screen
-	
-	// Ask for initial code
-	line = "Enter Code:";
-	Write_String_LCD(line);
-	Write_Instr_LCD(0xC0); // Go to bottom line
-	
-	// Wait for inital code
-	codeentry(entry, false);
-	
-	//save initial code
-	for (int i = 0; i < 4; i++) {
-		codes[0][i] = entry[i];
-	}
-	totalcodes++;
-	
-	// End startup
-	Write_Instr_LCD(0x01); // Clear Screen
-	
+
+	// LCD transport and controller reset sequence
+	lcd_init();
+
+	// Serial console on USART2, editing the same codes
+	console_init(&codes);
+
+	// Write Digital Lock to screen, code entry follows
+	splash();
+
+	// Run-to-completion loop: every event is handled in full and the screen
+	// flushed, then the core sleeps until the next one
 	while (1) {
-		// Default to locked
-		Write_Instr_LCD(0x01); // Clear Screen
-		line = "LOCKED";
-		Write_String_LCD(line); // Write locked
-		setleds(GPIO_PIN_SET); // Turn on LEDS
-		Write_Instr_LCD(0xC0); // Go to bottom line
-		
-		// Wait for code entry
-		codeentry(entry, true);
-		
-		// Check code against others
-		lockstate = checkcode(entry, codes, totalcodes);
-		
-		switch (lockstate) {
-			case 0: // Incorrect Code
-				Write_Instr_LCD(0x01); // Clear Screen
-				line = "INVALID CODE";
-				Write_String_LCD(line); // Write invalid code
-				flashleds(true); // Enable flashing systick
-				buzz(3500); // Buzz speaker
-				flashleds(false); // Disable flashing systick
-				break;
-			case 1: // Correct Code
-				Write_Instr_LCD(0x01); // Clear Screen
-				line = "UNLOCKED";
-				Write_String_LCD(line); // Write unlocked
-				setleds(GPIO_PIN_RESET); // Turn off LEDS
-				Write_Instr_LCD(0xC0); // Go to bottom line
-				line = "10";
-				Write_String_LCD(line); // Write 10
-				Delay(1000);
-
-				for (int i=9; i > 0; i--) { // Screen Countdown
-					Write_Instr_LCD(0x10); // Decrement cursor
-					Write_Instr_LCD(0x10);
-					line = "  ";
-					Write_String_LCD(line); // Erase previous output
-					Write_Instr_LCD(0x10); // Decrement cursor
-					Write_Instr_LCD(0x10);
-					snprintf(num, 3, "0%d", i); // Convert i to string
-					Write_String_LCD(num); // Write i
-					Delay(1000);
-				}
-				Write_Instr_LCD(0x01); // Clear Screen
-				unlockedcount++;
-				line = "# OF UNLOCKS:";
-				Write_String_LCD(line); // Write unlocked
-				Write_Instr_LCD(0xC0); // Go to bottom line
-				snprintf(unlocked, 16, "%d", unlockedcount); // Convert i to string
-				Write_String_LCD(unlocked); // Write unlocked array
-				Delay(1500);
-				break;
-			case 2: // Admin Code
-				totalcodes = adminmenu(codes, totalcodes);
+		lcd_flush();
+
+		// Interrupts stay masked between the check and the sleep so an event
+		// arriving in between still wakes the core
+		__disable_irq();
+		while (nextevent(&ev) == false) {
+			power_idle();
+			__enable_irq();
+			__disable_irq();
 		}
-		
+		__enable_irq();
+
+		start = DWT->CYCCNT;
+		dispatch(&ev);
+		lcd_flush();
+		event_done(&ev, DWT->CYCCNT - start);
 	}
 }
 
 
 
+
 // Set up the GPIO pins
 static void MX_GPIO_Init(void)
 {
-  uint32_t temp;
-	
 	GPIO_InitTypeDef GPIO_InitStruct = {0};
 	
   /* GPIO Ports Clock Enable */
@@ -206,39 +242,14 @@ static void MX_GPIO_Init(void)
 	GPIO_InitStruct.Speed = GPIO_SPEED_LOW;
 	HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 	
-	/*Configure KeypadRow GPIO pin : PB8 - PB11 */
+	/*Configure KeypadRow GPIO pin : PB8 - PB11, interrupt on press */
   GPIO_InitStruct.Pin = GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11;
-  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
   GPIO_InitStruct.Pull = GPIO_PULLDOWN;
 	GPIO_InitStruct.Speed = GPIO_SPEED_LOW;
 	HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 	
-	/*Configure LCD GPIO pin : PA5 + PA10*/
-	temp = GPIOA->MODER;
-	temp &= ~(0x03<<(2*5));
-	temp|=(0x01<<(2*5));
-	temp &= ~(0x03<<(2*10));
-	temp|=(0x01<<(2*10));
-	GPIOA->MODER = temp;
-	temp=GPIOA->OTYPER;
-	temp &=~(0x01<<5);
-	temp &=~(0x01<<10);
-	GPIOA->OTYPER=temp;temp=GPIOA->PUPDR;
-	temp&=~(0x03<<(2*5));
-	temp&=~(0x03<<(2*10));
-	GPIOA->PUPDR=temp;
-	
-	/*Configure LCD GPIO pin : PB5*/
-	temp = GPIOB->MODER;
-	temp &= ~(0x03<<(2*5));
-	temp|=(0x01<<(2*5));
-	GPIOB->MODER = temp;
-	temp=GPIOB->OTYPER;
-	temp &=~(0x01<<5);
-	GPIOB->OTYPER=temp;
-	temp=GPIOB->PUPDR;
-	temp&=~(0x03<<(2*5));
-	GPIOB->PUPDR=temp;
+	/*LCD pins PA5 + PB5 (SPI1) and PA10 (TIM1_CH3) are set up in lcd_init()*/
 	
 	/*Configure LED GPIO pins : PA0 + PA1*/
 	GPIO_InitStruct.Pin = GPIO_PIN_0 | GPIO_PIN_1;
@@ -254,810 +265,800 @@ static void MX_GPIO_Init(void)
 	GPIO_InitStruct.Speed = GPIO_SPEED_LOW;
 	HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
 	
+	/* EXTI interrupt init, keypad rows PB8 - PB11*/
+	HAL_NVIC_SetPriority(EXTI9_5_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+	HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+	
 }
 
 
-// Detects what key is pressed
-unsigned char detectkey(void) 
+// Takes the next event, interrupts masked. Timer and comms events come
+// first, then flash completions; keys stay in the keypad queue while the
+// screen takes none.
+static bool nextevent(event_t* ev)
 {
-	unsigned char keymap[4][4] =
-		{{'1', '2', '3', 'A'},
-		{'4', '5', '6', 'B'},
-		{'7', '8', '9', 'C'},
-		{'*', '0', '#', 'D'}};
-	int col = 0, row = 0;
-	uint16_t colpins[4] = {GPIO_PIN_1, GPIO_PIN_2, GPIO_PIN_3, GPIO_PIN_4};
-	uint16_t rowpins[4] = {GPIO_PIN_8, GPIO_PIN_9, GPIO_PIN_10, GPIO_PIN_11};
-	
-	// Setting all columns high
-	HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4, GPIO_PIN_SET);
-	
-	// Detecting if a key is pressed
-	while (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11) == GPIO_PIN_RESET);	
-	
-	// Detecting which row was pressed
-	for (int i = 0; i < 4; i++) {
-		
-		// Checking test row
-		if (HAL_GPIO_ReadPin(GPIOB, rowpins[i]) == GPIO_PIN_SET) {
-			row = i;
-			break;
-		}
-		
+	unsigned char key;
+
+	if (event_get(ev) == true) {
+		return true;
 	}
-	
-	// Detecting which column was pressed
-	for (int i = 0; i < 4; i++) {
-		
-		// Setting all columns low
-		HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4, GPIO_PIN_RESET);
-		
-		// Setting test column high
-		HAL_GPIO_WritePin(GPIOB, colpins[i], GPIO_PIN_SET);
-		
-		// Checking rows
-		if (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11) == GPIO_PIN_SET) {
-			col = i;
+	if (journal_ready() == true) {
+		ev->type = EVENT_FLASH;
+		ev->arg = 0;
+		return true;
+	}
+	if (state->key != NULL && keypad_getkey(&key) == true) {
+		ev->type = EVENT_KEY;
+		ev->arg = key;
+		return true;
+	}
+	return false;
+}
+
+// Hands an event to the current state
+static void dispatch(const event_t* ev)
+{
+	switch (ev->type) {
+		case EVENT_KEY:
+			state->key(ev->arg);
+			break;
+		case EVENT_TIMER:
+			if (ev->arg == TIMER_SCREEN && state->timeout != NULL) {
+				state->timeout();
+			}
+			break;
+		case EVENT_FLASH:
+			journal_poll();
+			console_poll(); // A provisioning sync may be waiting for the journal
+			break;
+		case EVENT_COMMS:
+			console_poll();
+			break;
+		default:
 			break;
-		}
-		
 	}
-	
-	// Handle held key
-	Delay(10);
-	HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4, GPIO_PIN_SET);
-	while (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11) == GPIO_PIN_SET);	
-	Delay(10);
-	
-	// Return character
-	return keymap[row][col];
-		
 }
 
-// Writes to the LCD
-void Write_SR_LCD(uint8_t temp)
+// Screen timer expired, runs from the tick interrupt
+static void screenexpired(void* arg)
+{
+	event_post(EVENT_TIMER, TIMER_SCREEN);
+}
+
+// Clears the screen and writes both lines, leaving the cursor on the bottom
+// one when it is given
+static void show(const char* top, const char* bottom)
 {
-	int i;
-	uint8_t mask=0x80;
-	for(i=0; i<8; i++) {
-		if((temp&mask)==0)
-		GPIOB->ODR&=~(1<<5);
-		else
-		GPIOB->ODR|=(1<<5);
-		
-		/* Sclck */
-		GPIOA->ODR&=~(1<<5);
-		GPIOA->ODR|=(1<<5);
-		Delay(1);
-		mask=mask>>1;
+	Write_Instr_LCD(0x01); // Clear Screen
+	Write_String_LCD((char*)top);
+	if (bottom != NULL) {
+		Write_Instr_LCD(0xC0); // Go to bottom line
+		Write_String_LCD((char*)bottom);
 	}
-	/*Latch*/
-	GPIOA->ODR|=(1<<10);
-	GPIOA->ODR&=~(1<<10);
+}
+
+// Keeps the screen for ms, then calls then
+static void wait(uint32_t ms, void (*then)(void))
+{
+	after = then;
+	state = &waiting;
+	swtimer_start(screentimer, ms, 0);
+}
+
+static void waited(void)
+{
+	after();
+}
+
+// Shows a screen for ms, then calls then
+static void message(const char* top, const char* bottom, uint32_t ms, void (*then)(void))
+{
+	show(top, bottom);
+	wait(ms, then);
+}
+
+// Shows a static screen for ms, then calls then
+static void notice(lcd_screen_id_t screen, uint32_t ms, void (*then)(void))
+{
+	lcd_show(screen);
+	wait(ms, then);
+}
+
 
+// Empties the code being typed
+static void resetentry(void)
+{
+	entry.length = 0;
+	entry.code[0] = '\0';
+	codestore_begin(&codes, &entry.cursor);
+}
+
+// Starts taking a code at the cursor
+static void askcode(bool admin, void (*done)(void))
+{
+	resetentry();
+	entry.admin = admin;
+	entry.done = done;
+	entry.back = NULL;
+	state = &entering;
 }
 
+// Blanks characters left of the cursor, ending where the first one was
+static void erase(int count)
+{
+	for (int i = 0; i < count; i++) {
+		Write_Instr_LCD(0x10); // Move cursor left
+		Write_Char_LCD(' '); // Print space
+		Write_Instr_LCD(0x10); // Move cursor left
+	}
+}
+
+// Handles one key of code entry
+static void entrykey(unsigned char key)
+{
+	uint8_t temp1 = 0, temp2 = 0;
+
+	switch (key) {
+		case '*': // Do nothing (unused)
+			break;
+		case '#': // Do nothing (unused)
+			break;
+		case 'A': // Enter
+			if (entry.length >= CODESTORE_MIN) { // Confirms a full passcode is entered
+				if (verdict() == 2 && entry.admin == false) { // If admin code is not an option, inform user
+					erase(entry.length);
+					Write_String_LCD("INVALID CODE");
+					wait(1250, changecode);
+				} else {
+					entry.done();
+				}
+			}
+			break;
+		case 'B': // Backspace
+			if (entry.length > 0) {
+				erase(1);
+				entry.length--;
+				entry.code[entry.length] = '\0'; // Remove character from array
+				codestore_pop(&codes, &entry.cursor);
+			} else if (entry.back != NULL) {
+				entry.back();
+			}
+			break;
+		case 'C': // Clear
+			while (entry.length > 0) { // Loop for all characters
+				erase(1);
+				entry.length--;
+			}
+			resetentry();
+			break;
+		case 'D': // Toggles Password Protection
+			if (seecode == 0) {
+				temp1 = entry.length - 1;
+				temp2 = entry.length;
+				while (temp2 != 0) {
+					Write_Instr_LCD(0x10); // Move cursor left
+					Write_Char_LCD(entry.code[temp1]); // Prints Character for spot
+					Write_Instr_LCD(0x10); // Move cursor left
+					temp1--;
+					temp2--;
+				}
+				while (temp2 < entry.length) {
+					Write_Instr_LCD(0x14); // Moves back to the far right
+					temp2++;
+				}
+				seecode = 1; // Toggles see code to showing code
+			} else if (seecode == 1) {
+				temp2 = entry.length;
+				while (temp2 > 0) { // Moves cursor to the far left
+					Write_Instr_LCD(0x10);
+					temp2--;
+				}
+				while (temp2 < entry.length) { // Censors password on all characters
+					Write_Char_LCD('*');
+					temp2++;
+				}
+				seecode = 0; // Toggles see code to censoring code
+			}
+			break;
+		default:
+			if (entry.length < CODESTORE_MAX) {
+				Write_Char_LCD(seecode == 0 ? '*' : key); // Censored unless shown with D
+				entry.code[entry.length] = key; // Add character to array
+				codestore_push(&codes, &entry.cursor, key); // Narrow the candidates now, so A has nothing to look up
+				entry.length++;
+				entry.code[entry.length] = '\0';
+			}
+			break;
+	}
+}
 
-// Sets up the nibbles for writing to LCD
-void LCD_nibble_write(uint8_t temp, uint8_t s)
+// Second half of the admin code warning
+static void changecode(void)
 {
-	/*writing instruction*/
-	if (s==0){
-		temp=temp&0xF0;
-		temp=temp|0x02; /*RS (bit 0) = 0 for Command EN (bit1)=high */
-		Write_SR_LCD(temp);
-		temp=temp&0xFD; /*RS (bit 0) = 0 for Command EN (bit1) = low*/
-		Write_SR_LCD(temp); }
-	/*writing data*/
-	else if (s==1) {
-		temp=temp&0xF0;
-		temp=temp|0x03; /*RS(bit 0)=1 for data EN (bit1) = high*/
-		Write_SR_LCD(temp);
-		temp=temp&0xFD; /*RS(bit 0)=1 for data EN(bit1) = low*/
-		Write_SR_LCD(temp);
-}}
-
-// Writes instructions to LCD
-void Write_Instr_LCD(uint8_t code)
+	erase(12);
+	Write_String_LCD("CHANGE CODE");
+	wait(1250, retype);
+}
+
+// Warning over, take the code again
+static void retype(void)
 {
-	LCD_nibble_write(code&0xF0,0);
-	code=code<<4;
-	LCD_nibble_write(code,0);
+	erase(11);
+	resetentry();
+	state = &entering;
 }
 
 
-// Writes characters to LCD
-void Write_Char_LCD(uint8_t code)
+// Start up screen, then straight to locked if codes were saved
+static void splash(void)
 {
-	LCD_nibble_write(code&0xF0,1);
-	code=code<<4;
-	LCD_nibble_write(code,1);
+	lcd_show(LCD_SCREEN_SPLASH);
+	wait(1500, codestore_total(&codes) > 0 ? locked : firstcode);
 }
 
+// Ask for initial code
+static void firstcode(void)
+{
+	lcd_show(LCD_SCREEN_ENTER);
+	askcode(false, initialcode);
+}
+
+// Default to locked, waiting for code entry
+static void locked(void)
+{
+	lcd_show(LCD_SCREEN_LOCKED); // Locked, cursor on the bottom line
+	setleds(GPIO_PIN_SET); // Turn on LEDS
+	askcode(true, checkentry);
+}
 
-// Writes strings to LCD
-void Write_String_LCD(char *temp)
+// Check code against others
+static void checkentry(void)
 {
-	int i=0;
-	while(temp[i]!=0)
-	{
-		Write_Char_LCD(temp[i]);
-		i=i+1;
+	switch (verdict()) {
+		case 0: // Incorrect Code
+			invalid();
+			break;
+		case 1: // Correct Code
+			unlocked();
+			break;
+		case 2: // Admin Code
+			admin();
+			break;
 	}
 }
 
+// Incorrect code, flash and buzz
+static void invalid(void)
+{
+	lcd_show(LCD_SCREEN_INVALID);
+	flashleds(true); // Start flashing
+	alarm_tone(ALARM_TONE_HZ, 3500); // Buzz speaker
+	wait(3500, locked); // Locked screen stops the flashing
+}
+
+// Correct code, count down from 10
+static void unlocked(void)
+{
+	lcd_show(LCD_SCREEN_UNLOCKED); // Unlocked, counting from 10
+	setleds(GPIO_PIN_RESET); // Turn off LEDS
+	count = 9;
+	wait(1000, countdown);
+}
 
-// Detects if a key is pressed
-bool iskeypressed(void)
+// One second of the countdown, then the unlock count
+static void countdown(void)
 {
-	// Setting all columns high
-	HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4, GPIO_PIN_SET);
-	
-	// Detecting if a key is pressed
-	if (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11) == GPIO_PIN_RESET) {
-		return false;
-	} else {
-		return true;
+	char num[3], unlocks[16];
+
+	if (count > 0) {
+		Write_Instr_LCD(0x10); // Decrement cursor
+		Write_Instr_LCD(0x10);
+		Write_String_LCD("  "); // Erase previous output
+		Write_Instr_LCD(0x10); // Decrement cursor
+		Write_Instr_LCD(0x10);
+		snprintf(num, 3, "0%d", count); // Convert count to string
+		Write_String_LCD(num); // Write count
+		count--;
+		wait(1000, countdown);
+		return;
 	}
+	unlockedcount++;
+	snprintf(unlocks, 16, "%d", unlockedcount); // Convert count to string
+	message("# OF UNLOCKS:", unlocks, 1500, locked);
 }
 
 
-// Handles code entry
-void codeentry(char* entry, bool admin)
+// Admin code entered
+static void admin(void)
 {
-	char keypressed;
-	uint8_t length = 0, admincode = 0, temp1 = 0, temp2 = 0;
-	char* line;
+	lcd_show(LCD_SCREEN_ADMIN);
+	setleds(GPIO_PIN_RESET); // Turn off LEDS
+	menuitem = 1;
+	wait(1500, menu);
+}
 
-	
-	while (1) { // Breaks when user hits A
-		keypressed = detectkey(); // Wait for input
-		switch (keypressed) {
-				case '*': // Do nothing (unused)
-					break;
-				case '#': // Do nothing (unused)
-					break;
-				case 'A': // Enter
-					if (length == 4) { // Confirms full passcode is entered
-						for (int i = 0; i < 4; i++) { // Checks for admin code
-							if (entry[i] == ADMIN[i]) {
-								admincode++;
-							}
-						}
-						if (admincode == 4 && admin == false) { // If admin code is not an option, inform user
-							for (int i = 0; i < 4; i++) {
-								Write_Instr_LCD(0x10); // Move cursor left
-								Write_Char_LCD(' '); // Print space
-								Write_Instr_LCD(0x10); // Move cursor left
-							}
-							line = "INVALID CODE";
-							Write_String_LCD(line);
-							Delay(1250);
-							for (int i = 0; i < 12; i++) {
-								Write_Instr_LCD(0x10); // Move cursor left
-								Write_Char_LCD(' '); // Print space
-								Write_Instr_LCD(0x10); // Move cursor left
-							}
-							line = "CHANGE CODE";
-							Write_String_LCD(line);
-							Delay(1250);
-							for (int i = 0; i < 11; i++) {
-								Write_Instr_LCD(0x10); // Move cursor left
-								Write_Char_LCD(' '); // Print space
-								Write_Instr_LCD(0x10); // Move cursor left
-							}
-							admincode = 0;
-							length = 0;
-						} else {
-							return;
-						}
-					}
+// Shows the selected admin option
+static void menu(void)
+{
+	lcd_show((lcd_screen_id_t)(LCD_SCREEN_MENU1 + menuitem - 1));
+	state = &menuing;
+}
+
+static void menukey(unsigned char key)
+{
+	switch (key) {
+		case 'A': // Select
+			switch (menuitem) { // Handles selection based on state
+				case 1: // Display Codes
+					viewcodes();
 					break;
-				case 'B': // Backspace
-					if (length > 0) {
-						Write_Instr_LCD(0x10); // Move cursor left
-						Write_Char_LCD(' '); // Print space
-						Write_Instr_LCD(0x10); // Move cursor left
-						length--;
-						entry[length] = ' '; // Remove character from array
-					}
+				case 2: // Add Codes
+					addcodes();
 					break;
-				case 'C': // Clear
-					while (length > 0) { // Loop for all characters
-						Write_Instr_LCD(0x10); // Move cursor left
-						Write_Char_LCD(' '); // Print space
-						Write_Instr_LCD(0x10); // Move cursor left
-						length--;
-						entry[length] = ' '; // Remove character from array
-					}
+				case 3: // Remove Codes
+					removecodes();
 					break;
-				case 'D': // Toggles Password Protection
-					if (seecode == 0) {
-					temp1 = length - 1;
-					temp2 = length;
-						while (temp2 != 0) { 
-								Write_Instr_LCD(0x10); // Move cursor left
-								Write_Char_LCD(entry[temp1]); // Prints Character for spot
-								Write_Instr_LCD(0x10); // Move cursor left
-								temp1--;
-								temp2--;
-							}
-							while (temp2 < length) {
-								Write_Instr_LCD(0x14); // Moves back to the far right
-								temp2++;
-							}
-							seecode = 1; // Toggles see code to showing code
-						}
-						else if (seecode == 1) {
-							temp2 = length;
-							while (temp2 > 0) { // Moves cursor to the far left
-								Write_Instr_LCD(0x10);
-								temp2--;
-							}
-							while (temp2 < length) { // Censors password on all characters
-									Write_Char_LCD('*');
-									temp2++;
-							}
-							seecode = 0; // Toggles see code to censoring code
-						}
+				case 4: // Clear Codes
+					clearcodes();
 					break;
-				default:
-					if (seecode == 0) {
-						if (length < 4) {
-							Write_Char_LCD('*'); // Write censored character when censored
-							entry[length] = keypressed; // Add character to array
-							length++;
-						}
-					}
-					else if (seecode == 1){
-						if (length < 4) {
-							Write_Char_LCD(keypressed); // Write pressed character when uncensored
-							entry[length] = keypressed; // Add character to array
-							length++;
-						}						
-					}
+				case 5: // Bulk Add
+					bulkcodes();
 					break;
 			}
+			break;
+		case 'B': // Back
+			locked();
+			break;
+		case '#': // Next
+			if (menuitem < 5) {
+				menuitem++;
+			} else {
+				menuitem = 1;
+			}
+			menu();
+			break;
 	}
 }
 
-
-// Sets led states
-void setleds(GPIO_PinState state)
+// Sorts the codes into the browser's index and starts at the first,
+// drawing from a cleared screen next time
+static void openbrowser(const char* hint)
 {
-	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_0, state);
-	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_1, state);
-	HAL_GPIO_WritePin(GPIOC, GPIO_PIN_7, state);
-	HAL_GPIO_WritePin(GPIOC, GPIO_PIN_8, state);
+	codestore_index(&codes, &browser.index);
+	browser.position = 0;
+	browser.width = 3;
+	for (int n = 1000; browser.index.total >= n; n *= 10) {
+		browser.width++;
+	}
+	codestore_begin(&codes, &browser.typed);
+	browser.query[0] = '\0';
+	browser.jumping = false;
+	browser.missed = false;
+	browser.hint = hint;
+	browser.drawn = false;
 }
 
+// Sorts the codes again if the console changed them while the browser was
+// open, keeping the position in range and the removal count in step
+static void freshen(void)
+{
+	uint8_t width = 3;
 
-// Flashes LED with SysTick
-void flashleds(bool state)
+	if (codestore_current(&codes, &browser.index) == true) {
+		return;
+	}
+	codestore_index(&codes, &browser.index);
+	if (browser.position >= browser.index.total) {
+		browser.position = browser.index.total > 0 ? browser.index.total - 1 : 0;
+	}
+	for (int n = 1000; browser.index.total >= n; n *= 10) {
+		width++;
+	}
+	if (width != browser.width) {
+		browser.width = width;
+		browser.drawn = false;
+	}
+	totalremoved = codes.marked;
+}
+
+// Writes text at a DDRAM address unless it is already there, blanking what
+// is left of the field's previous text
+static void field(char* shown, uint8_t addr, const char* text)
 {
-	if (state == true) {
-		SysTick_Initialize(SystemCoreClock/2);
-	} else {
-		SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk; // Disable Interrupt
-		SysTick->VAL = 0; // Reset Counter
+	int blank = (int)strlen(shown) - (int)strlen(text);
+
+	if (strcmp(shown, text) == 0) {
+		return;
+	}
+	Write_Instr_LCD(0x80 | addr); // Go to the field
+	Write_String_LCD((char*)text);
+	for (int i = 0; i < blank; i++) {
+		Write_Char_LCD(' ');
 	}
+	strcpy(shown, text);
 }
 
-// Validates codes (2 = Admin, 1 = Correct, 0 = Incorrect)
-uint8_t checkcode(char* entry, char codes[][4], uint16_t total) 
+// Writes the code browser: mark, index and code on top, keys or the digits
+// typed below. Only fields that changed are redrawn.
+static void drawcode(const char* mark)
 {
-	// Checking for admin code
-	for (int j = 0; j < 4; j++) { // compares each character of the codes
-		if (ADMIN[j] == entry[j] && j != 3) { // checks first three characters
-			continue; // continues to next character if correct
-		} else if (ADMIN[j] == entry[j] && j == 3) {
-			return 2; // Return 2 for admin code
-		} else {
-			break;
-		}
+	char number[8], line[17], code[CODESTORE_MAX + 1];
+	int length;
+
+	freshen();
+	if (browser.drawn == false) {
+		Write_Instr_LCD(0x01); // Clear Screen
+		memset(browser.shown, 0, sizeof(browser.shown));
+		browser.drawn = true;
 	}
-	
-	
-	// Checking against all available codes
-	for (int i = 0; i < total; i++) { // loops for length of total OR until code is found
-		for (int j = 0; j < 4; j++) { // compares each character of the codes
-			if (codes[i][j] == entry[j] && j != 3) { // checks first three characters
-				continue; // continues to next character if correct
-			} else if (codes[i][j] == entry[j] && j == 3) {
-				return 1; // Return 1 for correct
-			} else {
-				break;
-			}
+
+	// Index with at least 3 digits, code after it spaced out if the line has room
+	snprintf(number, sizeof(number), "%0*u", browser.width < 5 ? browser.width : 5, (unsigned)browser.position + 1); // A uint16_t index takes 5 at most
+	codestore_code(codestore_at(&codes, &browser.index, browser.position), code);
+	if (1 + browser.width + 2 + 2 * strlen(code) <= 16) {
+		length = snprintf(line, sizeof(line), " =");
+		for (int i = 0; code[i] != '\0' && length + 2 < (int)sizeof(line); i++) {
+			line[length++] = ' ';
+			line[length++] = code[i];
 		}
+		line[length] = '\0';
+	} else {
+		snprintf(line, sizeof(line), "=%s", code);
 	}
+	field(browser.shown[0], 0x00, mark);
+	field(browser.shown[1], 0x01, number);
+	field(browser.shown[2], 1 + browser.width, line);
 
-	// If no codes match
-	return 0;
+	// Options, or what is being looked for
+	if (browser.missed == true) {
+		snprintf(line, sizeof(line), "NONE %s%s", browser.jumping ? "#" : "", browser.query);
+	} else if (browser.jumping == true) {
+		snprintf(line, sizeof(line), "GO TO #%.9s", browser.query); // Never more than width digits
+	} else if (browser.typed.digits > 0) {
+		snprintf(line, sizeof(line), "FIND %s", browser.query);
+	} else {
+		snprintf(line, sizeof(line), "%s", browser.hint);
+	}
+	field(browser.shown[3], 0x40, line);
 }
 
-// Add/Removes codes (TRUE = ADD, FALSE = RMV)
-uint16_t editcodes(char codes[][4], uint16_t total, bool mode)
+// Keys both browsers share: * and # step back and forward, wrapping at the
+// ends, digits go to the first code starting with them, D switches the
+// digits to an index to go to, and C drops the digits typed
+static bool browsekey(unsigned char key)
 {
-	char key = ' ', ctostr[2] = {' '};
-	char* line = "";
-	char linearr[4], num[1] = {' '};
-	char entry[4] = {' ', ' ', ' ', ' '};
-	bool removing[CODESIZE];
-	int totalremoved = 0, current = 1;
-	
-	if (mode == true) { // ADD mode
-		
-		
-		while (key != 'B') { //Runs until user hits B
-			
-			if (total >= CODESIZE) {
-				Write_Instr_LCD(0x01); // Clear Screen
-				line = "MAX CODES";
-				Write_String_LCD(line); // Write line
-				Write_Instr_LCD(0xC0); // Go to bottom line
-				line = "REACHED";
-				Write_String_LCD(line); // Write line
-				Delay(2000);
-				Write_Instr_LCD(0x01); // Clear Screen
-				return total;
-			}
-			
-			
-			
-			Write_Instr_LCD(0x01); // Clear Screen
-			line = "Enter Code:";
-			Write_String_LCD(line); // Write line
-			Write_Instr_LCD(0xC0); // Go to bottom line
-			
-			// Wait for code entry
-			codeentry(entry, false);
-			
-			// Save code, increment total
-			for (int i = 0; i < 4; i++) {
-				codes[total][i] = entry[i];
-			}
-			total++;
-			
-			//Display total codes
-			Write_Instr_LCD(0x01); // Clear Screen
-			line = "Total Codes:";
-			Write_String_LCD(line); // Write line
-			Write_Instr_LCD(0xC0); // Go to bottom line
-			snprintf(linearr, 4, "%d", total); // Convert total to string
-			Write_String_LCD(linearr); // Print total
-			line = "/";
-			Write_String_LCD(line);
-			snprintf(linearr, 4, "%d", CODESIZE); // Convert CODESIZE to string
-			Write_String_LCD(linearr); // Print CODESIZE
-			Delay(1000);
-			
-			// Ask if the user would like to add more codes
-			Write_Instr_LCD(0x01); // Clear Screen
-			line = "Add another?";
-			Write_String_LCD(line); // Write line
-			Write_Instr_LCD(0xC0); // Go to bottom line
-			line = "A=Yes       B=No";
-			Write_String_LCD(line);
-			
-			// Get input + Validate
-			do {
-				key = detectkey();
-			} while (key != 'A' && key != 'B');
-		}
-	} else { // RMV mode
-		
-		// Clearing Removing Array
-		for (int i = 0; i < CODESIZE; i++) {
-			removing[i] = false;
-		}
-		
-		Write_Instr_LCD(0x01); // Clear Screen
-		line = "SELECT CODES TO";
-		Write_String_LCD(line); // Write line
-		Write_Instr_LCD(0xC0); // Go to bottom line
-		line = "REMOVE";
-		Write_String_LCD(line); // Write line
-		Delay(1500);
-		Write_Instr_LCD(0x01); // Clear Screen
-		line = "WHEN DONE,";
-		Write_String_LCD(line); // Write line
-		Write_Instr_LCD(0xC0); // Go to bottom line
-		line = "PRESS C";
-		Write_String_LCD(line); // Write line
-		Delay(1500);
-		
-		while (key != 'C') { // Handles menu navigation + user input
-			Write_Instr_LCD(0x01); // Clear Screen
-			
-			// Convert current to string
-			if (current > 9) {
-				snprintf(linearr, 4, "0%d", current);
-			}	else if (current < 10) {
-				snprintf(linearr, 4, "00%d", current);
-			} else if (current > 99) {
-				snprintf(linearr, 4, "%d", current); 
-			}
-			
-			// Place current code and index into line
-			if (removing[current-1] == false) { // Not marked for removal
-				// Place current code and index into line
-				line = "#";
-			} else { // Marked for removal
-					line = "X";
+	uint16_t total;
+	int found;
+
+	freshen();
+	total = browser.index.total;
+	switch (key) {
+		case '*':
+			browser.position = browser.position == 0 ? total - 1 : browser.position - 1;
+			break;
+		case '#':
+			browser.position = browser.position + 1 >= total ? 0 : browser.position + 1;
+			break;
+		case 'D':
+			browser.jumping = !browser.jumping;
+			break;
+		case 'C':
+			if (browser.typed.digits == 0 && browser.jumping == false) {
+				return false; // Nothing typed, C is the screen's own
 			}
-			Write_String_LCD(line);
-			Write_String_LCD(linearr);
-			Write_String_LCD(" =");
-			for (int i = 0; i < 4; i++) {
-				ctostr[0] = codes[current-1][i];
-				ctostr[1] = '\0';
-				Write_String_LCD(" ");
-				Write_String_LCD(ctostr);
+			browser.jumping = false;
+			break;
+		default:
+			if (key < '0' || key > '9') {
+				return false;
 			}
-			
-			// Write options
-			Write_Instr_LCD(0xC0); // Go to bottom line
-			line = "A=SEL C=DONE #=>";
-			Write_String_LCD(line); // Write line
-			
-			// Input validation
-			do {
-				key = detectkey();
-			} while (key != '*' && key != 'A' && key != 'B' && key != '#' && key != 'C');
-			
-			switch (key) {
-				case '*':
-					if (current == 1) {
-						current = total;
-					} else {
-						current--;
-					}
-					break;
-				case '#':
-					if (current == total) {
-						current = 1;
-					} else {
-						current++;
-					}
-					break;
-				case 'A':
-					if (removing[current-1] == false) {
-						removing[current-1] = true;
-						totalremoved++;
-					}
-					break;
-				case 'B':
-					if (removing[current-1] == true) {
-						removing[current-1] = false;
-						totalremoved--;
-					}
-					break;
-				case 'C':
-						// Do nothing, while loop will end
-					break;
+			if (browser.typed.digits == (browser.jumping ? browser.width : CODESTORE_MAX)) {
+				return true; // Full, the digits typed stand
 			}
-		}
-		
-		// Remove message
-		Write_Instr_LCD(0x01); // Clear Screen
-		line = "REMOVING:";
-		Write_String_LCD(line); // Write line
-		Write_Instr_LCD(0xC0); // Go to bottom line
-		snprintf(linearr, 4, "%d", totalremoved);
-		Write_String_LCD(linearr);
-		Write_String_LCD(" CODES");
-		Delay(1500);
-		
-		// Removing marked codes
-		for (int i = 0; i < totalremoved; i++) { // Runs once for each code marked
-			
-			// Search for index of a marked code
-			for (int j = 0; j < total; j++) { 
-				if (removing[j] == true) {
-					current = j;
-					break;
-				}
+			codestore_push(&codes, &browser.typed, key);
+			browser.query[browser.typed.digits - 1] = key;
+			browser.query[browser.typed.digits] = '\0';
+			if (browser.jumping == true) {
+				found = browser.typed.value >= 1 && browser.typed.value <= total ? (int)browser.typed.value - 1 : -1;
+			} else {
+				found = codestore_seek(&codes, &browser.index, &browser.typed);
 			}
-			
-			// Shuffle codes to erase marked code
-			if (current != (total-1)) { // Makes sure marked code is not last code in array
-				for (int j = current; j < total-1; j++) { // Shuffling
-						for (int k = 0; k < 4; k++) {
-							codes[j][k] = codes[j+1][k];
-						}
-				}
-				total--; // Adjust total
-			} else { // Marked is last
-				total--; // Adjust total
+			browser.missed = found < 0;
+			if (found >= 0) {
+				browser.position = (uint16_t)found;
 			}
-			
-		}
-		Write_Instr_LCD(0x01); // Clear Screen
-		line = "REMOVED";
-		Write_String_LCD(line); // Write line
-		Write_Instr_LCD(0xC0); // Go to bottom line
-		line = "";
-		snprintf(linearr, 4, "%d", totalremoved);
-		Write_String_LCD(linearr);
-		Write_String_LCD(" CODES");
-		Delay(1500);
-		
-		
-		// Checking if 0 codes left
-		if (total == 0) {
-			
-			// Inform user
-			Write_Instr_LCD(0x01); // Clear Screen
-			line = "0 CODES REMAIN";
-			Write_String_LCD(line); // Write line
-			Delay(1500);
-			Write_Instr_LCD(0x01); // Clear Screen
-			
-			// Ask for new code
-			line = "Enter New Code:";
-			Write_String_LCD(line);
-			Write_Instr_LCD(0xC0); // Go to bottom line
-
-			// Wait for new code
-			codeentry(entry, false);
-
-			//save initial code
-			for (int i = 0; i < 4; i++) {
-				codes[0][i] = entry[i];
+			return true;
+	}
+
+	// Any other browser key starts the digits over
+	codestore_begin(&codes, &browser.typed);
+	browser.query[0] = '\0';
+	browser.missed = false;
+	return true;
+}
+
+// Display available codes
+static void viewcodes(void)
+{
+	openbrowser("<=*  B=BACK  #=>");
+	drawcode("#");
+	state = &viewing;
+}
+
+static void viewkey(unsigned char key)
+{
+	switch (key) {
+		case 'B':
+			menu();
+			break;
+		default:
+			if (browsekey(key) == true) {
+				drawcode("#");
 			}
-			total++;
-		}
-		
+			break;
 	}
-	
-	Write_Instr_LCD(0x01); // Clear Screen
-	
-	// Update main total via return
-	return total;
 }
 
-// Add/Removes codes
-void clearcodes(char codes[][4])
+// Add codes, one per pass until the user says no
+static void addcodes(void)
 {
-	char* line;
-	char entry[4], key = ' ';
-	
-	// Confirm Clear
-	Write_Instr_LCD(0x01); // Clear Screen
-	line = "Clear codes?";
-	Write_String_LCD(line);
-			
-	// Write options
-	Write_Instr_LCD(0xC0); // Go to bottom line
-	line = "A=Yes B=No";
-	Write_String_LCD(line); // Write line
-	
-	// Input validation
-	do {
-		key = detectkey();
-	} while (key != 'A' && key != 'B');
-	
-	if (key == 'B') { // If B, cancel operation
+	if (codestore_total(&codes) >= CODESIZE) {
+		notice(LCD_SCREEN_MAXCODES, 2000, menu);
 		return;
 	}
-	
-	// Inform user
-	Write_Instr_LCD(0x01); // Clear Screen
-	line = "Clearing codes.";
-	Write_String_LCD(line); // Write line
-	Delay(1500);
-	
-	// Obtain new code
-	Write_Instr_LCD(0x01); // Clear Screen
-	line = "0 CODES REMAIN";
-	Write_String_LCD(line); // Write line
-	Delay(1500);
-	Write_Instr_LCD(0x01); // Clear Screen
-	
-	// Ask for new code
-	line = "Enter New Code:";
-	Write_String_LCD(line);
-	Write_Instr_LCD(0xC0); // Go to bottom line
+	lcd_show(LCD_SCREEN_ENTER);
+	askcode(false, added);
+}
 
-	// Wait for new code
-	codeentry(entry, false);
+// Save code, rejecting duplicates, then display total codes
+static void added(void)
+{
+	char linearr[12];
 
-	//save initial code
-	for (int i = 0; i < 4; i++) {
-		codes[0][i] = entry[i];
+	if (codestore_add(&codes, entry.code) == false) {
+		notice(LCD_SCREEN_EXISTS, 1500, addcodes);
+		return;
 	}
-	
+	journal_add(entry.code);
+	snprintf(linearr, 12, "%d/%d", codestore_total(&codes), CODESIZE);
+	message("Total Codes:", linearr, 1000, askanother);
 }
 
-// Display available codes
-void displaycodes(char codes[][4], uint16_t total)
+// Ask if the user would like to add more codes
+static void askanother(void)
 {
-	int current = 1;
-	char key = ' ';
-	char linearr[4], ctostr[2];
-	char* line;
-	
-	while (key != 'B') { // Handles menu navigation + user input
-		Write_Instr_LCD(0x01); // Clear Screen
-		
-		// Convert current to string
-		if (current > 9) {
-			snprintf(linearr, 4, "0%d", current);
-		} else if (current > 99) {
-			snprintf(linearr, 4, "%d", current); 
-		} else {
-			snprintf(linearr, 4, "00%d", current);
-		}
-		
-		// Write current code and index
-		line = "#";
-		Write_String_LCD(line);
-		Write_String_LCD(linearr);
-		Write_String_LCD(" =");
-		for (int i = 0; i < 4; i++) {
-			ctostr[0] = codes[current-1][i];
-			ctostr[1] = '\0';
-			Write_String_LCD(" ");
-			Write_String_LCD(ctostr);
-		}
+	lcd_show(LCD_SCREEN_ANOTHER);
+	state = &asking;
+}
 
-		
-		// Write options
-		Write_Instr_LCD(0xC0); // Go to bottom line
-		line = "<=*  B=BACK  #=>";
-		Write_String_LCD(line); // Write line
-		
-		// Input validation
-		do {
-			key = detectkey();
-		} while (key != '*' && key != 'B' && key != '#');
-		
-		switch (key) {
-			case '*':
-				if (current == 1) {
-					current = total;
-				} else {
-					current--;
-				}
-				break;
-			case '#':
-				if (current == total) {
-					current = 1;
-				} else {
-					current++;
-				}
-				break;
-			case 'B':
-				// Do nothing
-				break;
-		}
+static void another(unsigned char key)
+{
+	if (key == 'A') {
+		addcodes();
+	} else if (key == 'B') {
+		menu();
 	}
-	return;
 }
 
-// Buzzes speaker for given time in ms
-void buzz(int time)
+// Remove codes picked from the browser
+static void removecodes(void)
 {
-	while (time > 0) {
-		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_9, GPIO_PIN_SET); // Enable buzzer
-		Delay(2);
-		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_9, GPIO_PIN_RESET); // Disable buzzer
-		Delay(2);
-		time-=4; // Decrement time
+	codestore_unmark(&codes);
+	totalremoved = 0;
+	openbrowser("A=SEL C=DONE #=>"); // Start at the first code
+	notice(LCD_SCREEN_SELECT, 1500, removehint);
+}
+
+static void removehint(void)
+{
+	notice(LCD_SCREEN_DONEHINT, 1500, browse);
+}
+
+// Shows the current code, X if it is marked for removal
+static void browse(void)
+{
+	char code[CODESTORE_MAX + 1];
+
+	freshen();
+	codestore_code(codestore_at(&codes, &browser.index, browser.position), code);
+	drawcode(codestore_marked(&codes, code) ? "X" : "#");
+	state = &selecting;
+}
+
+static void removekey(unsigned char key)
+{
+	char code[CODESTORE_MAX + 1], linearr[12];
+
+	if (browsekey(key) == true) {
+		browse();
+		return;
+	}
+	codestore_code(codestore_at(&codes, &browser.index, browser.position), code);
+	switch (key) {
+		case 'A':
+			if (codestore_mark(&codes, code, true) == true) {
+				totalremoved++;
+			}
+			break;
+		case 'B':
+			if (codestore_mark(&codes, code, false) == true) {
+				totalremoved--;
+			}
+			break;
+		case 'C':
+			snprintf(linearr, 12, "%d CODES", totalremoved);
+			message("REMOVING:", linearr, 1500, removed);
+			return;
+		default:
+			return;
 	}
+	browse();
 }
 
-// Creates a delay in ms
-void Delay(int delay)
+// Journals one code the sweep removed
+static void forget(const char* code)
+{
+	journal_remove(code);
+}
+
+// Removing marked codes, all in one pass
+static void removed(void)
 {
-	delay = delay * (SystemCoreClock/5000);
-	for (int n = 0; n < delay; n++)
-	{
-		__asm("nop");
+	char linearr[12];
+
+	snprintf(linearr, 12, "%d CODES", codestore_sweep(&codes, forget));
+	message("REMOVED", linearr, 1500, remaining);
+}
+
+// Checking if 0 codes left
+static void remaining(void)
+{
+	if (codestore_total(&codes) == 0) {
+		notice(LCD_SCREEN_NOCODES, 1500, newcode);
+	} else {
+		menu();
 	}
 }
 
-// Handles Admin State
-uint16_t adminmenu(char codes[][4], uint16_t total)
+// Bulk enrollment: codes typed back to back with no screens in between,
+// the journal writing them out in batches
+static void bulkcodes(void)
 {
-	char* line = "";
-	uint8_t state = 1;
-	unsigned char key = ' ';
-	
-	Write_Instr_LCD(0x01); // Clear Screen
-	line = "ADMIN";
-	Write_String_LCD(line); // Write admin
-	setleds(GPIO_PIN_RESET); // Turn off LEDS
-	Delay(1500);
-	
-	while (key != 'B') {
-		Write_Instr_LCD(0x01); // Clear Screen
-		switch (state) { // Handle displaying options
-			case 1:
-				line = "1 - View Codes";
-				Write_String_LCD(line);
-				break;
-			case 2: 
-				line = "2 - Add Codes";
-				Write_String_LCD(line);
-				break;
-			case 3:
-				line = "3 - Remove Codes";
-				Write_String_LCD(line);
-				break;
-			case 4:	
-				line = "4 - Clear Codes";
-				Write_String_LCD(line);
-				break;
-		}
-		// Write hotkeys
-		Write_Instr_LCD(0xC0); // Go to bottom line
-		line = "A=SEL B=BACK #=>";
-		Write_String_LCD(line);
-		
-		do { // Take input + Validate
-			key = detectkey();
-		} while (key != 'A' && key != 'B' && key != '#');
-		
-		switch (key) { // Handle input
-			case 'A': // Select
-				switch (state) { // Handles selection based on state
-					case 1: // Display Codes
-						displaycodes(codes, total);
-						break;
-					case 2: // Add Codes
-						total = editcodes(codes, total, true); 
-						break;
-					case 3: // Remove Codes
-						total = editcodes(codes, total, false);
-						break;
-					case 4:	// Clear Codes
-						clearcodes(codes);
-						total = 1;
-						break;
-				}
-				break;
-			case 'B': // Back
-				return total; // Return to main
-			case '#': // Next
-				if (state < 4) {
-					state++;
-				} else {
-					state = 1;
-				}
-				break;
-		}	
+	if (codestore_total(&codes) >= CODESIZE) {
+		notice(LCD_SCREEN_MAXCODES, 2000, menu);
+		return;
 	}
-	
-	// Fallback return statement
-	return total;
+	bulkadded = 0;
+	journal_begin();
+	bulkline("B=END");
 }
 
-// Initializes and sets systick timing
-void SysTick_Initialize(uint32_t ticks)
+static void bulkline(const char* status)
 {
-  SysTick->LOAD = ticks;
-  SysTick->VAL = 0;
+	char linearr[19]; // Status and two uint16_t counts at their widest, 16 shown
 
-  // Select processor clock to internal: 1 = processor clock; 0 = external clock
-  SysTick->CTRL |= SysTick_CTRL_CLKSOURCE_Msk;
+	snprintf(linearr, sizeof(linearr), "%-6.6s %u/%u", status, (unsigned)codestore_total(&codes), (uint16_t)CODESIZE);
+	show(linearr, "");
+	askcode(false, bulkadd);
+	entry.back = bulkend; // B on an empty line ends
+}
 
-  // Enable counting of SysTick
-  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+// Saves the code typed, rejecting duplicates, and takes the next one. The
+// cursor looked the code up as its last digit went in.
+static void bulkadd(void)
+{
+	codestore_refresh(&codes, &entry.cursor);
+	if (codestore_found(&entry.cursor) == true || codestore_add(&codes, entry.code) == false) {
+		bulkline("EXISTS");
+		return;
+	}
+	journal_add(entry.code);
+	bulkadded++;
+	if (codestore_total(&codes) >= CODESIZE) {
+		bulkend();
+		return;
+	}
+	bulkline("ADDED");
+}
 
-  // Enables SysTick interrupt
-  SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+// Commits the adds still held back and shows how many went in
+static void bulkend(void)
+{
+	char linearr[12];
+
+	journal_commit();
+	snprintf(linearr, 12, "%d CODES", bulkadded);
+	message(codestore_total(&codes) >= CODESIZE ? "FULL, ADDED" : "ADDED", linearr, 1500, menu);
 }
 
+// Confirm Clear
+static void clearcodes(void)
+{
+	lcd_show(LCD_SCREEN_CLEAR);
+	state = &confirming;
+}
 
+static void clearkey(unsigned char key)
+{
+	if (key == 'A') {
+		notice(LCD_SCREEN_CLEARING, 1500, cleared);
+	} else if (key == 'B') { // If B, cancel operation
+		menu();
+	}
+}
 
-// Handles Flashing LEDS with SysTick
-void SysTick_Handler(void)
+static void cleared(void)
 {
-	HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_0 | GPIO_PIN_1);
-	HAL_GPIO_TogglePin(GPIOC, GPIO_PIN_7 | GPIO_PIN_8);
+	notice(LCD_SCREEN_NOCODES, 1500, newcode);
 }
 
+// Ask for new code
+static void newcode(void)
+{
+	lcd_show(LCD_SCREEN_NEWCODE);
+	askcode(false, replacecodes);
+}
+
+// Save the first code, then lock. Codes the console may have added in the
+// meantime are kept.
+static void initialcode(void)
+{
+	if (codestore_add(&codes, entry.code) == true) {
+		journal_add(entry.code);
+	}
+	locked();
+}
+
+// Save the new code as the only one, back to the menu
+static void replacecodes(void)
+{
+	codestore_clear(&codes);
+	codestore_add(&codes, entry.code);
+	journal_clear(entry.code);
+	menu();
+}
+
+
+// Sets led states
+void setleds(GPIO_PinState state)
+{
+	alarm_leds(state == GPIO_PIN_SET);
+}
+
+
+// Flashes LEDs every 500 ms on TIM2/TIM3, off when false is passed
+void flashleds(bool state)
+{
+	if (state == true) {
+		alarm_blink(500, 500);
+	} else {
+		alarm_leds(false);
+	}
+}
+
+// Verdict on the code as typed (2 = Admin, 1 = Correct, 0 = Incorrect). The
+// cursor looked the code up as its last digit went in, so A reads the answer
+// in the same few cycles whatever is stored, unless the console changed the
+// codes since. Whether any stored code can still match shows in
+// entry.cursor.matches after each digit, but the screen does not reveal it,
+// which would hand a guesser the code one digit at a time.
+static uint8_t verdict(void)
+{
+	if (codestore_key(entry.code) == codestore_key(ADMIN)) { // Whole code, not up to the first wrong digit
+		return 2;
+	}
+	codestore_refresh(&codes, &entry.cursor);
+	return codestore_found(&entry.cursor) ? 1 : 0;
+}
+
+// Shows what has been drawn, then waits for the given time in ms
+void Delay(int delay)
+{
+	lcd_flush();
+	delay_ms(delay);
+}
 
 // System Clock Configuration
 void SystemClock_Config(void)
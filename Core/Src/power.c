@@ -0,0 +1,154 @@
+/**
+  ******************************************************************************
+  * @file           : power.c
+  * @brief          : Tickless low-power idle.
+  *                   power_idle() stands in for __WFI() in the firmware's
+  *                   masked wait loops. When the LCD transport, the alarm
+  *                   timers, the keypad scanner and the flash are idle and
+  *                   no software timer is due within POWER_STOP_MIN_MS, SysTick is suspended and the core
+  *                   enters Stop 2. A keypad row EXTI, a start bit on the
+  *                   console's RX pin or an LPTIM1 compare at the next
+  *                   timer expiry wakes it on HSI16; the PLL is then brought
+  *                   back and the ticks that passed are read
+  *                   from LPTIM1, which counts the LSE through Stop 2, and
+  *                   handed to the HAL tick and the timer wheel. Until the
+  *                   LSE is ready, Stop 2 is only used when no timer is
+  *                   running and a key is the only way out.
+  ******************************************************************************
+  */
+
+// Includes
+#include "power.h"
+#include "swtimer.h"
+#include "lcd.h"
+#include "alarm.h"
+#include "journal.h"
+#include "console.h"
+#include "keypad.h"
+
+#define LPTIM_PRESC (LPTIM_CFGR_PRESC_2 | LPTIM_CFGR_PRESC_0) // Divide by 32
+#define LPTIM_TOP 0xFFFFu // Free-running over the whole 16 bits
+
+static bool timed = false; // LPTIM1 counting, so Stop 2 can wake on a timer
+static bool cmpwritten = false; // CMP written, CMPOK must be seen before the next write
+static uint32_t leftover = 0; // Counts x 1000 not yet turned into whole ms
+static power_stats_t stats;
+
+// Reads the counter. It runs on the LSE, so two reads must agree.
+static uint16_t count(void)
+{
+	uint32_t now = LPTIM1->CNT, before;
+
+	do {
+		before = now;
+		now = LPTIM1->CNT;
+	} while (now != before);
+	return (uint16_t)now;
+}
+
+// Sets the wake-up count. The write crosses into the LSE domain, which
+// takes a few of its cycles, so only the next write waits for it.
+static void compare(uint16_t cmp)
+{
+	while (cmpwritten == true && (LPTIM1->ISR & LPTIM_ISR_CMPOK) == 0) {
+	}
+	LPTIM1->ICR = LPTIM_ICR_CMPOKCF | LPTIM_ICR_CMPMCF;
+	LPTIM1->CMP = cmp < LPTIM_TOP ? cmp : 0; // CMP must stay below ARR
+	cmpwritten = true;
+}
+
+// LSE is running, start LPTIM1 counting it for good
+static void starttimer(void)
+{
+	__HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSE);
+	__HAL_RCC_LPTIM1_CLK_ENABLE();
+
+	// CFGR and IER can only be written while disabled, ARR only while enabled
+	LPTIM1->CR = 0;
+	LPTIM1->CFGR = LPTIM_PRESC;
+	LPTIM1->IER = LPTIM_IER_CMPMIE;
+	LPTIM1->CR = LPTIM_CR_ENABLE;
+	LPTIM1->ARR = LPTIM_TOP;
+	while ((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0) {
+	}
+	LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+	LPTIM1->CR |= LPTIM_CR_CNTSTRT;
+
+	// Line 32 carries the LPTIM1 wake-up out of Stop 2
+	EXTI->IMR2 |= EXTI_IMR2_IM32;
+	HAL_NVIC_SetPriority(LPTIM1_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+	timed = true;
+}
+
+// Turns on the LSE without waiting for it, crystals take up to seconds
+void power_init(void)
+{
+	HAL_PWR_EnableBkUpAccess();
+	__HAL_RCC_LSE_CONFIG(RCC_LSE_ON);
+
+	// Wake up on HSI16, the PLL input, so only the PLL has to relock
+	__HAL_RCC_WAKEUPSTOP_CLK_CONFIG(RCC_STOP_WAKEUPCLOCK_HSI);
+}
+
+// Stop 2 from a masked context, the pending interrupt runs once the caller unmasks
+static void stop(uint32_t ms)
+{
+	uint16_t start = 0;
+	uint32_t elapsed, woke, took;
+
+	if (timed == true) {
+		ms = ms < POWER_STOP_MAX_MS ? ms : POWER_STOP_MAX_MS;
+		start = count();
+		compare((uint16_t)(start + (ms * POWER_LPTIM_HZ + 999) / 1000));
+	}
+
+	HAL_SuspendTick();
+	HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
+
+	// Back on HSI16 with the PLL off
+	woke = DWT->CYCCNT;
+	SystemClock_Config();
+	took = DWT->CYCCNT - woke;
+	stats.restore = took / (HSI_VALUE / 1000000); // Mostly at 16 MHz, so at most this
+	if (stats.restore > stats.restoremax) {
+		stats.restoremax = stats.restore;
+	}
+	stats.stops++;
+
+	// Hand the time spent stopped to everything that counts ticks
+	if (timed == true) {
+		leftover += (uint16_t)(count() - start) * 1000u;
+		elapsed = leftover / POWER_LPTIM_HZ;
+		leftover %= POWER_LPTIM_HZ;
+		uwTick += elapsed;
+		swtimer_advance(elapsed);
+		stats.stopped += elapsed;
+	}
+}
+
+// Waits for an interrupt, called with interrupts masked like __WFI() in a
+// masked loop. Anything that needs the core clock keeps the core in Sleep.
+void power_idle(void)
+{
+	uint32_t next;
+
+	if (timed == false && __HAL_RCC_GET_FLAG(RCC_FLAG_LSERDY)) {
+		starttimer();
+	}
+
+	next = swtimer_next();
+	if (lcd_busy() == true || alarm_busy() == true || keypad_busy() == true || journal_busy() == true || next < POWER_STOP_MIN_MS || (timed == false && next != SWTIMER_NONE) ||
+		console_sleep() == false) { // Last, as it arms the console wake-up
+		stats.sleeps++;
+		__WFI();
+		return;
+	}
+	stop(next);
+}
+
+// Returns the idle counts and restore times
+const power_stats_t *power_stats(void)
+{
+	return &stats;
+}
@@ -0,0 +1,508 @@
+/**
+  ******************************************************************************
+  * @file           : provision.c
+  * @brief          : Binary code import and export over the console UART,
+  *                   the wire format is in provision.h.
+  *                   Frames are COBS decoded a byte at a time straight from
+  *                   the console's DMA receive buffer, and the CRC runs
+  *                   alongside, so the only copy is the decoded frame, held
+  *                   until its CRC says the codes in it may be stored. Each
+  *                   IMPORT frame of up to PROVISION_CODES codes goes to the
+  *                   store and to the journal as one batch, one flash
+  *                   record per code and one for its commit. Its ACK, or a
+  *                   NAK, waits until the journal has written it, so the
+  *                   host's window never holds more than the journal queue
+  *                   takes and the journal never falls back on a snapshot
+  *                   to catch up. Replies and DATA frames are built and
+  *                   COBS encoded straight into the console's transmit
+  *                   buffer, DATA walking the code table a frame at a time
+  *                   as the window opens. Recovery is go-back-N both ways:
+  *                   one NAK per gap on import, and a repeated NEXT on
+  *                   export, so neither side needs a timer beyond the
+  *                   host's.
+  ******************************************************************************
+  */
+
+// Includes
+#include "provision.h"
+#include "main.h"
+#include "journal.h"
+#include "string.h"
+
+#define HEADER 2 // Type and seq
+#define TRAILER 2 // CRC
+#define REPLY_ROOM 16 // Enough for any reply frame encoded
+
+#if PROVISION_WINDOW * (PROVISION_CODES + 1) > JOURNAL_QUEUE
+#error "A window of IMPORT frames must fit the journal queue"
+#endif
+
+typedef struct {
+	uint8_t *out;
+	uint16_t len; // Bytes written so far
+	uint16_t code; // Where the COBS code byte of the current block goes
+	uint16_t crc;
+} encoder_t;
+
+static codestore_t *codes = NULL;
+static bool active = false;
+static bool allowed = false; // Admin login at the start of the session
+static uint32_t lastbyte; // HAL tick of the last byte taken
+
+// Frame being decoded
+static uint8_t frame[HEADER + PROVISION_PAYLOAD + TRAILER];
+static uint16_t framelen = 0;
+static uint16_t crc;
+static uint8_t block = 0; // Data bytes left in the COBS block, 0 when a code byte is next
+static bool blockfull = false; // The block is 254 bytes, no zero follows it
+static bool started = false; // A code byte came since the last delimiter
+static bool broken = false; // Too long or badly coded, dropped at the delimiter
+
+// Import
+static uint8_t expect = 0; // seq of the next IMPORT
+static bool nakked = false; // NAK sent for the gap before expect
+static bool acking = false; // ACK due once the journal is idle
+static uint8_t added = 0, skipped = 0; // Codes since the last ACK went out
+
+// Export
+static bool exporting = false;
+static uint8_t base, next; // Oldest frame the host lacks, next frame to send
+static uint16_t from[PROVISION_WINDOW]; // Slot each frame in flight starts at, to go back to
+static uint16_t before[PROVISION_WINDOW]; // Codes sent ahead of each frame in flight
+static uint16_t slot; // Where the next frame starts
+static uint16_t count; // Codes in the frames before it
+static bool ended; // END is in flight, as frame next - 1
+static uint32_t changes; // Store changes when the export started
+
+// Replies waiting for room
+static uint8_t reply[HEADER + 6];
+static uint8_t replylen = 0;
+static bool syncing = false;
+static bool closing = false;
+
+static provision_stats_t stats;
+
+// CRC-16/CCITT-FALSE, polynomial 0x1021, a nibble at a time
+static const uint16_t crctable[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static uint16_t crcbyte(uint16_t value, uint8_t byte)
+{
+	value = (uint16_t)(value << 4) ^ crctable[(value >> 12) ^ (byte >> 4)];
+	return (uint16_t)(value << 4) ^ crctable[(value >> 12) ^ (byte & 15)];
+}
+
+// Starts encoding a frame at out
+static void begin(encoder_t *e, uint8_t *out)
+{
+	e->out = out;
+	e->code = 0;
+	e->len = 1;
+	e->crc = 0xFFFF;
+}
+
+// One byte through COBS, a zero closes the block
+static void cobs(encoder_t *e, uint8_t byte)
+{
+	if (byte == 0) {
+		e->out[e->code] = (uint8_t)(e->len - e->code);
+		e->code = e->len++;
+		return;
+	}
+	e->out[e->len++] = byte;
+	if (e->len - e->code == 0xFF) {
+		e->out[e->code] = 0xFF;
+		e->code = e->len++;
+	}
+}
+
+// One byte of the frame, counted in the CRC
+static void emit(encoder_t *e, uint8_t byte)
+{
+	e->crc = crcbyte(e->crc, byte);
+	cobs(e, byte);
+}
+
+// Appends the CRC and the delimiter, returns the frame's length
+static uint16_t end(encoder_t *e)
+{
+	uint16_t value = e->crc;
+
+	cobs(e, (uint8_t)(value >> 8));
+	cobs(e, (uint8_t)value);
+	e->out[e->code] = (uint8_t)(e->len - e->code);
+	e->out[e->len++] = 0;
+	return e->len;
+}
+
+// Queues a short reply, sent by provision_send()
+static void respond(uint8_t type, uint8_t seq, const uint8_t *payload, uint8_t len)
+{
+	reply[0] = type;
+	reply[1] = seq;
+	if (len > 0) {
+		memcpy(&reply[HEADER], payload, len);
+	}
+	replylen = HEADER + len;
+}
+
+// Reads a packed code into digits. Returns the bytes it took, 0 if the count
+// is not a code length or runs past the payload; code is empty if a digit is
+// not 0 to 9.
+static uint16_t unpack(const uint8_t *data, uint16_t len, char *code)
+{
+	uint8_t digits = data[0];
+	uint16_t size = 1 + (digits + 1) / 2;
+
+	if (digits < CODESTORE_MIN || digits > CODESTORE_MAX || size > len) {
+		return 0;
+	}
+	for (uint8_t i = 0; i < digits; i++) {
+		uint8_t nibble = (i & 1) ? data[1 + i / 2] & 15 : data[1 + i / 2] >> 4;
+
+		if (nibble > 9) {
+			code[0] = '\0';
+			return size;
+		}
+		code[i] = (char)('0' + nibble);
+	}
+	code[digits] = '\0';
+	return size;
+}
+
+// Stores the codes of an IMPORT frame as one journal batch, and sets its ACK
+// going once they are written. Codes past PROVISION_CODES are skipped, the
+// journal queue has no room for them.
+static void import(const uint8_t *data, uint16_t len)
+{
+	char code[CODESTORE_MAX + 1];
+	uint8_t taken = 0, add = 0, skip = 0;
+	uint16_t used;
+
+	journal_begin();
+	while (len > 0) {
+		used = unpack(data, len, code);
+		if (used == 0) { // The rest cannot be read
+			skip++;
+			break;
+		}
+		if (taken++ >= PROVISION_CODES) {
+			skip++;
+		} else if (codestore_add(codes, code) == true) {
+			journal_add(code);
+			add++;
+		} else if (code[0] == '\0' || codestore_contains(codes, code) == false) {
+			skip++;
+		}
+		data += used;
+		len -= used;
+	}
+	journal_commit();
+	stats.imported += add;
+	stats.skipped += skip;
+	added += add;
+	skipped += skip;
+	acking = true;
+}
+
+// Export window: NEXT for seq. Frames before it are done; the same seq as
+// before means the host lost one, so sending goes back to it.
+static void advance(uint8_t seq)
+{
+	uint8_t acked = (uint8_t)(seq - base);
+	uint8_t flight = (uint8_t)(next - base);
+
+	if (exporting == false) {
+		return;
+	}
+	if (acked > 0 && acked <= flight) {
+		base = seq;
+		if (ended == true && base == next) { // END arrived
+			exporting = false;
+		}
+	} else if (acked == 0 && flight > 0) {
+		next = base;
+		slot = from[base % PROVISION_WINDOW];
+		count = before[base % PROVISION_WINDOW];
+		ended = false;
+		stats.rewinds++;
+	}
+}
+
+// Acts on a frame that passed its CRC
+static void handle(uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len)
+{
+	uint8_t info[6];
+	uint16_t total = codestore_total(codes);
+
+	stats.frames++;
+	if (allowed == false && type != PROVISION_CLOSE) {
+		if (type == PROVISION_OPEN) {
+			respond(PROVISION_DENIED, 0, NULL, 0);
+		}
+		return;
+	}
+	switch (type) {
+		case PROVISION_OPEN:
+			expect = 0;
+			nakked = false;
+			acking = false;
+			added = skipped = 0;
+			exporting = false;
+			info[0] = PROVISION_WINDOW;
+			info[1] = PROVISION_PAYLOAD;
+			info[2] = (uint8_t)total;
+			info[3] = (uint8_t)(total >> 8);
+			info[4] = (uint8_t)CODESTORE_CAPACITY;
+			info[5] = (uint8_t)(CODESTORE_CAPACITY >> 8);
+			respond(PROVISION_READY, 0, info, sizeof(info));
+			break;
+		case PROVISION_IMPORT:
+			if (seq == expect) {
+				expect++;
+				nakked = false;
+				import(payload, len);
+			} else if ((uint8_t)(expect - seq) <= PROVISION_WINDOW) { // Sent again, its ACK was lost
+				acking = true;
+			} else if (nakked == false) { // One ahead of a gap
+				nakked = true;
+				stats.naks++;
+				respond(PROVISION_NAK, expect, NULL, 0);
+			}
+			break;
+		case PROVISION_EXPORT:
+			exporting = true;
+			base = next = 0;
+			slot = count = 0;
+			ended = false;
+			changes = codes->changes;
+			break;
+		case PROVISION_NEXT:
+			advance(seq);
+			break;
+		case PROVISION_SYNC:
+			syncing = true;
+			break;
+		case PROVISION_CLOSE:
+			closing = true;
+			active = false;
+			break;
+		default:
+			break;
+	}
+}
+
+// Delimiter: checks the frame and acts on it
+static void finish(void)
+{
+	if (started == false) { // Empty, such as the zero that opened the session
+		return;
+	}
+	if (broken == true || block != 0 || framelen < HEADER + TRAILER || crc != 0) {
+		stats.bad++;
+		if (nakked == false) {
+			nakked = true;
+			stats.naks++;
+			respond(PROVISION_NAK, expect, NULL, 0);
+		}
+		return;
+	}
+	handle(frame[0], frame[1], &frame[HEADER], framelen - HEADER - TRAILER);
+}
+
+// One decoded byte into the frame
+static void keep(uint8_t byte)
+{
+	if (framelen == sizeof(frame)) {
+		broken = true;
+		return;
+	}
+	frame[framelen++] = byte;
+	crc = crcbyte(crc, byte);
+}
+
+// Fills one DATA frame from the table, or sends END once the codes run out
+static uint16_t dataframe(uint8_t *out)
+{
+	encoder_t e;
+	char code[CODESTORE_MAX + 1];
+	uint16_t size = 0, digits;
+	uint8_t byte;
+
+	from[next % PROVISION_WINDOW] = slot;
+	before[next % PROVISION_WINDOW] = count;
+	while (slot < CODESTORE_SLOTS && codes->slots[slot] == CODESTORE_NONE) {
+		slot++;
+	}
+	begin(&e, out);
+	if (slot == CODESTORE_SLOTS) {
+		emit(&e, PROVISION_END);
+		emit(&e, next++);
+		emit(&e, (uint8_t)count);
+		emit(&e, (uint8_t)(count >> 8));
+		emit(&e, codes->changes != changes);
+		ended = true;
+		return end(&e);
+	}
+	emit(&e, PROVISION_DATA);
+	emit(&e, next++);
+	for (; slot < CODESTORE_SLOTS; slot++) {
+		if (codes->slots[slot] == CODESTORE_NONE) {
+			continue;
+		}
+		codestore_code(codes->slots[slot], code);
+		digits = (uint16_t)strlen(code);
+		if (size + 1 + (digits + 1) / 2 > PROVISION_PAYLOAD) {
+			break;
+		}
+		emit(&e, (uint8_t)digits);
+		for (uint16_t i = 0; i < digits; i += 2) {
+			byte = (uint8_t)((code[i] - '0') << 4);
+			byte |= i + 1 < digits ? (uint8_t)(code[i + 1] - '0') : 0x0F;
+			emit(&e, byte);
+		}
+		size += 1 + (digits + 1) / 2;
+		count++;
+		stats.exported++;
+	}
+	return end(&e);
+}
+
+// Keeps the store the frames go into
+void provision_init(codestore_t *store)
+{
+	codes = store;
+}
+
+// Clears the decoder for the next frame
+static void reset(void)
+{
+	framelen = 0;
+	block = 0;
+	started = broken = false;
+	crc = 0xFFFF;
+}
+
+// Starts a session on the console's zero byte, one that only answers OPEN
+// with DENIED unless the console has an admin login
+void provision_start(bool admin)
+{
+	active = true;
+	allowed = admin;
+	lastbyte = HAL_GetTick();
+	reset();
+}
+
+// Checks whether received bytes are frames
+bool provision_active(void)
+{
+	return active;
+}
+
+// Decodes received bytes up to the end of a frame and acts on it. A pause
+// longer than PROVISION_IDLE_MS ends the session first, leaving the bytes
+// to the console.
+uint32_t provision_take(const uint8_t *data, uint32_t len)
+{
+	uint32_t i = 0;
+	uint8_t byte;
+
+	if (HAL_GetTick() - lastbyte > PROVISION_IDLE_MS) {
+		active = false;
+		exporting = false;
+		return 0;
+	}
+	lastbyte = HAL_GetTick();
+	while (i < len) {
+		byte = data[i++];
+		if (byte == 0) {
+			finish();
+			reset();
+			return i;
+		}
+		if (broken == true) {
+			continue;
+		}
+		if (block == 0) { // Code byte, the block before it ends in a zero unless it was full
+			if (started == true && blockfull == false) {
+				keep(0);
+			}
+			started = true;
+			blockfull = byte == 0xFF;
+			block = byte - 1;
+		} else {
+			keep(byte);
+			block--;
+		}
+	}
+	return i;
+}
+
+// Writes the replies due, then DATA frames while the export window is open
+// and a whole frame fits. ACK and NAK wait while the journal is busy, since
+// either one opens the host's window.
+uint16_t provision_send(uint8_t *out, uint16_t room)
+{
+	encoder_t e;
+	uint16_t len = 0, total;
+	uint32_t errors;
+	bool idle;
+
+	if (codes == NULL) {
+		return 0;
+	}
+	total = codestore_total(codes);
+	errors = journal_stats()->errors;
+	idle = journal_busy() == false;
+	if (acking == true && idle == true && room - len >= REPLY_ROOM) {
+		begin(&e, out + len);
+		emit(&e, PROVISION_ACK);
+		emit(&e, expect);
+		emit(&e, added);
+		emit(&e, skipped);
+		emit(&e, (uint8_t)total);
+		emit(&e, (uint8_t)(total >> 8));
+		len += end(&e);
+		acking = false;
+		added = skipped = 0;
+	}
+	if (replylen > 0 && (reply[0] != PROVISION_NAK || idle == true) && room - len >= REPLY_ROOM) {
+		begin(&e, out + len);
+		for (uint8_t i = 0; i < replylen; i++) {
+			emit(&e, reply[i]);
+		}
+		len += end(&e);
+		replylen = 0;
+	}
+	if (syncing == true && idle == true && room - len >= REPLY_ROOM) {
+		begin(&e, out + len);
+		emit(&e, PROVISION_SYNCED);
+		emit(&e, 0);
+		emit(&e, (uint8_t)total);
+		emit(&e, (uint8_t)(total >> 8));
+		emit(&e, (uint8_t)(errors > 0xFFFF ? 0xFF : errors));
+		emit(&e, (uint8_t)(errors > 0xFFFF ? 0xFF : errors >> 8));
+		len += end(&e);
+		syncing = false;
+	}
+	if (closing == true && room - len >= REPLY_ROOM) {
+		begin(&e, out + len);
+		emit(&e, PROVISION_CLOSED);
+		emit(&e, 0);
+		len += end(&e);
+		closing = false;
+	}
+	while (exporting == true && ended == false && (uint8_t)(next - base) < PROVISION_WINDOW &&
+		room - len >= PROVISION_FRAME) {
+		len += dataframe(out + len);
+	}
+	return len;
+}
+
+// Returns the provisioning figures
+const provision_stats_t *provision_stats(void)
+{
+	return &stats;
+}
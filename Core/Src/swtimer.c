@@ -0,0 +1,162 @@
+/**
+  ******************************************************************************
+  * @file           : swtimer.c
+  * @brief          : Software timers on the 1 ms HAL tick.
+  *                   Running timers hang off a wheel of SWTIMER_SLOTS lists,
+  *                   indexed by the low bits of their expiry tick. Each tick
+  *                   only visits the timers in one slot, so starting,
+  *                   stopping and expiring are O(1); a timer more than one
+  *                   turn away is skipped once per turn until it is due.
+  ******************************************************************************
+  */
+
+// Includes
+#include "swtimer.h"
+
+typedef struct swtimer {
+	struct swtimer *next, *prev; // Neighbours in the slot list
+	uint32_t expires; // Tick it fires on
+	uint32_t period; // Ticks between firings, 0 = one-shot
+	swtimer_fn_t fn;
+	void *arg;
+	bool active;
+} swtimer_t;
+
+static swtimer_t pool[SWTIMER_POOL];
+static uint8_t created = 0;
+static swtimer_t *wheel[SWTIMER_SLOTS];
+static volatile uint32_t ticks = 0;
+
+// Adds a timer to the slot of its expiry tick
+static void attach(swtimer_t *t)
+{
+	swtimer_t **slot = &wheel[t->expires & (SWTIMER_SLOTS - 1)];
+
+	t->prev = NULL;
+	t->next = *slot;
+	if (*slot != NULL) {
+		(*slot)->prev = t;
+	}
+	*slot = t;
+	t->active = true;
+}
+
+// Takes a timer out of its slot
+static void detach(swtimer_t *t)
+{
+	if (t->prev != NULL) {
+		t->prev->next = t->next;
+	} else {
+		wheel[t->expires & (SWTIMER_SLOTS - 1)] = t->next;
+	}
+	if (t->next != NULL) {
+		t->next->prev = t->prev;
+	}
+	t->active = false;
+}
+
+// Takes a timer from the pool, only during start up
+int swtimer_create(swtimer_fn_t fn, void *arg)
+{
+	if (created == SWTIMER_POOL) {
+		return -1;
+	}
+	pool[created].fn = fn;
+	pool[created].arg = arg;
+	pool[created].active = false;
+	return created++;
+}
+
+// Starts or restarts a timer, safe from interrupts and the main loop
+void swtimer_start(int id, uint32_t ms, uint32_t period)
+{
+	swtimer_t *t = &pool[id];
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (t->active == true) {
+		detach(t);
+	}
+	t->expires = ticks + (ms > 0 ? ms : 1);
+	t->period = period;
+	attach(t);
+	__set_PRIMASK(primask);
+}
+
+// Stops a timer, nothing happens if it is not running
+void swtimer_stop(int id)
+{
+	swtimer_t *t = &pool[id];
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (t->active == true) {
+		detach(t);
+	}
+	__set_PRIMASK(primask);
+}
+
+// Checks if a timer is waiting to fire
+bool swtimer_active(int id)
+{
+	return pool[id].active;
+}
+
+// Returns ticks since reset
+uint32_t swtimer_ticks(void)
+{
+	return ticks;
+}
+
+// Moves the wheel one tick and fires what is due. Timers are taken one at a
+// time, so a callback may start or stop any timer, itself included.
+void swtimer_tick(void)
+{
+	swtimer_t *t;
+	uint32_t now = ++ticks;
+
+	for (;;) {
+		for (t = wheel[now & (SWTIMER_SLOTS - 1)]; t != NULL && t->expires != now; t = t->next) {
+		}
+		if (t == NULL) {
+			return;
+		}
+		detach(t);
+		if (t->period != 0) {
+			t->expires = now + t->period;
+			attach(t);
+		}
+		t->fn(t->arg);
+	}
+}
+
+// Finds how many ticks away the nearest running timer is. Only called
+// before a long sleep, so a walk of the pool is cheap enough.
+uint32_t swtimer_next(void)
+{
+	uint32_t next = SWTIMER_NONE;
+
+	for (int i = 0; i < created; i++) {
+		if (pool[i].active == true && pool[i].expires - ticks < next) {
+			next = pool[i].expires - ticks;
+		}
+	}
+	return next;
+}
+
+// Moves the wheel over ticks that passed without SysTick, jumping straight
+// to each timer that fell due on the way so it still fires, in order
+void swtimer_advance(uint32_t missed)
+{
+	while (missed > 0) {
+		uint32_t next = swtimer_next();
+
+		if (next > missed) {
+			ticks += missed;
+			return;
+		}
+		ticks += next - 1;
+		missed -= next;
+		swtimer_tick();
+	}
+}
@@ -0,0 +1,187 @@
+/**
+  ******************************************************************************
+  * @file           : bench_codestore.c
+  * @brief          : Host micro-benchmark of code lookup.
+  *                   Compares the original linear scan over codes[][4], a
+  *                   hash lookup, codestore_match()'s constant-time scan of
+  *                   every slot, and the entry cursor the keypad narrows as
+  *                   each digit goes in, all four digits and the read on A
+  *                   included, at 1, 100 and 999 stored 4-digit codes, in
+  *                   host cycles for hits and misses apart. The linear scan
+  *                   exits early, so its time gives away how far down the
+  *                   list a code is; the constant-time scan should take the
+  *                   same for both. The console's cycles command times the
+  *                   same on the lock. Probe counts against load are in
+  *                   bench_hash.c.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "codestore.h"
+
+#define MAXCODES 999
+#define QUERIES 4096
+#define ROUNDS 5
+
+static const char ADMINCODE[4] = {'2', '5', '8', '0'};
+
+// checkcode() as it was before the bitset store
+static uint8_t legacy_checkcode(char* entry, char codes[][5], uint16_t total)
+{
+	for (int j = 0; j < 4; j++) {
+		if (ADMINCODE[j] == entry[j] && j != 3) {
+			continue;
+		} else if (ADMINCODE[j] == entry[j] && j == 3) {
+			return 2;
+		} else {
+			break;
+		}
+	}
+	for (int i = 0; i < total; i++) {
+		for (int j = 0; j < 4; j++) {
+			if (codes[i][j] == entry[j] && j != 3) {
+				continue;
+			} else if (codes[i][j] == entry[j] && j == 3) {
+				return 1;
+			} else {
+				break;
+			}
+		}
+	}
+	return 0;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TICKS "cycles"
+
+// Host time stamp counter, the builtin as x86intrin.h clashes with the CMSIS macros
+static uint64_t ticks(void)
+{
+	return __builtin_ia32_rdtsc();
+}
+#else
+#define TICKS "ns"
+
+static uint64_t ticks(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+// Random 4-digit code, NUL-terminated
+static void randomcode(char *code)
+{
+	snprintf(code, 5, "%04u", (unsigned)rand() % 10000);
+}
+
+enum { LINEAR, HASH, SCAN, CURSOR, METHODS };
+static const char *names[METHODS] = {"linear", "hash", "scan", "cursor"};
+
+static char legacy[MAXCODES][5];
+static codestore_t store;
+static char hits[QUERIES][5], misses[QUERIES][5];
+
+// One check by the given method
+static unsigned check(int method, char *code, int total)
+{
+	switch (method) {
+		case LINEAR:
+			return legacy_checkcode(code, legacy, total);
+		case HASH:
+			return codestore_contains(&store, code);
+		case SCAN:
+			return codestore_match(&store, code);
+		default: {
+			codestore_cursor_t cursor;
+
+			codestore_begin(&store, &cursor);
+			for (int d = 0; code[d] != '\0'; d++) {
+				codestore_push(&store, &cursor, code[d]);
+			}
+			return codestore_found(&cursor);
+		}
+	}
+}
+
+// Best average ticks per check over the rounds
+static double timed(int method, char queries[][5], int total, volatile unsigned *sink)
+{
+	double best = 1e18;
+
+	for (int r = 0; r < ROUNDS; r++) {
+		uint64_t t0 = ticks();
+
+		for (int q = 0; q < QUERIES; q++) {
+			*sink += check(method, queries[q], total);
+		}
+		if ((double)(ticks() - t0) / QUERIES < best) {
+			best = (double)(ticks() - t0) / QUERIES;
+		}
+	}
+	return best;
+}
+
+int main(void)
+{
+	static const int sizes[] = {1, 100, 999};
+	volatile unsigned sink = 0;
+
+	srand(3130);
+	printf("storage: hash %zu bytes for %u codes, codes[%d][4] %zu bytes\n",
+		sizeof(codestore_t), (unsigned)CODESTORE_CAPACITY, MAXCODES, (size_t)MAXCODES * 4);
+	printf("linear = original char-by-char scan, hash = one lookup,\n"
+		"scan = codestore_match(), every slot compared in constant time,\n"
+		"cursor = narrowed digit by digit as the keypad does, then read on A\n\n");
+	printf("%6s %8s %12s %12s %8s\n", "codes", "method", "hit " TICKS, "miss " TICKS, "per slot");
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		int total = sizes[s];
+
+		// Distinct random codes, never the admin code
+		codestore_clear(&store);
+		for (int i = 0; i < total; i++) {
+			char code[5];
+			do {
+				randomcode(code);
+			} while (memcmp(code, ADMINCODE, 4) == 0 || !codestore_add(&store, code));
+			memcpy(legacy[i], code, 5);
+		}
+
+		// Stored codes, and codes that are not stored
+		for (int q = 0; q < QUERIES; q++) {
+			memcpy(hits[q], legacy[rand() % total], 5);
+			do {
+				randomcode(misses[q]);
+			} while (codestore_contains(&store, misses[q]) || memcmp(misses[q], ADMINCODE, 4) == 0);
+		}
+
+		for (int m = 0; m < METHODS; m++) {
+			double hit = timed(m, hits, total, &sink), miss = timed(m, misses, total, &sink);
+
+			printf("%6d %8s %12.1f %12.1f", total, names[m], hit, miss);
+			if (m == SCAN) {
+				printf(" %8.2f", miss / CODESTORE_SLOTS);
+			}
+			printf("\n");
+		}
+	}
+
+	// Add, duplicate check and remove cycle on a full store
+	{
+		uint64_t t0 = ticks();
+		for (int q = 0; q < QUERIES; q++) {
+			sink += codestore_add(&store, misses[q]);
+			sink += codestore_add(&store, misses[q]);
+			sink += codestore_remove(&store, misses[q]);
+		}
+		printf("\nadd + duplicate + remove: %.1f %s/op\n", (double)(ticks() - t0) / (3.0 * QUERIES), TICKS);
+	}
+	return sink == 0xFFFFFFFFu;
+}
@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file           : bench_hash.c
+  * @brief          : Host benchmark of probe counts in the code store.
+  *                   Built with its own copy of codestore.c at a 95% load
+  *                   limit, fills the table with random codes of 4 to 10
+  *                   digits and reports, at each fill, the slots read by a
+  *                   lookup that hits and one that misses, against what
+  *                   linear probing predicts. The rows up to the firmware's
+  *                   CODESTORE_LOAD are what the lock will see.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "codestore.h"
+
+#define FIRMWARE_LOAD 75 // CODESTORE_LOAD of the firmware build
+#define LOOKUPS 4096
+
+static codestore_t store;
+static char stored[CODESTORE_CAPACITY][CODESTORE_MAX + 1];
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Random code of 4 to 10 digits
+static void randomcode(char *code)
+{
+	int digits = CODESTORE_MIN + rand() % (CODESTORE_MAX - CODESTORE_MIN + 1);
+
+	for (int i = 0; i < digits; i++) {
+		code[i] = '0' + rand() % 10;
+	}
+	code[digits] = '\0';
+}
+
+int main(void)
+{
+	static const int percents[] = {10, 25, 50, 60, 70, 75, 80, 85, 90, 95};
+	char miss[CODESTORE_MAX + 1];
+	volatile unsigned sink = 0;
+	int total = 0;
+
+	srand(3130);
+	codestore_clear(&store);
+	printf("%u slots, %zu bytes, firmware fills to %d%%\n\n", (unsigned)CODESTORE_SLOTS,
+		sizeof(codestore_t), FIRMWARE_LOAD);
+	printf("%6s %5s %9s %9s %9s %9s %9s %10s\n", "codes", "load", "hit avg", "expect", "hit max",
+		"miss avg", "expect", "ns/lookup");
+
+	for (size_t p = 0; p < sizeof(percents) / sizeof(percents[0]); p++) {
+		int target = (int)(CODESTORE_SLOTS * percents[p] / 100);
+		long hits = 0, misses = 0, most = 0;
+		double alpha, t0;
+
+		while (total < target) {
+			randomcode(stored[total]);
+			if (codestore_add(&store, stored[total])) {
+				total++;
+			}
+		}
+		alpha = (double)total / CODESTORE_SLOTS;
+
+		for (int i = 0; i < total; i++) {
+			int n = codestore_probes(&store, stored[i]);
+
+			hits += n;
+			most = n > most ? n : most;
+		}
+		for (int i = 0; i < LOOKUPS; i++) {
+			do {
+				randomcode(miss);
+			} while (codestore_contains(&store, miss));
+			misses += codestore_probes(&store, miss);
+		}
+
+		t0 = now();
+		for (int r = 0; r < 100; r++) {
+			for (int i = 0; i < total; i++) {
+				sink += codestore_contains(&store, stored[i]);
+			}
+		}
+		printf("%6d %4d%% %9.2f %9.2f %9ld %9.2f %9.2f %10.1f%s\n", total, percents[p],
+			(double)hits / total, 0.5 * (1 + 1 / (1 - alpha)), most,
+			(double)misses / LOOKUPS, 0.5 * (1 + 1 / ((1 - alpha) * (1 - alpha))),
+			(now() - t0) * 1e9 / (100.0 * total), percents[p] > FIRMWARE_LOAD ? "  (past firmware limit)" : "");
+	}
+	return sink == 0xFFFFFFFFu;
+}
@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file           : bench_idle.c
+  * @brief          : Time in Run, Sleep and Stop 2, and the average current.
+  *                   Runs the lock through enrolment, an unlock and a wrong
+  *                   code with a second between keys, then leaves it locked
+  *                   for ten minutes. Time in each mode is weighted with
+  *                   datasheet typical currents for the MCU alone, for the
+  *                   session and for the idle stretch after it. Also reports
+  *                   key press to first column scan, and the clock restore
+  *                   time power_idle() measured after each Stop 2.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include "main.h"
+#include "power.h"
+#include "sim.h"
+
+int lock_main(void); // main() in Core/Src/main.c
+
+// STM32L476 at 3 V, 25 C, range 1
+#define RUN_UA 10200.0 // 80 MHz from flash, ART on
+#define SLEEP_UA 2800.0 // 80 MHz, peripherals idle
+#define STOP2_UA 1.6 // LSE and LPTIM1 running
+
+#define IDLE_MS 600000
+
+static const char *keys = "1234A" "1234A" "9999A"; // Enrol, unlock, wrong code
+
+typedef struct {
+	uint64_t now, asleep, stopped, cycles;
+} mark_t;
+
+static mark_t idlestart;
+static bool marked = false;
+
+static void mark(mark_t *m)
+{
+	m->now = sim_now();
+	m->asleep = sim_asleep();
+	m->stopped = sim_stopped();
+	m->cycles = sim_cycles();
+}
+
+// Hands out the keys, then marks where the lock is left waiting
+static char nextkey(void *ctx)
+{
+	const char **next = ctx;
+
+	if (**next != '\0') {
+		return *(*next)++;
+	}
+	if (marked == false) {
+		mark(&idlestart);
+		marked = true;
+	}
+	return 0;
+}
+
+static void report(const char *name, const mark_t *from, const mark_t *to)
+{
+	double total = (double)(to->now - from->now);
+	double asleep = (double)(to->asleep - from->asleep);
+	double stopped = (double)(to->stopped - from->stopped);
+	double run = total - asleep - stopped;
+	double stop2ua = (run * RUN_UA + asleep * SLEEP_UA + stopped * STOP2_UA) / total;
+	double sleepua = (run * RUN_UA + (asleep + stopped) * SLEEP_UA) / total;
+
+	printf("%s, %.3f s\n", name, total / SIM_MS(1000));
+	printf("  run %.4f%%, sleep %.4f%%, stop 2 %.4f%%\n", 100.0 * run / total,
+		100.0 * asleep / total, 100.0 * stopped / total);
+	printf("  average %10.1f uA, every wait in Sleep would be %10.1f uA\n", stop2ua, sleepua);
+}
+
+int main(void)
+{
+	const char *next = keys;
+	const sim_scan_stats_t *scans;
+	const power_stats_t *ps = power_stats();
+	mark_t start = {0}, end;
+
+	sim_settle((uint64_t)IDLE_MS * 1000);
+	sim_keys_timing(100000, 1000000);
+	sim_keys_source(nextkey, &next);
+	sim_reset();
+	sim_run(lock_main);
+	mark(&end);
+
+	printf("MCU only, datasheet typical: run %.1f mA, sleep %.1f mA, stop 2 %.1f uA\n",
+		RUN_UA / 1000, SLEEP_UA / 1000, STOP2_UA);
+	report("session (boot, 15 keys, unlock countdown, wrong code buzz)", &start, &idlestart);
+	report("locked and waiting", &idlestart, &end);
+	report("whole run", &start, &end);
+
+	scans = sim_keys_scan_stats();
+	printf("key press to first scan: average %.3f ms, worst %.3f ms over %llu presses\n",
+		scans->scanned ? (double)scans->total / scans->scanned / SIM_US(1000) : 0.0,
+		(double)scans->max / SIM_US(1000), (unsigned long long)scans->scanned);
+	printf("stop 2 entries %u (%u ms stopped), sleeps %u, clock restore last %u us, worst %u us\n",
+		(unsigned)ps->stops, (unsigned)ps->stopped, (unsigned)ps->sleeps,
+		(unsigned)ps->restore, (unsigned)ps->restoremax);
+	return 0;
+}
@@ -0,0 +1,201 @@
+/**
+  ******************************************************************************
+  * @file           : bench_keypad.c
+  * @brief          : Host micro-benchmark of keypad decoding.
+  *                   Compares the original detectkey(), which rebuilt its
+  *                   key and pin tables on the stack and went pin by pin
+  *                   through HAL_GPIO_ReadPin() and HAL_GPIO_WritePin(),
+  *                   against keypad_decode(), which packs the one GPIOB->IDR
+  *                   reading DMA takes per column strobe and checks for
+  *                   ghosting through a const table in the same pass. Both
+  *                   run in host cycles for each of the 16 keys, no key and
+  *                   three keys making a ghost of the fourth. The legacy
+  *                   version has its delays and waits for the key taken out
+  *                   and reads a port kept in RAM, so only the decoding is
+  *                   timed; keypad_decode() reads samples the same way.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <time.h>
+#include "main.h"
+#include "keypad.h"
+
+#define QUERIES 4096
+#define ROUNDS 5
+#define CASES 18 // Each key, none, a ghost
+
+// Port as the legacy code saw it, the rows following the driven columns
+typedef struct {
+	volatile uint32_t ODR, IDR;
+	uint16_t rows[16]; // IDR row bits for each column pattern, from the keys held
+} port_t;
+
+static port_t port;
+
+// HAL_GPIO_ReadPin() as the HAL has it, out of line like the HAL's
+__attribute__((noinline)) static GPIO_PinState legacy_readpin(port_t *gpio, uint16_t pin)
+{
+	return (gpio->IDR & pin) != 0 ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+// HAL_GPIO_WritePin(), with the pad answering on the rows at once
+__attribute__((noinline)) static void legacy_writepin(port_t *gpio, uint16_t pin, GPIO_PinState state)
+{
+	if (state != GPIO_PIN_RESET) {
+		gpio->ODR |= pin;
+	} else {
+		gpio->ODR &= ~(uint32_t)pin;
+	}
+	gpio->IDR = gpio->rows[(gpio->ODR >> 1) & 0xF];
+}
+
+// detectkey() as it was before the scanner, less Delay() and the waits for
+// a key to go down and up
+__attribute__((noinline)) static unsigned char legacy_detectkey(port_t *gpio)
+{
+	unsigned char keymap[4][4] =
+		{{'1', '2', '3', 'A'},
+		{'4', '5', '6', 'B'},
+		{'7', '8', '9', 'C'},
+		{'*', '0', '#', 'D'}};
+	int col = 0, row = 0;
+	uint16_t colpins[4] = {GPIO_PIN_1, GPIO_PIN_2, GPIO_PIN_3, GPIO_PIN_4};
+	uint16_t rowpins[4] = {GPIO_PIN_8, GPIO_PIN_9, GPIO_PIN_10, GPIO_PIN_11};
+
+	legacy_writepin(gpio, GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4, GPIO_PIN_SET);
+	for (int i = 0; i < 4; i++) {
+		if (legacy_readpin(gpio, rowpins[i]) == GPIO_PIN_SET) {
+			row = i;
+			break;
+		}
+	}
+	for (int i = 0; i < 4; i++) {
+		legacy_writepin(gpio, GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4, GPIO_PIN_RESET);
+		legacy_writepin(gpio, colpins[i], GPIO_PIN_SET);
+		if (legacy_readpin(gpio, GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11) == GPIO_PIN_SET) {
+			col = i;
+			break;
+		}
+	}
+	legacy_writepin(gpio, GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4, GPIO_PIN_SET);
+	return keymap[row][col];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TICKS "cycles"
+
+// Host time stamp counter, the builtin as x86intrin.h clashes with the CMSIS macros
+static uint64_t ticks(void)
+{
+	return __builtin_ia32_rdtsc();
+}
+#else
+#define TICKS "ns"
+
+static uint64_t ticks(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+static const char keys[] = "147*2580369#ABCD"; // By pad bit, column * 4 + row
+
+// Keys held in a case, as pad bits
+static uint16_t held(int c)
+{
+	if (c < 16) {
+		return (uint16_t)(1u << c);
+	} else if (c == 16) {
+		return 0;
+	}
+	return (1u << 0) | (1u << 1) | (1u << 4); // '1', '4' and '2', ghosting '5'
+}
+
+// Row bits read with the given columns driven, the ghost included
+static uint16_t rowsfor(uint16_t pad, unsigned cols)
+{
+	uint16_t rows = 0;
+
+	if (pad == held(17)) {
+		pad |= 1u << 5;
+	}
+	for (int col = 0; col < 4; col++) {
+		if (cols & (1u << col)) {
+			rows |= (pad >> (4 * col)) & 0xF;
+		}
+	}
+	return (uint16_t)(rows << KEYPAD_ROW_SHIFT);
+}
+
+int main(void)
+{
+	static uint16_t samples[CASES][4];
+	double legacy[CASES], decode[CASES];
+	volatile unsigned sink = 0;
+	bool ghost;
+
+	for (int c = 0; c < CASES; c++) {
+		for (int col = 0; col < 4; col++) {
+			samples[c][col] = rowsfor(held(c), 1u << col);
+		}
+	}
+
+	for (int c = 0; c < CASES; c++) {
+		for (unsigned cols = 0; cols < 16; cols++) {
+			port.rows[cols] = rowsfor(held(c), cols);
+		}
+		legacy[c] = decode[c] = 1e18;
+		for (int r = 0; r < ROUNDS; r++) {
+			uint64_t t0 = ticks();
+
+			for (int q = 0; q < QUERIES; q++) {
+				sink += legacy_detectkey(&port);
+			}
+			if ((double)(ticks() - t0) / QUERIES < legacy[c]) {
+				legacy[c] = (double)(ticks() - t0) / QUERIES;
+			}
+			t0 = ticks();
+			for (int q = 0; q < QUERIES; q++) {
+				sink += keypad_decode(samples[c], &ghost);
+				sink += ghost;
+			}
+			if ((double)(ticks() - t0) / QUERIES < decode[c]) {
+				decode[c] = (double)(ticks() - t0) / QUERIES;
+			}
+		}
+	}
+
+	printf("legacy = detectkey() through HAL pin calls, decode = keypad_decode() on one IDR reading per column\n\n");
+	printf("%6s %14s %14s %6s %7s %5s\n", "keys", "legacy " TICKS, "decode " TICKS, "ghost", "legacy", "pad");
+	for (int c = 0; c < CASES; c++) {
+		unsigned char key;
+		uint16_t pad;
+
+		for (unsigned cols = 0; cols < 16; cols++) {
+			port.rows[cols] = rowsfor(held(c), cols);
+		}
+		key = legacy_detectkey(&port);
+		pad = keypad_decode(samples[c], &ghost);
+		printf("%6s %14.1f %14.1f %6s %7c %04X\n", c < 16 ? (char[]){keys[c], '\0'} : c == 16 ? "none" : "1 2 4",
+			legacy[c], decode[c], ghost ? "yes" : "no", key, (unsigned)pad);
+	}
+
+	// Average and worst over the keys alone, what a press costs
+	{
+		double lsum = 0, dsum = 0, lworst = 0, dworst = 0;
+
+		for (int c = 0; c < 16; c++) {
+			lsum += legacy[c];
+			dsum += decode[c];
+			lworst = legacy[c] > lworst ? legacy[c] : lworst;
+			dworst = decode[c] > dworst ? decode[c] : dworst;
+		}
+		printf("\nper key: legacy average %.1f, worst %.1f; decode average %.1f, worst %.1f %s\n",
+			lsum / 16, lworst, dsum / 16, dworst, TICKS);
+	}
+	return sink == 0xFFFFFFFFu;
+}
@@ -0,0 +1,328 @@
+/**
+  ******************************************************************************
+  * @file           : bench_lcd.c
+  * @brief          : Full-screen LCD redraw time, in virtual time.
+  *                   Clears the display and writes two 16-character lines,
+  *                   first through the original bit-banged Write_SR_LCD
+  *                   (Delay(1) per bit), then through the SPI/DMA transport.
+  *                   Then counts the controller bytes the shadow framebuffer
+  *                   sends for the firmware's usual screen changes, against
+  *                   the instructions and characters the calls asked for,
+  *                   and how far ahead of the display the calls return when
+  *                   every cell changes several times over. Last, draws each
+  *                   static screen over a full display through the calls,
+  *                   then with lcd_show() and its prebuilt bytes, counting
+  *                   the shift register bytes the CPU had to build, and
+  *                   one menu screen over the next, where lcd_show() only
+  *                   sends the few cells that differ.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include "main.h"
+#include "lcd.h"
+#include "sim.h"
+
+#define BURST 4
+
+void SystemClock_Config(void); // Core/Src/main.c
+
+static const char *lines[2] = {"0123456789ABCDEF", "FEDCBA9876543210"};
+static uint64_t legacy_us, queued_us, latched_us, asleep_us;
+static uint64_t burst_queued_us, burst_latched_us;
+static uint64_t drawn_us, shown_us; // All static screens, until latched
+static lcd_stats_t changes; // After the screen changes, before the rest
+static uint32_t drawn_built, shown_built, shown_streamed;
+static uint64_t menu_us; // Menu 2 over menu 1, until latched
+static uint32_t menu_built, menu_streamed;
+static uint32_t asked; // Write_Instr_LCD + Write_Char_LCD calls in a step
+
+typedef struct {
+	const char *name;
+	void (*draw)(void);
+	uint32_t asked, sent;
+	uint64_t us; // Until latched
+} step_t;
+
+// Write_SR_LCD() and friends as they were before the SPI transport
+static void legacy_sr(uint8_t temp)
+{
+	uint8_t mask = 0x80;
+	for (int i = 0; i < 8; i++) {
+		if ((temp & mask) == 0)
+			GPIOB->ODR &= ~(1 << 5);
+		else
+			GPIOB->ODR |= (1 << 5);
+		GPIOA->ODR &= ~(1 << 5);
+		GPIOA->ODR |= (1 << 5);
+		Delay(1);
+		mask = mask >> 1;
+	}
+	GPIOA->ODR |= (1 << 10);
+	GPIOA->ODR &= ~(1 << 10);
+}
+
+static void legacy_nibble(uint8_t temp, uint8_t s)
+{
+	temp = (temp & 0xF0) | 0x02 | (s & 1);
+	legacy_sr(temp);
+	legacy_sr(temp & 0xFD);
+}
+
+static void legacy_write(uint8_t code, uint8_t s)
+{
+	legacy_nibble(code & 0xF0, s);
+	legacy_nibble((uint8_t)(code << 4), s);
+}
+
+static void screen(void (*instr)(uint8_t), void (*chr)(uint8_t))
+{
+	instr(0x01);
+	for (int row = 0; row < 2; row++) {
+		instr(row == 0 ? 0x80 : 0xC0);
+		for (const char *c = lines[row]; *c != '\0'; c++) {
+			chr((uint8_t)*c);
+		}
+	}
+}
+
+static void legacy_instr(uint8_t code)
+{
+	legacy_write(code, 0);
+}
+
+static void legacy_char(uint8_t code)
+{
+	legacy_write(code, 1);
+}
+
+static void instr(uint8_t code)
+{
+	asked++;
+	Write_Instr_LCD(code);
+}
+
+static void chr(uint8_t code)
+{
+	asked++;
+	Write_Char_LCD(code);
+}
+
+static void string(const char *s)
+{
+	while (*s != '\0') {
+		chr((uint8_t)*s++);
+	}
+}
+
+// Screens as main() and adminmenu() draw them
+static void unlocked(void)
+{
+	instr(0x01);
+	string("UNLOCKED");
+	instr(0xC0);
+	string("10");
+}
+
+static void countdown(void)
+{
+	instr(0x10);
+	instr(0x10);
+	string("  ");
+	instr(0x10);
+	instr(0x10);
+	string("09");
+}
+
+static void menu(const char *option)
+{
+	instr(0x01);
+	string(option);
+	instr(0xC0);
+	string("A=SEL B=BACK #=>");
+}
+
+static void menu1(void)
+{
+	menu("1 - View Codes");
+}
+
+static void menu2(void)
+{
+	menu("2 - Add Codes");
+}
+
+static void locked(void)
+{
+	instr(0x01);
+	string("LOCKED");
+	instr(0xC0);
+}
+
+static void star(void)
+{
+	chr('*');
+}
+
+// Every DDRAM cell changed, a different character each time
+static void whole(int round)
+{
+	for (int row = 0; row < 2; row++) {
+		instr(row == 0 ? 0x80 : 0xC0);
+		for (int i = 0; i < LCD_LINE; i++) {
+			chr((uint8_t)('A' + (round + row + i) % 26));
+		}
+	}
+}
+
+static void entered(void)
+{
+	instr(0x01);
+	string("LOCKED");
+	instr(0xC0);
+	string("****");
+}
+
+// In the order the lock shows them, starting from the full screen above
+static step_t steps[] = {
+	{"locked screen", locked},
+	{"key entered", star},
+	{"unlocked screen", unlocked},
+	{"countdown tick", countdown},
+	{"back to locked", entered},
+	{"admin menu", menu1},
+	{"menu next", menu2},
+};
+
+static int run(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	uint64_t start, asleep;
+
+	HAL_Init();
+	SystemClock_Config();
+
+	// Original wiring: PA5, PA10 and PB5 as plain outputs
+	GPIO_InitStruct.Pin = GPIO_PIN_5 | GPIO_PIN_10;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+	GPIO_InitStruct.Pin = GPIO_PIN_5;
+	HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+	start = sim_time_us();
+	screen(legacy_instr, legacy_char);
+	legacy_us = sim_time_us() - start;
+
+	lcd_init();
+	lcd_wait();
+	start = sim_time_us();
+	asleep = sim_asleep();
+	screen(Write_Instr_LCD, Write_Char_LCD);
+	lcd_flush();
+	queued_us = sim_time_us() - start;
+	lcd_wait();
+	latched_us = sim_time_us() - start;
+	asleep_us = (sim_asleep() - asleep) / SIM_US(1);
+
+	for (unsigned i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+		uint32_t before = lcd_stats()->bytes;
+
+		asked = 0;
+		start = sim_time_us();
+		steps[i].draw();
+		lcd_flush();
+		lcd_wait();
+		steps[i].us = sim_time_us() - start;
+		steps[i].asked = asked;
+		steps[i].sent = lcd_stats()->bytes - before;
+	}
+	changes = *lcd_stats();
+
+	// Flushes back to back, more than the queue holds
+	start = sim_time_us();
+	for (int round = 0; round < BURST; round++) {
+		whole(round);
+		lcd_flush();
+	}
+	burst_queued_us = sim_time_us() - start;
+	lcd_wait();
+	burst_latched_us = sim_time_us() - start;
+
+	for (int id = 0; id < LCD_SCREENS; id++) {
+		const lcd_screen_t *s = &lcd_screens[id];
+		uint32_t built, streamed;
+
+		screen(Write_Instr_LCD, Write_Char_LCD);
+		lcd_flush();
+		lcd_wait();
+		built = lcd_stats()->composed;
+		start = sim_time_us();
+		instr(0x01);
+		string(s->top);
+		if (s->bottom != NULL) {
+			instr(0xC0);
+			string(s->bottom);
+		}
+		lcd_flush();
+		lcd_wait();
+		drawn_us += sim_time_us() - start;
+		drawn_built += lcd_stats()->composed - built;
+
+		screen(Write_Instr_LCD, Write_Char_LCD);
+		lcd_flush();
+		lcd_wait();
+		built = lcd_stats()->composed;
+		streamed = lcd_stats()->streamed;
+		start = sim_time_us();
+		lcd_show((lcd_screen_id_t)id);
+		lcd_wait();
+		shown_us += sim_time_us() - start;
+		shown_built += lcd_stats()->composed - built;
+		shown_streamed += lcd_stats()->streamed - streamed;
+	}
+
+	lcd_show(LCD_SCREEN_MENU1);
+	lcd_wait();
+	menu_built = lcd_stats()->composed;
+	menu_streamed = lcd_stats()->streamed;
+	start = sim_time_us();
+	lcd_show(LCD_SCREEN_MENU2);
+	lcd_wait();
+	menu_us = sim_time_us() - start;
+	menu_built = lcd_stats()->composed - menu_built;
+	menu_streamed = lcd_stats()->streamed - menu_streamed;
+	return 0;
+}
+
+int main(void)
+{
+	sim_reset();
+	sim_run(run);
+	sim_lcd_print(stdout);
+	printf("full screen (clear + 2 addresses + 32 chars)\n");
+	printf("  bit-banged:  %8.3f ms\n", legacy_us / 1000.0);
+	printf("  SPI + DMA:   %8.3f ms until latched, %.3f ms before the calls returned, CPU asleep %.3f ms\n",
+		latched_us / 1000.0, queued_us / 1000.0, asleep_us / 1000.0);
+	printf("  busy violations %llu\n", (unsigned long long)sim_lcd_stats()->busy_violations);
+	printf("screen changes: instructions + chars asked for -> controller bytes sent by the shadow\n");
+	for (unsigned i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+		printf("  %-16s %3u -> %3u, %6.3f ms until latched\n", steps[i].name, (unsigned)steps[i].asked,
+			(unsigned)steps[i].sent, steps[i].us / 1000.0);
+	}
+	printf("  flushes %u, bytes %u, largest %u\n", (unsigned)changes.flushes, (unsigned)changes.bytes,
+		(unsigned)changes.max);
+	printf("%d whole-display rewrites without waiting, %u byte queue\n", BURST, (unsigned)LCD_QUEUE);
+	printf("  %.3f ms before the calls returned, %.3f ms until latched\n", burst_queued_us / 1000.0,
+		burst_latched_us / 1000.0);
+	printf("  deepest queue %u, stalls %u, busy violations %llu\n", (unsigned)lcd_stats()->depth,
+		(unsigned)lcd_stats()->stalls, (unsigned long long)sim_lcd_stats()->busy_violations);
+	printf("%d static screens over a full display, per screen: shift register bytes built by the CPU,\n"
+		"sent from flash, until latched\n", LCD_SCREENS);
+	printf("  changed cells: %6.1f built, %6.1f from flash, %6.3f ms\n", (double)drawn_built / LCD_SCREENS, 0.0,
+		drawn_us / 1000.0 / LCD_SCREENS);
+	printf("  lcd_show():    %6.1f built, %6.1f from flash, %6.3f ms\n", (double)shown_built / LCD_SCREENS,
+		(double)shown_streamed / LCD_SCREENS, shown_us / 1000.0 / LCD_SCREENS);
+	printf("  menu 2 over 1: %6u built, %6u from flash, %6.3f ms\n", (unsigned)menu_built,
+		(unsigned)menu_streamed, menu_us / 1000.0);
+	printf("  busy violations %llu\n", (unsigned long long)sim_lcd_stats()->busy_violations);
+	return 0;
+}
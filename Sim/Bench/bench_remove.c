@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file           : bench_remove.c
+  * @brief          : Host benchmark of removing hundreds of codes out of 999.
+  *                   Compares the original search-and-shuffle over
+  *                   codes[][4] (with its flags shifted along, as it needed
+  *                   to be correct), removing each marked code on its own
+  *                   after finding it with codestore_next(), and one
+  *                   codestore_sweep() pass.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "codestore.h"
+
+#define TOTAL 999
+#define ROUNDS 5
+
+static char legacy[TOTAL][4], work[TOTAL][4];
+static bool flags[TOTAL], workflags[TOTAL];
+static codestore_t marked, store, scratch;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// editcodes()'s removal: find the first marked code, shuffle the rest down
+// over it, once per marked code
+static int legacy_remove(char codes[][4], bool removing[], int total, int totalremoved)
+{
+	int current = 0;
+
+	for (int i = 0; i < totalremoved; i++) {
+		for (int j = 0; j < total; j++) {
+			if (removing[j] == true) {
+				current = j;
+				break;
+			}
+		}
+		for (int j = current; j < total - 1; j++) {
+			for (int k = 0; k < 4; k++) {
+				codes[j][k] = codes[j + 1][k];
+			}
+			removing[j] = removing[j + 1];
+		}
+		total--;
+	}
+	return total;
+}
+
+// Each marked code found in order and removed on its own
+static int single_remove(codestore_t *codes, const codestore_t *picked)
+{
+	char code[CODESTORE_MAX + 1];
+	int gone = 0;
+
+	for (codestore_key_t k = codestore_next(picked, CODESTORE_NONE); k != CODESTORE_NONE; k = codestore_next(picked, k)) {
+		codestore_code(k, code);
+		gone += codestore_remove(codes, code);
+	}
+	return gone;
+}
+
+int main(void)
+{
+	static const int counts[] = {100, 300, 500, 900};
+	volatile int sink = 0;
+
+	srand(3130);
+	printf("removing from %d codes, best of %d, microseconds\n\n", TOTAL, ROUNDS);
+	printf("%8s %12s %12s %12s %12s\n", "removed", "shuffle", "one by one", "sweep", "sweep gain");
+
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		double best[3] = {1e9, 1e9, 1e9};
+
+		// Distinct 4-digit codes, count of them marked
+		codestore_clear(&store);
+		codestore_clear(&marked);
+		for (int i = 0; i < TOTAL; i++) {
+			char code[5];
+
+			do {
+				snprintf(code, sizeof(code), "%04u", (unsigned)rand() % 10000);
+			} while (codestore_add(&store, code) == false);
+			memcpy(legacy[i], code, 4);
+			flags[i] = false;
+		}
+		for (int n = 0; n < counts[c]; ) {
+			int i = rand() % TOTAL;
+			char code[5];
+
+			if (flags[i] == false) {
+				flags[i] = true;
+				memcpy(code, legacy[i], 4);
+				code[4] = '\0';
+				codestore_mark(&store, code, true);
+				codestore_add(&marked, code);
+				n++;
+			}
+		}
+
+		for (int r = 0; r < ROUNDS; r++) {
+			double t0;
+
+			memcpy(work, legacy, sizeof(work));
+			memcpy(workflags, flags, sizeof(workflags));
+			t0 = now();
+			sink += legacy_remove(work, workflags, TOTAL, counts[c]);
+			best[0] = now() - t0 < best[0] ? now() - t0 : best[0];
+
+			scratch = store;
+			t0 = now();
+			sink += single_remove(&scratch, &marked);
+			best[1] = now() - t0 < best[1] ? now() - t0 : best[1];
+
+			scratch = store;
+			t0 = now();
+			sink += codestore_sweep(&scratch, NULL);
+			best[2] = now() - t0 < best[2] ? now() - t0 : best[2];
+		}
+		printf("%8d %12.1f %12.1f %12.1f %5.0fx %4.0fx\n", counts[c], best[0] * 1e6, best[1] * 1e6,
+			best[2] * 1e6, best[0] / best[2], best[1] / best[2]);
+	}
+	return sink == -1;
+}
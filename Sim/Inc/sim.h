@@ -0,0 +1,110 @@
+/**
+  ******************************************************************************
+  * @file           : sim.h
+  * @brief          : Host simulator control interface.
+  *                   Virtual time, virtual 4x4 keypad, virtual 16x2 LCD and
+  *                   a serial line to the console, used when the firmware
+  *                   in Core/Src is built for Linux.
+  ******************************************************************************
+  */
+
+#ifndef __SIM_H
+#define __SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Virtual time, never wall-clock. Kept in 1/16 ns units so that every
+// core clock the firmware uses (4, 16, 80 MHz) is a whole number of units.
+#define SIM_UNITS_PER_NS 16ULL
+#define SIM_US(us) ((uint64_t)(us) * 1000ULL * SIM_UNITS_PER_NS)
+#define SIM_MS(ms) (SIM_US(ms) * 1000ULL)
+
+uint64_t sim_now(void); // Virtual time since reset in units
+uint64_t sim_time_us(void); // Virtual time since reset in microseconds
+uint64_t sim_cycles(void); // Core cycles executed since reset
+uint64_t sim_asleep(void); // Virtual time the firmware spent in WFI
+uint64_t sim_stopped(void); // Virtual time the firmware spent in Stop 2
+void sim_advance(uint64_t cycles); // Runs the core forward, firing due interrupts
+void sim_advance_to(uint64_t when); // Runs virtual time forward to an absolute point
+void sim_idle(void); // Firmware is waiting, skip ahead to the next event
+bool sim_core_stopped(void); // The firmware is in Stop 2 right now
+
+// Generic one-shot events for peripheral models
+void sim_event_at(uint64_t when, void (*fn)(void *), void *arg);
+
+// Keypad
+typedef char (*sim_keysource_t)(void *ctx); // Returns next key, 0 when out of keys
+void sim_keys(const char *keys); // Queues a string of keys
+void sim_keys_source(sim_keysource_t source, void *ctx); // Pulls keys on demand
+void sim_keys_timing(uint32_t hold_us, uint32_t gap_us); // Key hold and gap times
+void sim_keys_paced(bool paced); // true = press on a fixed schedule, false = press when firmware waits
+uint64_t sim_keys_pressed(void); // Total presses delivered
+bool sim_keys_pending(void); // Keys still queued or held
+void sim_keys_contact(uint64_t when, char key, bool closed); // Opens or closes one contact at a virtual time, for bounce traces; queue after sim_reset()
+
+// Press to the first column scan the firmware makes for it
+typedef struct {
+	uint64_t scanned; // Presses that were scanned
+	uint64_t total, max; // Press to first scan, in virtual time units
+} sim_scan_stats_t;
+
+const sim_scan_stats_t *sim_keys_scan_stats(void);
+
+// LCD
+typedef struct {
+	uint64_t bytes; // Shift register latches
+	uint64_t nibbles; // EN falling edges
+	uint64_t instructions; // Complete instructions executed
+	uint64_t chars; // Complete data writes
+	uint64_t clears; // Clear display instructions
+	uint64_t busy_violations; // Nibbles sent while the controller was busy
+	uint64_t busy_time; // Controller execution time requested, in virtual time units
+} sim_lcd_stats_t;
+
+void sim_lcd_line(int row, char out[17]); // Visible text of row 0 or 1
+const sim_lcd_stats_t *sim_lcd_stats(void);
+void sim_lcd_stats_reset(void);
+uint64_t sim_lcd_version(void); // Increments on every visible change
+void sim_lcd_print(FILE *out); // Draws the display as a framed box
+
+// Outputs
+uint16_t sim_leds(void); // Bit per LED in PA0, PA1, PC7, PC8 order
+uint64_t sim_buzzer_edges(void); // Speaker toggles on PC9
+
+// Flash, 1 MB at FLASH_BASE that outlives sim_reset()
+void sim_flash_wipe(void); // Erases it all and zeroes the counters
+bool sim_flash_load(const char *path); // Image from a file, false if there was none
+bool sim_flash_save(const char *path);
+void sim_flash_cut(uint32_t ops); // Power fails during the ops-th operation from now, leaving it half done
+void sim_flash_restore(void); // Power back, operations work again
+uint32_t sim_flash_erases(uint32_t addr); // Times the page holding addr was erased
+uint64_t sim_flash_programs(void); // Double-words programmed
+uint64_t sim_flash_operations(void); // Programs and page erases started, what sim_flash_cut() counts
+
+// Console on USART2, 8N1 at the rate the firmware set
+void sim_uart_send(const void *data, size_t len); // Queues bytes for the RX pin, sent back to back
+size_t sim_uart_take(char *out, size_t max); // Bytes the firmware sent since the last call, when not attached
+void sim_uart_attach(int fd, bool wait); // Bridges to a descriptor, -1 to detach; wait = run at wall-clock speed and past the keys
+int sim_uart_pty(char *name, size_t size, bool wait); // Opens a raw pty and attaches its master, returned, or -1
+uint64_t sim_uart_lost(void); // Bytes whose start bit came while the firmware was in Stop 2
+
+// Runner
+typedef void (*sim_idlehook_t)(void *ctx);
+void sim_reset(void); // Power-on reset of all models
+void sim_settle(uint64_t us); // Idle time after the last key before sim_run returns
+void sim_idle_hook(sim_idlehook_t hook, void *ctx); // Called each time firmware goes idle
+int sim_run(int (*entry)(void)); // Runs firmware until it idles with no keys left
+void sim_stop(void); // Ends sim_run from inside firmware
+void sim_interrupt(void); // Ends sim_run at the next wait, safe from a signal handler
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_H */
@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * @file           : stm32l4xx_hal.h (host simulator)
+  * @brief          : Shadows the HAL header for Linux builds.
+  *                   Pulls in the real HAL and CMSIS types, then points every
+  *                   peripheral instance used by the firmware at a simulated
+  *                   register block. Accessing a GPIO port through its macro
+  *                   lets the simulator see pin edges and refresh inputs.
+  ******************************************************************************
+  */
+
+#ifndef __SIM_STM32L4xx_HAL_H
+#define __SIM_STM32L4xx_HAL_H
+
+#include_next "stm32l4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Simulated register blocks
+GPIO_TypeDef *sim_gpio(uint32_t port);
+SysTick_Type *sim_systick(void);
+DWT_Type *sim_dwt(void);
+CoreDebug_Type *sim_coredebug(void);
+extern RCC_TypeDef sim_rcc;
+EXTI_TypeDef *sim_exti(void);
+TIM_TypeDef *sim_tim(uint32_t timer);
+SPI_TypeDef *sim_spi(uint32_t spi);
+LPTIM_TypeDef *sim_lptim(uint32_t timer);
+FLASH_TypeDef *sim_flash(void);
+USART_TypeDef *sim_usart(uint32_t usart);
+
+// Core intrinsics that cannot run on the host
+void sim_disable_irq(void);
+void sim_enable_irq(void);
+uint32_t sim_get_primask(void);
+void sim_set_primask(uint32_t primask);
+void sim_wfi(void);
+
+#undef GPIOA
+#undef GPIOB
+#undef GPIOC
+#undef GPIOD
+#undef GPIOE
+#undef GPIOF
+#undef GPIOG
+#undef GPIOH
+#define GPIOA (sim_gpio(0))
+#define GPIOB (sim_gpio(1))
+#define GPIOC (sim_gpio(2))
+#define GPIOD (sim_gpio(3))
+#define GPIOE (sim_gpio(4))
+#define GPIOF (sim_gpio(5))
+#define GPIOG (sim_gpio(6))
+#define GPIOH (sim_gpio(7))
+
+#undef SysTick
+#define SysTick (sim_systick())
+
+#undef DWT
+#undef CoreDebug
+#define DWT (sim_dwt())
+#define CoreDebug (sim_coredebug())
+
+#undef RCC
+#define RCC (&sim_rcc)
+
+#undef EXTI
+#define EXTI (sim_exti())
+
+#undef TIM1
+#undef TIM2
+#undef TIM3
+#undef TIM6
+#undef TIM7
+#undef TIM8
+#define TIM1 (sim_tim(1))
+#define TIM2 (sim_tim(2))
+#define TIM3 (sim_tim(3))
+#define TIM6 (sim_tim(6))
+#define TIM7 (sim_tim(7))
+#define TIM8 (sim_tim(8))
+
+#undef SPI1
+#define SPI1 (sim_spi(1))
+
+#undef LPTIM1
+#define LPTIM1 (sim_lptim(1))
+
+#undef FLASH
+#define FLASH (sim_flash())
+
+#undef USART2
+#define USART2 (sim_usart(2))
+
+#undef __NOP
+#undef __WFI
+#undef __WFE
+#define __disable_irq() sim_disable_irq()
+#define __enable_irq() sim_enable_irq()
+#define __get_PRIMASK() sim_get_primask()
+#define __set_PRIMASK(primask) sim_set_primask(primask)
+#define __NOP() ((void)0)
+#define __WFI() sim_wfi()
+#define __WFE() sim_wfi()
+#define __DSB() ((void)0)
+#define __ISB() ((void)0)
+#define __DMB() ((void)0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_STM32L4xx_HAL_H */
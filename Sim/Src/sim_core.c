@@ -0,0 +1,524 @@
+/**
+  ******************************************************************************
+  * @file           : sim_core.c
+  * @brief          : Virtual time, interrupt dispatch and the firmware runner.
+  *                   Time only moves when the firmware burns cycles, delays or
+  *                   waits. A wait skips straight to the next thing that can
+  *                   change what the firmware sees, so seconds of lock time
+  *                   simulate in microseconds.
+  ******************************************************************************
+  */
+
+#include <setjmp.h>
+#include <signal.h>
+#include <string.h>
+#include "sim_periph.h"
+
+#define SIM_EVENTS 32
+#define SIM_IRQS 16
+#define SIM_SPIN_LIMIT 32 // Hardware polls without progress before the firmware counts as waiting
+#define SIM_SCREEN_WAIT SIM_MS(1) // Idle with nothing due for this long shows the screen
+#define SIM_INPUT_WAIT SIM_MS(4000) // Longer than any timed screen, so idle this long means waiting for input
+
+typedef struct {
+	uint64_t when;
+	void (*fn)(void *);
+	void *arg;
+} sim_event_t;
+
+static struct {
+	uint64_t now, cycles, settle, asleep, stopped;
+	uint64_t next; // Cached earliest model event, 0 when it must be recomputed
+	uint32_t clock, upc; // Core clock the cached units per cycle belong to
+	bool primask, active, running;
+	bool instop; // Inside sim_stop2()
+	uint32_t spin;
+	jmp_buf exit;
+	sim_idlehook_t hook;
+	void *hookctx;
+	sim_event_t events[SIM_EVENTS];
+	int nevents;
+	sim_handler_t irqs[SIM_IRQS];
+	int nirqs;
+	SysTick_Type systick;
+	uint32_t st_ctrl, st_val; // Last values seen, to spot firmware writes
+	uint64_t st_next;
+	DWT_Type dwt;
+	CoreDebug_Type coredebug;
+	uint32_t dwt_cyccnt; // Last value published, to spot firmware writes
+	uint64_t dwt_base; // Core cycle count at which CYCCNT read 0
+	bool dwt_running;
+} sim;
+
+static volatile sig_atomic_t interrupted = 0; // Set from a signal handler, outside sim so resets keep it
+
+bool sim_in_isr;
+
+// Units of virtual time per core clock cycle
+static uint64_t unitspercycle(void)
+{
+	if (sim.clock != SystemCoreClock) {
+		sim.clock = SystemCoreClock;
+		sim.upc = (uint32_t)((SIM_UNITS_PER_NS * 1000000000ULL + SystemCoreClock / 2) / SystemCoreClock);
+	}
+	return sim.upc;
+}
+
+uint64_t sim_units(uint64_t cycles)
+{
+	return cycles * unitspercycle();
+}
+
+// Something was scheduled, drop the cached next event time
+void sim_reschedule(void)
+{
+	sim.next = 0;
+}
+
+uint64_t sim_now(void)
+{
+	return sim.now;
+}
+
+uint64_t sim_time_us(void)
+{
+	return sim.now / SIM_US(1);
+}
+
+uint64_t sim_cycles(void)
+{
+	return sim.cycles;
+}
+
+uint64_t sim_asleep(void)
+{
+	return sim.asleep;
+}
+
+uint64_t sim_stopped(void)
+{
+	return sim.stopped;
+}
+
+bool sim_core_stopped(void)
+{
+	return sim.instop;
+}
+
+// Queues a one-shot model event at an absolute time
+void sim_event_at(uint64_t when, void (*fn)(void *), void *arg)
+{
+	if (sim.nevents == SIM_EVENTS) {
+		fprintf(stderr, "sim: event pool exhausted\n");
+		return;
+	}
+	sim.events[sim.nevents].when = when;
+	sim.events[sim.nevents].fn = fn;
+	sim.events[sim.nevents].arg = arg;
+	sim.nevents++;
+	sim_reschedule();
+}
+
+// Marks an interrupt pending, like setting its NVIC pending bit
+void sim_irq_pend(sim_handler_t handler)
+{
+	for (int i = 0; i < sim.nirqs; i++) {
+		if (sim.irqs[i] == handler) {
+			return;
+		}
+	}
+	if (sim.nirqs < SIM_IRQS) {
+		sim.irqs[sim.nirqs++] = handler;
+	}
+}
+
+// Pends an external interrupt, dropped while the firmware has it disabled
+void sim_irq_raise(IRQn_Type IRQn, sim_handler_t handler)
+{
+	if (handler != NULL && sim_nvic_enabled(IRQn)) {
+		sim_irq_pend(handler);
+	}
+}
+
+// Cycles per SysTick wrap, in virtual time units
+static uint64_t systickperiod(void)
+{
+	return ((uint64_t)(sim.systick.LOAD & SysTick_LOAD_RELOAD_Msk) + 1) * unitspercycle();
+}
+
+// Moves the next wrap past now without firing anything
+static void systickroll(void)
+{
+	if (sim.st_next != SIM_NEVER && sim.st_next <= sim.now) {
+		uint64_t period = systickperiod();
+		sim.st_next += ((sim.now - sim.st_next) / period + 1) * period;
+		sim.systick.CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+	}
+}
+
+// Brings the SysTick model up to date with firmware register writes
+static void systick_sync(void)
+{
+	SysTick_Type *st = &sim.systick;
+
+	if (st->CTRL != sim.st_ctrl || st->VAL != sim.st_val) {
+		sim_reschedule();
+	}
+	if ((st->CTRL & SysTick_CTRL_ENABLE_Msk) == 0) {
+		sim.st_next = SIM_NEVER;
+	} else if (st->VAL != sim.st_val || (sim.st_ctrl & SysTick_CTRL_ENABLE_Msk) == 0) {
+		sim.st_next = sim.now + systickperiod(); // Counter cleared or just enabled
+	} else {
+		systickroll();
+	}
+
+	// Publish the live counter value
+	if (sim.st_next != SIM_NEVER) {
+		st->VAL = (uint32_t)((sim.st_next - sim.now) / unitspercycle()) & SysTick_VAL_CURRENT_Msk;
+	}
+	sim.st_ctrl = st->CTRL;
+	sim.st_val = st->VAL;
+}
+
+SysTick_Type *sim_systick(void)
+{
+	systick_sync();
+	return &sim.systick;
+}
+
+// CYCCNT follows the core cycle count while TRCENA and CYCCNTENA are set
+static void dwt_sync(void)
+{
+	bool running = (sim.coredebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) &&
+		(sim.dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+
+	if (sim.dwt.CYCCNT != sim.dwt_cyccnt || running != sim.dwt_running) {
+		sim.dwt_base = sim.cycles - sim.dwt.CYCCNT; // Written, or started or stopped here
+		sim.dwt_running = running;
+	}
+	if (running) {
+		sim.dwt.CYCCNT = (uint32_t)(sim.cycles - sim.dwt_base);
+	}
+	sim.dwt_cyccnt = sim.dwt.CYCCNT;
+}
+
+DWT_Type *sim_dwt(void)
+{
+	dwt_sync();
+	return &sim.dwt;
+}
+
+CoreDebug_Type *sim_coredebug(void)
+{
+	dwt_sync();
+	return &sim.coredebug;
+}
+
+// Earliest time at which any model changes state. The SysTick interrupt
+// can be left out, since a periodic tick alone is not work in progress.
+static uint64_t nextevent(bool tick)
+{
+	uint64_t next = sim_keypad_next();
+
+	// Register writes made since the last access must count
+	sim_exti_sync();
+	sim_tim_sync();
+	if (sim_tim_next() < next) {
+		next = sim_tim_next();
+	}
+	sim_lptim_sync();
+	if (sim_lptim_next() < next) {
+		next = sim_lptim_next();
+	}
+
+	// SysTick only matters when it interrupts, otherwise it is rolled on read
+	if (tick && (sim.systick.CTRL & SysTick_CTRL_TICKINT_Msk) && sim.st_next < next) {
+		next = sim.st_next;
+	}
+	for (int i = 0; i < sim.nevents; i++) {
+		if (sim.events[i].when < next) {
+			next = sim.events[i].when;
+		}
+	}
+	return next;
+}
+
+// Runs every model whose time has come
+static void runmodels(void)
+{
+	if (sim.st_next <= sim.now) {
+		systickroll();
+		sim.st_ctrl = sim.systick.CTRL;
+		if (sim.systick.CTRL & SysTick_CTRL_TICKINT_Msk) {
+			sim_irq_pend(SysTick_Handler);
+		}
+	}
+
+	sim_tim_update(sim.now);
+	sim_lptim_update(sim.now);
+	if (sim_keypad_update(sim.now)) {
+		sim_gpio_sync();
+	}
+
+	for (int i = 0; i < sim.nevents; i++) {
+		if (sim.events[i].when <= sim.now) {
+			sim_event_t ev = sim.events[i];
+			sim.events[i] = sim.events[--sim.nevents];
+			ev.fn(ev.arg);
+			i = -1; // Event may have queued others, rescan
+		}
+	}
+}
+
+// Calls pending handlers when interrupts are allowed
+static void dispatch(void)
+{
+	if (sim_in_isr || sim.primask) {
+		return;
+	}
+	while (sim.nirqs > 0) {
+		sim_handler_t handler = sim.irqs[0];
+		sim.nirqs--;
+		memmove(&sim.irqs[0], &sim.irqs[1], sim.nirqs * sizeof(sim.irqs[0]));
+		sim_in_isr = true;
+		handler();
+		sim_in_isr = false;
+	}
+}
+
+void sim_advance_to(uint64_t when)
+{
+	uint64_t next;
+
+	// Nothing due before the target, just move the clock
+	if (sim.next > when) {
+		sim.now = when > sim.now ? when : sim.now;
+		if (sim.nirqs > 0) {
+			dispatch();
+		}
+		return;
+	}
+
+	for (;;) {
+		next = nextevent(true);
+		sim.next = next;
+		if (next > when) {
+			break;
+		}
+		sim.next = 0;
+		if (next > sim.now) {
+			sim.now = next;
+		}
+		runmodels();
+		dispatch();
+	}
+	if (sim.now < when) {
+		sim.now = when;
+	}
+	dispatch();
+}
+
+void sim_advance(uint64_t cycles)
+{
+	uint64_t end = sim.now + cycles * unitspercycle();
+
+	// Long delays are waits too. Let display writes still in flight land,
+	// then show the hook the screen.
+	if (!sim_in_isr && sim.hook != NULL && cycles >= SystemCoreClock / 20U) {
+		sim_advance_to(sim.now + SIM_MS(10));
+		sim.hook(sim.hookctx);
+	}
+	sim.cycles += cycles;
+	sim_advance_to(end);
+}
+
+// Firmware changed an output from the main context
+void sim_activity(void)
+{
+	if (!sim_in_isr) {
+		sim.active = true;
+	}
+}
+
+// Main context touched hardware. Repeated touches with no progress are a
+// busy-wait, which is treated like a sleep until the next event.
+void sim_poll(uint32_t cycles)
+{
+	if (!sim_in_isr) {
+		if (sim.active) {
+			sim.active = false;
+			sim.spin = 0;
+		} else if (++sim.spin >= SIM_SPIN_LIMIT) {
+			sim.spin = 0;
+			sim_idle();
+		}
+	}
+	sim_advance(cycles);
+}
+
+// Skips to the next event. The core clock counts the time unless the
+// clocks are stopped.
+static void waitnext(bool clocked)
+{
+	uint64_t next, wake = SIM_NEVER;
+
+	// The screen is shown whenever nothing but the tick is due soon, so
+	// sleeping through a peripheral transfer does not count. Keys are only
+	// offered when nothing, the tick included, is due for longer than a timed
+	// screen lasts, so a message waiting on its timer or a tone driven from
+	// the tick is not taken as waiting for the user. Once the keys run out,
+	// a console attached to wait keeps the run going, paced to the wall
+	// clock so it waits for the host instead of racing past its timers.
+	if (interrupted) {
+		interrupted = 0;
+		sim_stop();
+	}
+	if (nextevent(false) > sim.now + SIM_SCREEN_WAIT && sim.hook != NULL) {
+		sim.hook(sim.hookctx);
+	}
+	sim_uart_poll();
+	if (nextevent(true) > sim.now + SIM_INPUT_WAIT) {
+		wake = sim_keypad_wait(sim.now, sim.settle);
+		sim_reschedule();
+		if (sim_keypad_done(sim.now, sim.settle) && sim_uart_wait() == false) {
+			sim_stop();
+		}
+	}
+
+	next = nextevent(true);
+	if (wake < next) {
+		next = wake;
+	}
+	next = sim_uart_pace(sim.now, next);
+	if (next <= sim.now) {
+		next = sim.now + unitspercycle();
+	}
+	if (clocked) {
+		sim.cycles += (next - sim.now) / unitspercycle(); // Core keeps clocking while asleep
+	}
+	sim_advance_to(next);
+}
+
+void sim_idle(void)
+{
+	waitnext(true);
+}
+
+void sim_disable_irq(void)
+{
+	sim.primask = true;
+}
+
+void sim_enable_irq(void)
+{
+	sim.primask = false;
+	dispatch();
+}
+
+uint32_t sim_get_primask(void)
+{
+	return sim.primask ? 1U : 0U;
+}
+
+void sim_set_primask(uint32_t primask)
+{
+	if (primask & 1U) {
+		sim_disable_irq();
+	} else {
+		sim_enable_irq();
+	}
+}
+
+void sim_wfi(void)
+{
+	uint64_t start = sim.now;
+
+	if (sim_in_isr || sim.nirqs > 0) {
+		dispatch();
+		return;
+	}
+	sim.spin = 0;
+	sim_idle();
+	sim.asleep += sim.now - start;
+}
+
+// Unlike WFI, events that raise no interrupt do not end Stop 2
+void sim_stop2(void)
+{
+	uint64_t start = sim.now;
+
+	if (sim_in_isr || sim.nirqs > 0) {
+		dispatch();
+		return;
+	}
+	sim.spin = 0;
+	sim.instop = true;
+	while (sim.nirqs == 0) {
+		waitnext(false);
+		sim.stopped += sim.now - start; // Counted as it goes, the run may end in here
+		start = sim.now;
+	}
+	sim.instop = false;
+}
+
+void sim_settle(uint64_t us)
+{
+	sim.settle = SIM_US(us);
+}
+
+void sim_idle_hook(sim_idlehook_t hook, void *ctx)
+{
+	sim.hook = hook;
+	sim.hookctx = ctx;
+}
+
+void sim_reset(void)
+{
+	uint64_t settle = sim.settle;
+	sim_idlehook_t hook = sim.hook;
+	void *hookctx = sim.hookctx;
+
+	memset(&sim, 0, sizeof(sim));
+	sim.st_next = SIM_NEVER;
+	sim.settle = settle != 0 ? settle : SIM_MS(15000);
+	sim.hook = hook;
+	sim.hookctx = hookctx;
+	sim_in_isr = false;
+	sim_gpio_reset();
+	sim_exti_reset();
+	sim_tim_reset();
+	sim_lptim_reset();
+	sim_dma_reset();
+	sim_spi_reset();
+	sim_flash_reset();
+	sim_keypad_reset();
+	sim_lcd_reset();
+	sim_uart_reset();
+	sim_hal_reset();
+}
+
+void sim_interrupt(void)
+{
+	interrupted = 1;
+}
+
+void sim_stop(void)
+{
+	if (sim.running) {
+		longjmp(sim.exit, 1);
+	}
+}
+
+int sim_run(int (*entry)(void))
+{
+	volatile int ret = 0;
+
+	sim.running = true;
+	if (setjmp(sim.exit) == 0) {
+		ret = entry();
+	}
+	sim.running = false;
+	sim_in_isr = false;
+	sim.primask = false;
+	return ret;
+}
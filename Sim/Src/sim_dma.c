@@ -0,0 +1,258 @@
+/**
+  ******************************************************************************
+  * @file           : sim_dma.c
+  * @brief          : DMA1/DMA2 model behind the HAL_DMA_* API.
+  *                   Channels move one item per peripheral request. Addresses
+  *                   come from the firmware as uint32_t, which works because
+  *                   the host build is linked without PIE so every static
+  *                   buffer and simulated register sits below 4 GiB.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+#define SIM_DMA_CHANNELS 14
+
+typedef struct {
+	DMA_HandleTypeDef *hdma;
+	uintptr_t src, dst;
+	uintptr_t src0, dst0; // Where a circular transfer starts over
+	uint32_t left, total;
+	bool enabled, tc, ht;
+} sim_dmach_t;
+
+// Handlers the firmware may not define
+#define SIM_DMA_WEAK(n) void n(void) __attribute__((weak));
+SIM_DMA_WEAK(DMA1_Channel1_IRQHandler) SIM_DMA_WEAK(DMA1_Channel2_IRQHandler)
+SIM_DMA_WEAK(DMA1_Channel3_IRQHandler) SIM_DMA_WEAK(DMA1_Channel4_IRQHandler)
+SIM_DMA_WEAK(DMA1_Channel5_IRQHandler) SIM_DMA_WEAK(DMA1_Channel6_IRQHandler)
+SIM_DMA_WEAK(DMA1_Channel7_IRQHandler) SIM_DMA_WEAK(DMA2_Channel1_IRQHandler)
+SIM_DMA_WEAK(DMA2_Channel2_IRQHandler) SIM_DMA_WEAK(DMA2_Channel3_IRQHandler)
+SIM_DMA_WEAK(DMA2_Channel4_IRQHandler) SIM_DMA_WEAK(DMA2_Channel5_IRQHandler)
+SIM_DMA_WEAK(DMA2_Channel6_IRQHandler) SIM_DMA_WEAK(DMA2_Channel7_IRQHandler)
+
+static sim_dmach_t channels[SIM_DMA_CHANNELS];
+
+static const struct {
+	DMA_Channel_TypeDef *instance;
+	IRQn_Type irqn;
+	sim_handler_t handler;
+} chmap[SIM_DMA_CHANNELS] = {
+	{DMA1_Channel1, DMA1_Channel1_IRQn, DMA1_Channel1_IRQHandler},
+	{DMA1_Channel2, DMA1_Channel2_IRQn, DMA1_Channel2_IRQHandler},
+	{DMA1_Channel3, DMA1_Channel3_IRQn, DMA1_Channel3_IRQHandler},
+	{DMA1_Channel4, DMA1_Channel4_IRQn, DMA1_Channel4_IRQHandler},
+	{DMA1_Channel5, DMA1_Channel5_IRQn, DMA1_Channel5_IRQHandler},
+	{DMA1_Channel6, DMA1_Channel6_IRQn, DMA1_Channel6_IRQHandler},
+	{DMA1_Channel7, DMA1_Channel7_IRQn, DMA1_Channel7_IRQHandler},
+	{DMA2_Channel1, DMA2_Channel1_IRQn, DMA2_Channel1_IRQHandler},
+	{DMA2_Channel2, DMA2_Channel2_IRQn, DMA2_Channel2_IRQHandler},
+	{DMA2_Channel3, DMA2_Channel3_IRQn, DMA2_Channel3_IRQHandler},
+	{DMA2_Channel4, DMA2_Channel4_IRQn, DMA2_Channel4_IRQHandler},
+	{DMA2_Channel5, DMA2_Channel5_IRQn, DMA2_Channel5_IRQHandler},
+	{DMA2_Channel6, DMA2_Channel6_IRQn, DMA2_Channel6_IRQHandler},
+	{DMA2_Channel7, DMA2_Channel7_IRQn, DMA2_Channel7_IRQHandler},
+};
+
+static int chindex(DMA_Channel_TypeDef *instance)
+{
+	for (int i = 0; i < SIM_DMA_CHANNELS; i++) {
+		if (chmap[i].instance == instance) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static sim_dmach_t *channel(DMA_HandleTypeDef *hdma)
+{
+	int i = chindex(hdma->Instance);
+
+	return i < 0 ? NULL : &channels[i];
+}
+
+// Bytes per item on each side of the transfer
+static int itemsize(uint32_t align)
+{
+	if (align == DMA_PDATAALIGN_WORD || align == DMA_MDATAALIGN_WORD) {
+		return 4;
+	}
+	if (align == DMA_PDATAALIGN_HALFWORD || align == DMA_MDATAALIGN_HALFWORD) {
+		return 2;
+	}
+	return 1;
+}
+
+// Peripheral side of a transfer, simulated registers get a chance to react
+static void buswrite(uintptr_t addr, uint32_t value, int size)
+{
+	if (!sim_spi_dr_write(addr, value)) {
+		memcpy((void *)addr, &value, (size_t)size);
+		sim_gpio_bus(addr);
+	}
+}
+
+static uint32_t busread(uintptr_t addr, int size)
+{
+	uint32_t value = 0;
+
+	sim_gpio_bus(addr);
+	memcpy(&value, (const void *)addr, (size_t)size);
+	return value;
+}
+
+void sim_dma_request(DMA_Channel_TypeDef *instance, uint32_t request)
+{
+	int i = chindex(instance);
+	sim_dmach_t *ch;
+	DMA_InitTypeDef *init;
+	int psize, msize;
+	uint32_t value;
+
+	if (i < 0 || !channels[i].enabled || channels[i].hdma->Init.Request != request) {
+		return;
+	}
+	ch = &channels[i];
+	init = &ch->hdma->Init;
+	psize = itemsize(init->PeriphDataAlignment);
+	msize = itemsize(init->MemDataAlignment);
+
+	if (init->Direction == DMA_MEMORY_TO_PERIPH) {
+		value = busread(ch->src, msize);
+		buswrite(ch->dst, value, psize);
+		ch->src += init->MemInc == DMA_MINC_ENABLE ? msize : 0;
+		ch->dst += init->PeriphInc == DMA_PINC_ENABLE ? psize : 0;
+	} else {
+		value = busread(ch->src, psize);
+		memcpy((void *)ch->dst, &value, (size_t)msize);
+		ch->src += init->PeriphInc == DMA_PINC_ENABLE ? psize : 0;
+		ch->dst += init->MemInc == DMA_MINC_ENABLE ? msize : 0;
+	}
+
+	ch->left--;
+	if (ch->left == ch->total / 2 && ch->hdma->XferHalfCpltCallback != NULL) {
+		ch->ht = true;
+		sim_irq_raise(chmap[i].irqn, chmap[i].handler);
+	}
+	if (ch->left == 0) {
+		ch->tc = true;
+		if (init->Mode == DMA_CIRCULAR) {
+			ch->left = ch->total;
+			ch->src = ch->src0;
+			ch->dst = ch->dst0;
+		} else {
+			ch->enabled = false;
+		}
+		sim_irq_raise(chmap[i].irqn, chmap[i].handler);
+	}
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+	sim_dmach_t *ch = channel(hdma);
+
+	if (ch == NULL) {
+		return HAL_ERROR;
+	}
+	memset(ch, 0, sizeof(*ch));
+	ch->hdma = hdma;
+	hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+	hdma->State = HAL_DMA_STATE_READY;
+	hdma->Lock = HAL_UNLOCKED;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+	sim_dmach_t *ch = channel(hdma);
+
+	if (ch != NULL) {
+		memset(ch, 0, sizeof(*ch));
+	}
+	hdma->State = HAL_DMA_STATE_RESET;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+	sim_dmach_t *ch = channel(hdma);
+
+	if (ch == NULL || hdma->State != HAL_DMA_STATE_READY) {
+		return HAL_BUSY;
+	}
+	ch->src = ch->src0 = SrcAddress;
+	ch->dst = ch->dst0 = DstAddress;
+	ch->left = ch->total = DataLength;
+	ch->tc = ch->ht = false;
+	ch->enabled = true;
+	hdma->State = HAL_DMA_STATE_BUSY;
+	sim_poll(8);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+	return HAL_DMA_Start(hdma, SrcAddress, DstAddress, DataLength);
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma)
+{
+	sim_dmach_t *ch = channel(hdma);
+
+	if (ch != NULL) {
+		ch->enabled = ch->tc = ch->ht = false;
+	}
+	hdma->State = HAL_DMA_STATE_READY;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef *hdma)
+{
+	HAL_DMA_Abort(hdma);
+	if (hdma->XferAbortCallback != NULL) {
+		hdma->XferAbortCallback(hdma);
+	}
+	return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+	sim_dmach_t *ch = channel(hdma);
+
+	if (ch == NULL) {
+		return;
+	}
+	if (ch->ht) {
+		ch->ht = false;
+		if (hdma->XferHalfCpltCallback != NULL) {
+			hdma->XferHalfCpltCallback(hdma);
+		}
+	}
+	if (ch->tc) {
+		ch->tc = false;
+		if (!ch->enabled) {
+			hdma->State = HAL_DMA_STATE_READY;
+		}
+		if (hdma->XferCpltCallback != NULL) {
+			hdma->XferCpltCallback(hdma);
+		}
+	}
+}
+
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef *hdma)
+{
+	return hdma->State;
+}
+
+uint32_t sim_dma_remaining(DMA_Channel_TypeDef *instance)
+{
+	int i = chindex(instance);
+
+	return i < 0 || !channels[i].enabled ? 0 : channels[i].left;
+}
+
+void sim_dma_reset(void)
+{
+	memset(channels, 0, sizeof(channels));
+}
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file           : sim_exti.c
+  * @brief          : EXTI controller model and HAL_GPIO_EXTI_IRQHandler.
+  *                   GPIO edges on lines 0-15 set the pending bit of unmasked
+  *                   lines and raise the matching EXTI interrupt.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+// PR1 is write-1-to-clear. The value the firmware sees carries this reserved
+// bit, so a firmware write shows up as the bit going missing.
+#define SIM_PR1_MARK (1u << 31)
+
+// Handlers the firmware may not define
+void EXTI0_IRQHandler(void) __attribute__((weak));
+void EXTI1_IRQHandler(void) __attribute__((weak));
+void EXTI2_IRQHandler(void) __attribute__((weak));
+void EXTI3_IRQHandler(void) __attribute__((weak));
+void EXTI4_IRQHandler(void) __attribute__((weak));
+void EXTI9_5_IRQHandler(void) __attribute__((weak));
+void EXTI15_10_IRQHandler(void) __attribute__((weak));
+
+static struct {
+	EXTI_TypeDef regs;
+	uint32_t pending;
+} exti;
+
+// Raises the interrupt of every line in the mask
+static void raise(uint32_t lines)
+{
+	static const IRQn_Type single[5] = {EXTI0_IRQn, EXTI1_IRQn, EXTI2_IRQn, EXTI3_IRQn, EXTI4_IRQn};
+	static const sim_handler_t handlers[5] = {EXTI0_IRQHandler, EXTI1_IRQHandler,
+		EXTI2_IRQHandler, EXTI3_IRQHandler, EXTI4_IRQHandler};
+
+	for (int line = 0; line < 5; line++) {
+		if (lines & (1u << line)) {
+			sim_irq_raise(single[line], handlers[line]);
+		}
+	}
+	if (lines & 0x03E0u) {
+		sim_irq_raise(EXTI9_5_IRQn, EXTI9_5_IRQHandler);
+	}
+	if (lines & 0xFC00u) {
+		sim_irq_raise(EXTI15_10_IRQn, EXTI15_10_IRQHandler);
+	}
+}
+
+void sim_exti_sync(void)
+{
+	if ((exti.regs.PR1 & SIM_PR1_MARK) == 0) {
+		exti.pending &= ~exti.regs.PR1;
+	}
+	exti.regs.PR1 = exti.pending | SIM_PR1_MARK;
+
+	// A line unmasked while still pending interrupts straight away
+	if (exti.pending & exti.regs.IMR1) {
+		raise(exti.pending & exti.regs.IMR1);
+	}
+}
+
+EXTI_TypeDef *sim_exti(void)
+{
+	sim_exti_sync();
+	sim_reschedule(); // Mask changes are picked up before the next event
+	return &exti.regs;
+}
+
+void sim_exti_edge(uint32_t lines)
+{
+	sim_exti_sync();
+	lines &= exti.regs.IMR1 & 0xFFFFu;
+	if (lines != 0) {
+		exti.pending |= lines;
+		exti.regs.PR1 = exti.pending | SIM_PR1_MARK;
+		raise(lines);
+	}
+}
+
+// An edge on a pin the GPIO model does not trigger from, such as one in
+// alternate function mode, taking the edge selection from RTSR1 and FTSR1
+void sim_exti_pin(uint32_t lines, bool rising)
+{
+	sim_exti_sync();
+	sim_exti_edge(lines & (rising ? exti.regs.RTSR1 : exti.regs.FTSR1));
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin)
+{
+	sim_exti_sync();
+	if (exti.pending & GPIO_Pin) {
+		exti.pending &= ~(uint32_t)GPIO_Pin;
+		exti.regs.PR1 = exti.pending | SIM_PR1_MARK;
+		HAL_GPIO_EXTI_Callback(GPIO_Pin);
+	}
+}
+
+__attribute__((weak)) void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	(void)GPIO_Pin;
+}
+
+void sim_exti_reset(void)
+{
+	memset(&exti, 0, sizeof(exti));
+	exti.regs.PR1 = SIM_PR1_MARK;
+}
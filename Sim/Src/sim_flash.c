@@ -0,0 +1,338 @@
+/**
+  ******************************************************************************
+  * @file           : sim_flash.c
+  * @brief          : Internal flash model and the HAL_FLASH_* stand-ins.
+  *                   The 1 MB array is mapped at its real address, read-only,
+  *                   so firmware reads it through plain pointers and a stray
+  *                   store faults; the model writes through a second,
+  *                   writable mapping of the same memory. Double-word programming only clears bits
+  *                   and fails on a double-word that is not erased, page
+  *                   erase sets 2 KB back to 0xFF, and both charge their
+  *                   datasheet time as a busy-wait, or in the _IT variants
+  *                   finish after it with the FLASH interrupt, erases one
+  *                   page at a time like the HAL's handler. The array survives
+  *                   sim_reset() like real flash survives a power cycle.
+  *                   Tests can cut the power during any operation, which
+  *                   leaves it half done, and read back per-page erase counts.
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE // memfd_create
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "sim_periph.h"
+
+#define SIM_FLASH_SIZE 0x100000u // STM32L476RG, two banks of 512 KB
+#define SIM_FLASH_BANK 0x80000u
+#define SIM_FLASH_PAGE 0x800u
+#define SIM_FLASH_PAGES (SIM_FLASH_SIZE / SIM_FLASH_PAGE)
+#define SIM_PROGRAM_US 82 // tPROG double-word, datasheet typical
+#define SIM_ERASE_US 22020 // tERASE one page, datasheet typical
+
+static const uint8_t *array; // At FLASH_BASE, read-only
+static uint8_t *cells; // The same memory, for the model's own stores
+static bool locked = true;
+static uint32_t cut; // Operations left before the power fails, 0 = never
+static bool dead; // Power lost, every operation fails
+static uint32_t erases[SIM_FLASH_PAGES];
+static uint64_t programs;
+static uint64_t operations;
+static FLASH_TypeDef regs; // Error flags come back from the HAL calls, SR reads clear
+
+// Operation started by HAL_FLASH_Program_IT or HAL_FLASHEx_Erase_IT
+enum { OP_NONE, OP_PROGRAM, OP_ERASE };
+static struct {
+	int kind;
+	uint32_t address;
+	uint64_t data;
+	uint32_t bank, page, left; // Page being erased and pages left, it included
+	bool done, error; // Waiting for the interrupt handler
+} op;
+
+// Maps the array the first time, erased
+static void map(void)
+{
+	int fd;
+	void *at, *rw;
+
+	if (array != NULL) {
+		return;
+	}
+	fd = memfd_create("sim_flash", 0);
+	if (fd < 0 || ftruncate(fd, SIM_FLASH_SIZE) != 0) {
+		fprintf(stderr, "sim: cannot create flash\n");
+		exit(1);
+	}
+	at = mmap((void *)(uintptr_t)FLASH_BASE, SIM_FLASH_SIZE, PROT_READ, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+	rw = mmap(NULL, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (at != (void *)(uintptr_t)FLASH_BASE || rw == MAP_FAILED) {
+		fprintf(stderr, "sim: cannot map flash at 0x%08x\n", (unsigned)FLASH_BASE);
+		exit(1);
+	}
+	array = at;
+	cells = rw;
+	memset(cells, 0xFF, SIM_FLASH_SIZE);
+}
+
+// The flash controller keeps the core waiting for the operation
+static void busy(uint32_t us)
+{
+	sim_advance((uint64_t)us * (SystemCoreClock / 1000000U));
+}
+
+// Counts down to the power cut, true if this operation is the one it hits
+static bool cutnow(void)
+{
+	operations++;
+	if (cut != 0 && --cut == 0) {
+		dead = true;
+		return true;
+	}
+	return false;
+}
+
+FLASH_TypeDef *sim_flash(void)
+{
+	memset(&regs, 0, sizeof(regs));
+	return &regs;
+}
+
+void sim_flash_reset(void)
+{
+	map();
+	locked = true;
+	memset(&op, 0, sizeof(op));
+}
+
+void sim_flash_wipe(void)
+{
+	map();
+	memset(cells, 0xFF, SIM_FLASH_SIZE);
+	memset(erases, 0, sizeof(erases));
+	programs = 0;
+	operations = 0;
+	cut = 0;
+	dead = false;
+}
+
+bool sim_flash_load(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	size_t got;
+
+	map();
+	if (f == NULL) {
+		return false;
+	}
+	got = fread(cells, 1, SIM_FLASH_SIZE, f);
+	fclose(f);
+	return got == SIM_FLASH_SIZE;
+}
+
+bool sim_flash_save(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+	bool saved;
+
+	map();
+	if (f == NULL) {
+		return false;
+	}
+	saved = fwrite(array, 1, SIM_FLASH_SIZE, f) == SIM_FLASH_SIZE;
+	return fclose(f) == 0 && saved;
+}
+
+void sim_flash_cut(uint32_t ops)
+{
+	cut = ops;
+	dead = false;
+}
+
+void sim_flash_restore(void)
+{
+	cut = 0;
+	dead = false;
+	locked = true;
+}
+
+uint32_t sim_flash_erases(uint32_t addr)
+{
+	return addr >= FLASH_BASE && addr < FLASH_BASE + SIM_FLASH_SIZE ? erases[(addr - FLASH_BASE) / SIM_FLASH_PAGE] : 0;
+}
+
+uint64_t sim_flash_programs(void)
+{
+	return programs;
+}
+
+uint64_t sim_flash_operations(void)
+{
+	return operations;
+}
+
+// Programs one double-word, false on a programming error or with the power
+// gone. The operation the power cut hits gets only half its bits.
+static bool store(uint32_t Address, uint64_t Data)
+{
+	uint64_t old, value = Data;
+	uint32_t offset = Address - FLASH_BASE;
+
+	if (dead || locked || Address < FLASH_BASE || offset >= SIM_FLASH_SIZE || (offset & 7) != 0) {
+		return false;
+	}
+	memcpy(&old, array + offset, 8);
+	if (old != UINT64_MAX && Data != 0) { // PROGERR, only all zeros may go over a written double-word
+		return false;
+	}
+	if (cutnow()) { // Half the bits that should clear make it
+		uint64_t clear = ~Data & old;
+		uint64_t half = 0;
+
+		for (int bit = 0, n = 0; bit < 64; bit++) {
+			if ((clear >> bit) & 1u) {
+				half |= (uint64_t)(n++ & 1) << bit;
+			}
+		}
+		value = old & ~half;
+	}
+	memcpy(cells + offset, &value, 8);
+	programs++;
+	return !dead;
+}
+
+// Erases one page of a bank, false with the power gone. A cut leaves it half erased.
+static bool wipe(uint32_t bank, uint32_t page)
+{
+	uint32_t offset = (bank == FLASH_BANK_2 ? SIM_FLASH_BANK : 0) + page * SIM_FLASH_PAGE;
+
+	if (dead || locked) {
+		return false;
+	}
+	memset(cells + offset, 0xFF, cutnow() ? SIM_FLASH_PAGE / 2 : SIM_FLASH_PAGE);
+	erases[offset / SIM_FLASH_PAGE]++;
+	return !dead;
+}
+
+static bool erasable(const FLASH_EraseInitTypeDef *init)
+{
+	return init->TypeErase == FLASH_TYPEERASE_PAGES && init->NbPages > 0 &&
+		init->Page + init->NbPages <= SIM_FLASH_BANK / SIM_FLASH_PAGE;
+}
+
+// The operation started by an _IT call has run its time
+static void finished(void *arg)
+{
+	(void)arg;
+	op.error = op.kind == OP_PROGRAM ? !store(op.address, op.data) : !wipe(op.bank, op.page);
+	op.done = true;
+	sim_irq_raise(FLASH_IRQn, FLASH_IRQHandler);
+}
+
+// HAL stand-ins
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+	locked = false;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+	locked = true;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+	bool ok;
+
+	map();
+	if (op.kind != OP_NONE) {
+		return HAL_BUSY;
+	}
+	if (TypeProgram != FLASH_TYPEPROGRAM_DOUBLEWORD) {
+		return HAL_ERROR;
+	}
+	ok = store(Address, Data);
+	busy(SIM_PROGRAM_US);
+	return ok ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+	map();
+	*PageError = 0xFFFFFFFFu;
+	if (op.kind != OP_NONE) {
+		return HAL_BUSY;
+	}
+	if (erasable(pEraseInit) == false) {
+		return HAL_ERROR;
+	}
+	for (uint32_t page = pEraseInit->Page; page < pEraseInit->Page + pEraseInit->NbPages; page++) {
+		bool ok = wipe(pEraseInit->Banks, page);
+
+		busy(SIM_ERASE_US);
+		if (ok == false) {
+			*PageError = page;
+			return HAL_ERROR;
+		}
+	}
+	return HAL_OK;
+}
+
+// Like the HAL, the call returns at once and the procedure stays locked
+// until the interrupt handler's callbacks return
+HAL_StatusTypeDef HAL_FLASH_Program_IT(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+	map();
+	if (op.kind != OP_NONE) {
+		return HAL_BUSY;
+	}
+	if (TypeProgram != FLASH_TYPEPROGRAM_DOUBLEWORD) {
+		return HAL_ERROR;
+	}
+	op.kind = OP_PROGRAM;
+	op.address = Address;
+	op.data = Data;
+	sim_event_at(sim_now() + SIM_US(SIM_PROGRAM_US), finished, NULL);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase_IT(FLASH_EraseInitTypeDef *pEraseInit)
+{
+	map();
+	if (op.kind != OP_NONE) {
+		return HAL_BUSY;
+	}
+	if (erasable(pEraseInit) == false) {
+		return HAL_ERROR;
+	}
+	op.kind = OP_ERASE;
+	op.bank = pEraseInit->Banks;
+	op.page = pEraseInit->Page;
+	op.left = pEraseInit->NbPages;
+	sim_event_at(sim_now() + SIM_US(SIM_ERASE_US), finished, NULL);
+	return HAL_OK;
+}
+
+// End of operation or error, one page at a time for erases
+void HAL_FLASH_IRQHandler(void)
+{
+	if (op.done == false) {
+		return;
+	}
+	op.done = false;
+	if (op.error) {
+		HAL_FLASH_OperationErrorCallback(op.kind == OP_PROGRAM ? op.address : op.page);
+	} else if (op.kind == OP_ERASE && --op.left != 0) {
+		HAL_FLASH_EndOfOperationCallback(op.page);
+		op.page++;
+		sim_event_at(sim_now() + SIM_US(SIM_ERASE_US), finished, NULL);
+		return;
+	} else {
+		HAL_FLASH_EndOfOperationCallback(op.kind == OP_PROGRAM ? op.address : 0xFFFFFFFFu);
+	}
+	op.kind = OP_NONE;
+}
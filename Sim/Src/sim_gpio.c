@@ -0,0 +1,309 @@
+/**
+  ******************************************************************************
+  * @file           : sim_gpio.c
+  * @brief          : GPIO port model and the HAL_GPIO_* stand-ins.
+  *                   Every register access goes through sim_gpio(), and
+  *                   every DMA access through sim_gpio_bus(), which apply
+  *                   the previous write, turn output edges into shift
+  *                   register clocks and refresh the keypad rows.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+#define SIM_PORTS 8
+#define SIM_ACCESS_CYCLES 2 // Register load or store
+#define SIM_HAL_CYCLES 20 // HAL_GPIO_* call overhead
+
+typedef struct {
+	GPIO_TypeDef regs;
+	uint32_t out; // Driven pin levels as last applied, from ODR or a peripheral
+	uint32_t afout; // Levels peripherals drive on their alternate function pins
+	uint32_t moder, pupdr; // Configuration the masks below were decoded from
+	uint32_t outputs, afpins, pullups;
+	uint32_t rising, falling; // EXTI trigger selection from HAL_GPIO_Init
+} sim_port_t;
+
+static sim_port_t ports[SIM_PORTS];
+static uint32_t touched; // Ports handed to the firmware since the last sync
+static uint16_t leds;
+static uint64_t buzzedges;
+static bool syncing;
+
+// Pins whose MODER field selects the given mode
+static uint32_t modepins(const GPIO_TypeDef *regs, uint32_t mode)
+{
+	uint32_t mask = 0;
+
+	for (int pin = 0; pin < 16; pin++) {
+		if (((regs->MODER >> (2 * pin)) & 0x3) == mode) {
+			mask |= 1u << pin;
+		}
+	}
+	return mask;
+}
+
+// Pins with the pull-up selected in PUPDR
+static uint32_t pullups(const GPIO_TypeDef *regs)
+{
+	uint32_t mask = 0;
+
+	for (int pin = 0; pin < 16; pin++) {
+		if (((regs->PUPDR >> (2 * pin)) & 0x3) == 0x1) {
+			mask |= 1u << pin;
+		}
+	}
+	return mask;
+}
+
+// Reacts to output pin changes on a port
+static void edges(int port, uint32_t changed, uint32_t out)
+{
+	switch (port) {
+		case 0: // PA0/PA1 LEDs, PA5 shift clock, PA10 latch
+			if ((changed & (1u << 5)) && (out & (1u << 5))) {
+				sim_lcd_shift((ports[1].out >> 5) & 1);
+			}
+			if ((changed & (1u << 10)) && (out & (1u << 10))) {
+				sim_lcd_latch();
+			}
+			leds = (leds & ~0x3u) | (out & 0x3u);
+			break;
+		case 2: // PC7/PC8 LEDs, PC9 speaker
+			leds = (leds & ~0xCu) | ((out >> 5) & 0xCu);
+			if (changed & (1u << 9)) {
+				buzzedges++;
+			}
+			break;
+	}
+}
+
+// Re-decodes the mode masks after a MODER or PUPDR write
+static void decode(sim_port_t *p)
+{
+	if (p->regs.MODER != p->moder || p->regs.PUPDR != p->pupdr) {
+		p->moder = p->regs.MODER;
+		p->pupdr = p->regs.PUPDR;
+		p->outputs = modepins(&p->regs, 0x1);
+		p->afpins = modepins(&p->regs, 0x2);
+		p->pullups = pullups(&p->regs);
+	}
+}
+
+// Applies the levels a port now drives and reacts to the edges
+static void drive(int i)
+{
+	sim_port_t *p = &ports[i];
+	uint32_t out, changed;
+
+	decode(p);
+	out = (p->regs.ODR & p->outputs) | (p->afout & p->afpins);
+	changed = out ^ p->out;
+	if (changed != 0) {
+		p->out = out;
+		sim_activity();
+		edges(i, changed, out);
+	}
+}
+
+void sim_gpio_sync(void)
+{
+	if (syncing) {
+		return;
+	}
+	syncing = true;
+
+	// Only ports the firmware could have written need a look. Port B is
+	// always refreshed since the keypad rows change with time.
+	touched |= 1u << 1;
+	for (int i = 0; i < SIM_PORTS; i++) {
+		sim_port_t *p = &ports[i];
+
+		if ((touched & (1u << i)) == 0) {
+			continue;
+		}
+
+		// Write-only set/reset registers land in ODR
+		if (p->regs.BSRR != 0) {
+			p->regs.ODR = (p->regs.ODR & ~(p->regs.BSRR >> 16)) | (p->regs.BSRR & 0xFFFF);
+			p->regs.BSRR = 0;
+		}
+		if (p->regs.BRR != 0) {
+			p->regs.ODR &= ~p->regs.BRR;
+			p->regs.BRR = 0;
+		}
+		p->regs.ODR &= 0xFFFF;
+		drive(i);
+	}
+
+	// Pin levels as seen through IDR
+	for (int i = 0; i < SIM_PORTS; i++) {
+		sim_port_t *p = &ports[i];
+		uint32_t driven, level, rose, fell;
+
+		if ((touched & (1u << i)) == 0) {
+			continue;
+		}
+		driven = p->outputs | p->afpins;
+		level = p->out | (p->pullups & ~driven);
+
+		if (i == 1) {
+			level |= sim_keypad_rows(p->out & p->outputs & 0x1E) & ~driven;
+		}
+		rose = level & ~p->regs.IDR;
+		fell = ~level & p->regs.IDR;
+		p->regs.IDR = level;
+		if ((rose & p->rising) | (fell & p->falling)) {
+			sim_exti_edge((rose & p->rising) | (fell & p->falling));
+		}
+	}
+
+	touched = 0;
+	syncing = false;
+}
+
+void sim_gpio_af(uint32_t port, uint32_t pin, bool level)
+{
+	sim_port_t *p = &ports[port];
+
+	if (level) {
+		p->afout |= 1u << pin;
+	} else {
+		p->afout &= ~(1u << pin);
+	}
+	drive((int)port);
+	touched |= 1u << port; // IDR follows at the next sync
+}
+
+void sim_gpio_bus(uintptr_t addr)
+{
+	uintptr_t base = (uintptr_t)ports;
+
+	if (addr < base || addr >= base + sizeof(ports)) {
+		return;
+	}
+	touched |= 1u << ((addr - base) / sizeof(ports[0]));
+	sim_gpio_sync();
+}
+
+GPIO_TypeDef *sim_gpio(uint32_t port)
+{
+	sim_gpio_sync();
+	sim_poll(SIM_ACCESS_CYCLES);
+	touched |= 1u << port;
+	return &ports[port].regs;
+}
+
+// Maps a HAL port pointer back to its index
+static int portindex(GPIO_TypeDef *GPIOx)
+{
+	int port = (int)(((sim_port_t *)(void *)GPIOx) - ports);
+
+	touched |= 1u << port;
+	return port;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+	sim_port_t *p = &ports[portindex(GPIOx)];
+
+	for (uint32_t pin = 0; pin < 16; pin++) {
+		if ((GPIO_Init->Pin & (1u << pin)) == 0) {
+			continue;
+		}
+		p->regs.MODER = (p->regs.MODER & ~(0x3u << (2 * pin))) | ((GPIO_Init->Mode & GPIO_MODE) << (2 * pin));
+		p->regs.PUPDR = (p->regs.PUPDR & ~(0x3u << (2 * pin))) | (GPIO_Init->Pull << (2 * pin));
+		p->regs.OTYPER = (p->regs.OTYPER & ~(1u << pin)) | (((GPIO_Init->Mode & OUTPUT_TYPE) >> OUTPUT_TYPE_Pos) << pin);
+		p->rising &= ~(1u << pin);
+		p->falling &= ~(1u << pin);
+
+		// Like the HAL, EXTI is only set up for pins given an EXTI mode, so
+		// the same line number on another port keeps its interrupt
+		if (GPIO_Init->Mode & EXTI_MODE) {
+			if (GPIO_Init->Mode & EXTI_IT) {
+				EXTI->IMR1 |= 1u << pin;
+			} else {
+				EXTI->IMR1 &= ~(1u << pin);
+			}
+			if (GPIO_Init->Mode & TRIGGER_RISING) {
+				p->rising |= 1u << pin;
+			}
+			if (GPIO_Init->Mode & TRIGGER_FALLING) {
+				p->falling |= 1u << pin;
+			}
+		}
+	}
+	sim_gpio_sync();
+	sim_poll(SIM_HAL_CYCLES);
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+	sim_port_t *p = &ports[portindex(GPIOx)];
+
+	for (uint32_t pin = 0; pin < 16; pin++) {
+		if (GPIO_Pin & (1u << pin)) {
+			p->regs.MODER |= 0x3u << (2 * pin);
+			p->regs.PUPDR &= ~(0x3u << (2 * pin));
+			p->rising &= ~(1u << pin);
+			p->falling &= ~(1u << pin);
+		}
+	}
+	sim_gpio_sync();
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	portindex(GPIOx);
+	sim_poll(SIM_HAL_CYCLES);
+	sim_gpio_sync();
+	return (GPIOx->IDR & GPIO_Pin) != 0 ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	portindex(GPIOx);
+	if (PinState != GPIO_PIN_RESET) {
+		GPIOx->BSRR = GPIO_Pin;
+	} else {
+		GPIOx->BRR = GPIO_Pin;
+	}
+	sim_gpio_sync();
+	sim_poll(SIM_HAL_CYCLES);
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	uint32_t odr = GPIOx->ODR;
+
+	portindex(GPIOx);
+	GPIOx->BSRR = ((odr & GPIO_Pin) << 16) | (~odr & GPIO_Pin);
+	sim_gpio_sync();
+	sim_poll(SIM_HAL_CYCLES);
+}
+
+uint16_t sim_leds(void)
+{
+	return leds;
+}
+
+uint64_t sim_buzzer_edges(void)
+{
+	return buzzedges;
+}
+
+void sim_gpio_reset(void)
+{
+	memset(ports, 0, sizeof(ports));
+	for (int i = 0; i < SIM_PORTS; i++) {
+		ports[i].regs.MODER = 0xFFFFFFFF; // Analog after reset
+		ports[i].moder = ~ports[i].regs.MODER; // Force a decode on first sync
+	}
+	ports[0].regs.MODER = 0xABFFFFFF; // Debug pins on PA13-PA15
+	ports[1].regs.MODER = 0xFFFFFEBF; // SWO on PB3
+	touched = (1u << SIM_PORTS) - 1;
+	leds = 0;
+	buzzedges = 0;
+	syncing = false;
+}
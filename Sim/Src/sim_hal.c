@@ -0,0 +1,229 @@
+/**
+  ******************************************************************************
+  * @file           : sim_hal.c
+  * @brief          : Stand-ins for the HAL core, RCC, PWR and Cortex APIs.
+  *                   Clock configuration only tracks the resulting core clock,
+  *                   which sets how fast virtual cycles turn into time, and
+  *                   charges the PLL lock time. Stop 2 halts the core until
+  *                   an interrupt is pending, then wakes it on the clock
+  *                   RCC_CFGR.STOPWUCK selects with the PLL off.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+#define SIM_HSI_HZ 16000000U
+#define SIM_MSI_HZ 4000000U
+#define SIM_HSE_HZ 8000000U
+#define SIM_PLL_LOCK_US 40 // tLOCK, datasheet maximum
+#define SIM_STOP2_WAKE_US 6 // Stop 2 to first instruction on HSI16, datasheet typical
+
+uint32_t SystemCoreClock = SIM_MSI_HZ;
+const uint8_t AHBPrescTable[16] = {0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 1U, 2U, 3U, 4U, 6U, 7U, 8U, 9U};
+const uint8_t APBPrescTable[8] = {0U, 0U, 0U, 0U, 1U, 2U, 3U, 4U};
+const uint32_t MSIRangeTable[12] = {100000U, 200000U, 400000U, 800000U, 1000000U, 2000000U,
+                                    4000000U, 8000000U, 16000000U, 24000000U, 32000000U, 48000000U};
+
+RCC_TypeDef sim_rcc;
+__IO uint32_t uwTick;
+uint32_t uwTickPrio = (1UL << __NVIC_PRIO_BITS);
+HAL_TickFreqTypeDef uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+
+static RCC_OscInitTypeDef osc;
+static bool pllon;
+static uint32_t nvicenabled[3]; // Bit per external interrupt, like NVIC->ISER
+
+// HAL core
+HAL_StatusTypeDef HAL_Init(void)
+{
+	HAL_InitTick(TICK_INT_PRIORITY);
+	HAL_MspInit();
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+	SysTick->LOAD = (SystemCoreClock / (1000U / uwTickFreq)) - 1U;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+	uwTickPrio = TickPriority;
+	return HAL_OK;
+}
+
+void HAL_IncTick(void)
+{
+	uwTick += uwTickFreq;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	sim_poll(4);
+	return uwTick;
+}
+
+uint32_t HAL_GetTickPrio(void)
+{
+	return uwTickPrio;
+}
+
+HAL_TickFreqTypeDef HAL_GetTickFreq(void)
+{
+	return uwTickFreq;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+	sim_advance((uint64_t)Delay * (SystemCoreClock / 1000U));
+}
+
+void HAL_SuspendTick(void)
+{
+	SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+}
+
+void HAL_ResumeTick(void)
+{
+	SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+}
+
+// Cortex
+void HAL_NVIC_SetPriorityGrouping(uint32_t PriorityGroup)
+{
+	(void)PriorityGroup;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+	(void)IRQn;
+	(void)PreemptPriority;
+	(void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	nvicenabled[IRQn >> 5] |= 1u << (IRQn & 31);
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+	nvicenabled[IRQn >> 5] &= ~(1u << (IRQn & 31));
+}
+
+bool sim_nvic_enabled(IRQn_Type IRQn)
+{
+	return (nvicenabled[IRQn >> 5] >> (IRQn & 31)) & 1u;
+}
+
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb)
+{
+	SysTick->LOAD = TicksNumb - 1U;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+	return 0;
+}
+
+// Power
+HAL_StatusTypeDef HAL_PWREx_ControlVoltageScaling(uint32_t VoltageScaling)
+{
+	(void)VoltageScaling;
+	return HAL_OK;
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+}
+
+void HAL_PWREx_EnterSTOP2Mode(uint8_t STOPEntry)
+{
+	(void)STOPEntry;
+	sim_stop2();
+
+	// The PLL stopped with everything else
+	pllon = false;
+	SystemCoreClock = (sim_rcc.CFGR & RCC_CFGR_STOPWUCK) ? SIM_HSI_HZ : SIM_MSI_HZ;
+	sim_advance_to(sim_now() + SIM_US(SIM_STOP2_WAKE_US));
+}
+
+// Clocks
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+	// Only the PLL settings are needed later, and only when given
+	if (RCC_OscInitStruct->PLL.PLLState == RCC_PLL_ON) {
+		osc.PLL = RCC_OscInitStruct->PLL;
+		if (pllon == false) {
+			sim_advance((uint64_t)SIM_PLL_LOCK_US * (SystemCoreClock / 1000000U));
+			pllon = true;
+		}
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+	uint32_t input;
+
+	(void)FLatency;
+	switch (RCC_ClkInitStruct->SYSCLKSource) {
+		case RCC_SYSCLKSOURCE_PLLCLK:
+			if (osc.PLL.PLLSource == RCC_PLLSOURCE_HSE) {
+				input = SIM_HSE_HZ;
+			} else if (osc.PLL.PLLSource == RCC_PLLSOURCE_MSI) {
+				input = SIM_MSI_HZ;
+			} else {
+				input = SIM_HSI_HZ;
+			}
+			SystemCoreClock = input / osc.PLL.PLLM * osc.PLL.PLLN / osc.PLL.PLLR;
+			break;
+		case RCC_SYSCLKSOURCE_HSI:
+			SystemCoreClock = SIM_HSI_HZ;
+			break;
+		case RCC_SYSCLKSOURCE_HSE:
+			SystemCoreClock = SIM_HSE_HZ;
+			break;
+		default:
+			SystemCoreClock = SIM_MSI_HZ;
+			break;
+	}
+	return HAL_InitTick(uwTickPrio);
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+	(void)PeriphClkInit;
+	return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+	return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+	return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+	return SystemCoreClock;
+}
+
+// The CYCCNT loop in the firmware's delay_cycles() would spin for every
+// cycle at host speed, so the simulator charges the cycles in one step.
+void delay_cycles(uint32_t cycles)
+{
+	sim_advance(cycles);
+}
+
+void sim_hal_reset(void)
+{
+	memset(&sim_rcc, 0, sizeof(sim_rcc));
+	memset(&osc, 0, sizeof(osc));
+	pllon = false;
+	sim_rcc.BDCR = RCC_BDCR_LSERDY; // The LSE crystal is taken as already running
+	memset(nvicenabled, 0, sizeof(nvicenabled));
+	SystemCoreClock = SIM_MSI_HZ;
+	uwTick = 0;
+	uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+}
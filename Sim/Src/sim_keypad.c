@@ -0,0 +1,261 @@
+/**
+  ******************************************************************************
+  * @file           : sim_keypad.c
+  * @brief          : Virtual 4x4 matrix keypad.
+  *                   A pressed key connects its column output to its row
+  *                   input, so a row reads high only while the firmware
+  *                   drives that key's column high.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+#define SIM_KEYBUF 4096
+#define SIM_TRACE 1024 // Contact changes queued by sim_keys_contact()
+
+typedef struct {
+	uint64_t when;
+	uint16_t bit;
+	bool closed;
+} sim_contact_t;
+
+static const char keymap[4][4] =
+	{{'1', '2', '3', 'A'},
+	{'4', '5', '6', 'B'},
+	{'7', '8', '9', 'C'},
+	{'*', '0', '#', 'D'}};
+
+static struct {
+	char buf[SIM_KEYBUF];
+	size_t head, tail;
+	sim_keysource_t source;
+	void *ctx;
+	uint64_t hold, gap;
+	bool paced;
+	char down, next; // Key held now, key scheduled next
+	uint16_t mask; // Held keys, bit (row * 4 + col)
+	uint64_t pressat, releaseat, lastrelease;
+	uint64_t pressed;
+	bool scanned; // Firmware has driven the columns since the press
+	sim_contact_t trace[SIM_TRACE];
+	size_t ntrace, traced; // Changes queued, changes applied
+	sim_scan_stats_t scans;
+} kp;
+
+// Matrix position of a key, -1 if it is not on the pad
+static int keybit(char key)
+{
+	for (int row = 0; row < 4; row++) {
+		for (int col = 0; col < 4; col++) {
+			if (keymap[row][col] == key) {
+				return row * 4 + col;
+			}
+		}
+	}
+	return -1;
+}
+
+// Takes the next key from the queue, then from the source
+static char nextkey(void)
+{
+	char key;
+
+	do {
+		if (kp.head != kp.tail) {
+			key = kp.buf[kp.tail];
+			kp.tail = (kp.tail + 1) % SIM_KEYBUF;
+		} else if (kp.source != NULL) {
+			key = kp.source(kp.ctx);
+		} else {
+			key = 0;
+		}
+	} while (key != 0 && keybit(key) < 0);
+	return key;
+}
+
+void sim_keys(const char *keys)
+{
+	while (*keys != '\0') {
+		if ((kp.head + 1) % SIM_KEYBUF == kp.tail) {
+			fprintf(stderr, "sim: key queue full\n");
+			return;
+		}
+		kp.buf[kp.head] = *keys++;
+		kp.head = (kp.head + 1) % SIM_KEYBUF;
+	}
+}
+
+void sim_keys_source(sim_keysource_t source, void *ctx)
+{
+	kp.source = source;
+	kp.ctx = ctx;
+}
+
+void sim_keys_timing(uint32_t hold_us, uint32_t gap_us)
+{
+	kp.hold = SIM_US(hold_us);
+	kp.gap = SIM_US(gap_us);
+}
+
+void sim_keys_paced(bool paced)
+{
+	kp.paced = paced;
+}
+
+uint64_t sim_keys_pressed(void)
+{
+	return kp.pressed;
+}
+
+const sim_scan_stats_t *sim_keys_scan_stats(void)
+{
+	return &kp.scans;
+}
+
+void sim_keys_contact(uint64_t when, char key, bool closed)
+{
+	int bit = keybit(key);
+	size_t at;
+
+	if (bit < 0) {
+		return;
+	}
+	if (kp.ntrace == SIM_TRACE) {
+		fprintf(stderr, "sim: contact trace full\n");
+		return;
+	}
+
+	// Kept in time order, the same time stays in the order given
+	for (at = kp.ntrace; at > kp.traced && kp.trace[at - 1].when > when; at--) {
+		kp.trace[at] = kp.trace[at - 1];
+	}
+	kp.trace[at] = (sim_contact_t){when, (uint16_t)(1u << bit), closed};
+	kp.ntrace++;
+	sim_reschedule();
+}
+
+bool sim_keys_pending(void)
+{
+	return kp.down != 0 || kp.next != 0 || kp.head != kp.tail || kp.traced < kp.ntrace;
+}
+
+uint16_t sim_keypad_rows(uint16_t cols)
+{
+	uint16_t rows = 0;
+
+	if (kp.mask == 0) {
+		return 0;
+	}
+
+	// Columns are all high while the firmware waits, a scan drives them apart
+	if (kp.scanned == false && cols != 0x1E) {
+		uint64_t took = sim_now() - kp.pressat;
+
+		kp.scanned = true;
+		kp.scans.scanned++;
+		kp.scans.total += took;
+		if (took > kp.scans.max) {
+			kp.scans.max = took;
+		}
+	}
+	for (int bit = 0; bit < 16; bit++) {
+		if ((kp.mask & (1u << bit)) && (cols & (1u << (1 + bit % 4)))) {
+			rows |= 1u << (8 + bit / 4);
+		}
+	}
+	return rows;
+}
+
+uint64_t sim_keypad_next(void)
+{
+	uint64_t next = SIM_NEVER;
+
+	if (kp.next != 0) {
+		next = kp.pressat;
+	} else if (kp.down != 0) {
+		next = kp.releaseat;
+	}
+	if (kp.traced < kp.ntrace && kp.trace[kp.traced].when < next) {
+		next = kp.trace[kp.traced].when;
+	}
+	return next;
+}
+
+// Schedules a press no sooner than one gap after the last release
+static void schedule(char key, uint64_t now)
+{
+	kp.next = key;
+	kp.pressat = kp.lastrelease + kp.gap;
+	if (kp.pressat < now) {
+		kp.pressat = now;
+	}
+}
+
+bool sim_keypad_update(uint64_t now)
+{
+	bool changed = false;
+
+	while (kp.traced < kp.ntrace && now >= kp.trace[kp.traced].when) {
+		const sim_contact_t *c = &kp.trace[kp.traced++];
+
+		kp.mask = c->closed ? (kp.mask | c->bit) : (kp.mask & ~c->bit);
+		kp.scanned = true; // Not a press from the queue, keep it out of the scan stats
+		changed = true;
+	}
+	if (kp.down != 0 && now >= kp.releaseat) {
+		kp.down = 0;
+		kp.mask = 0;
+		kp.lastrelease = kp.releaseat;
+		changed = true;
+		if (kp.paced) {
+			char key = nextkey();
+			if (key != 0) {
+				schedule(key, kp.lastrelease);
+			}
+		}
+	}
+	if (kp.next != 0 && now >= kp.pressat) {
+		kp.down = kp.next;
+		kp.next = 0;
+		kp.mask = 1u << keybit(kp.down);
+		kp.releaseat = kp.pressat + kp.hold;
+		kp.pressed++;
+		kp.scanned = false;
+		changed = true;
+	}
+	return changed;
+}
+
+uint64_t sim_keypad_wait(uint64_t now, uint64_t settle)
+{
+	if (kp.down == 0 && kp.next == 0) {
+		char key = nextkey();
+		if (key != 0) {
+			schedule(key, now);
+		} else {
+			return kp.lastrelease + settle;
+		}
+	}
+	return sim_keypad_next();
+}
+
+bool sim_keypad_done(uint64_t now, uint64_t settle)
+{
+	return kp.down == 0 && kp.next == 0 && kp.traced == kp.ntrace && now >= kp.lastrelease + settle;
+}
+
+void sim_keypad_reset(void)
+{
+	sim_keysource_t source = kp.source;
+	void *ctx = kp.ctx;
+	uint64_t hold = kp.hold, gap = kp.gap;
+	bool paced = kp.paced;
+
+	memset(&kp, 0, sizeof(kp));
+	kp.source = source;
+	kp.ctx = ctx;
+	kp.hold = hold != 0 ? hold : SIM_MS(50);
+	kp.gap = gap != 0 ? gap : SIM_MS(50);
+	kp.paced = paced;
+}
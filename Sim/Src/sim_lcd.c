@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file           : sim_lcd.c
+  * @brief          : Virtual 16x2 HD44780 LCD behind a 74HC595 shift register.
+  *                   Latched byte layout matches LCD_nibble_write():
+  *                   bit 0 = RS, bit 1 = EN, bits 4-7 = D4-D7. The controller
+  *                   takes a nibble on each falling edge of EN.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+#define SIM_LCD_CELLS 80 // Two lines of 40 DDRAM cells
+#define SIM_LCD_COLS 16
+#define SIM_LCD_SHORT_NS 37000ULL // Most instructions and data writes
+#define SIM_LCD_LONG_NS 1520000ULL // Clear display, return home
+
+static struct {
+	uint8_t sr, out; // Shift register stages, latched outputs
+	bool fourbit, low; // Bus width, waiting for the low nibble
+	uint8_t high;
+	bool cgram; // Data goes to CGRAM (not drawn)
+	char ddram[SIM_LCD_CELLS];
+	int addr; // Cell index 0-79 (line 2 starts at 40)
+	int inc; // +1 or -1 after each access
+	int shift; // Display shift in cells
+	bool on;
+	uint64_t busyuntil;
+	uint64_t version;
+	sim_lcd_stats_t stats;
+} lcd;
+
+// Controller is busy for the given time from now
+static void busy(uint64_t ns)
+{
+	uint64_t units = ns * SIM_UNITS_PER_NS;
+
+	lcd.busyuntil = sim_now() + units;
+	lcd.stats.busy_time += units;
+}
+
+static void changed(void)
+{
+	lcd.version++;
+}
+
+// Moves the address counter one cell, wrapping like the DDRAM does
+static void step(int dir)
+{
+	lcd.addr = (lcd.addr + dir + SIM_LCD_CELLS) % SIM_LCD_CELLS;
+}
+
+static void instruction(uint8_t code)
+{
+	lcd.stats.instructions++;
+	if (code & 0x80) { // Set DDRAM address
+		uint8_t a = code & 0x7F;
+		lcd.addr = (a >= 0x40 ? 40 + ((a - 0x40) % 40) : a % 40);
+		lcd.cgram = false;
+		busy(SIM_LCD_SHORT_NS);
+	} else if (code & 0x40) { // Set CGRAM address
+		lcd.cgram = true;
+		busy(SIM_LCD_SHORT_NS);
+	} else if (code & 0x20) { // Function set
+		if (!lcd.fourbit && (code & 0x10) == 0) {
+			lcd.fourbit = true;
+			lcd.low = false;
+		}
+		busy(SIM_LCD_SHORT_NS);
+	} else if (code & 0x10) { // Cursor or display shift
+		int dir = (code & 0x04) ? 1 : -1;
+		if (code & 0x08) {
+			lcd.shift = (lcd.shift + dir + 40) % 40;
+			changed();
+		} else {
+			step(dir);
+		}
+		busy(SIM_LCD_SHORT_NS);
+	} else if (code & 0x08) { // Display on/off control
+		lcd.on = (code & 0x04) != 0;
+		changed();
+		busy(SIM_LCD_SHORT_NS);
+	} else if (code & 0x04) { // Entry mode set
+		lcd.inc = (code & 0x02) ? 1 : -1;
+		busy(SIM_LCD_SHORT_NS);
+	} else if (code & 0x02) { // Return home
+		lcd.addr = 0;
+		lcd.shift = 0;
+		lcd.cgram = false;
+		changed();
+		busy(SIM_LCD_LONG_NS);
+	} else if (code & 0x01) { // Clear display
+		memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+		lcd.addr = 0;
+		lcd.shift = 0;
+		lcd.inc = 1;
+		lcd.cgram = false;
+		lcd.stats.clears++;
+		changed();
+		busy(SIM_LCD_LONG_NS);
+	}
+}
+
+static void data(uint8_t code)
+{
+	lcd.stats.chars++;
+	if (!lcd.cgram) {
+		lcd.ddram[lcd.addr] = (char)code;
+		step(lcd.inc);
+		changed();
+	}
+	busy(SIM_LCD_SHORT_NS);
+}
+
+// One EN strobe on D4-D7
+static void nibble(bool rs, uint8_t value)
+{
+	lcd.stats.nibbles++;
+	if (sim_now() < lcd.busyuntil) {
+		lcd.stats.busy_violations++;
+	}
+
+	if (!lcd.fourbit) { // 8-bit interface, low data lines read as 0
+		if (rs) {
+			data(value << 4);
+		} else {
+			instruction(value << 4);
+		}
+		return;
+	}
+
+	if (!lcd.low) {
+		lcd.high = value;
+		lcd.low = true;
+		return;
+	}
+	lcd.low = false;
+	if (rs) {
+		data((lcd.high << 4) | value);
+	} else {
+		instruction((lcd.high << 4) | value);
+	}
+}
+
+void sim_lcd_shift(int bit)
+{
+	lcd.sr = (uint8_t)((lcd.sr << 1) | (bit & 1));
+}
+
+void sim_lcd_latch(void)
+{
+	uint8_t prev = lcd.out;
+
+	lcd.out = lcd.sr;
+	lcd.stats.bytes++;
+	sim_activity();
+	if ((prev & 0x02) && !(lcd.out & 0x02)) {
+		nibble(lcd.out & 0x01, lcd.out >> 4);
+	}
+}
+
+void sim_lcd_line(int row, char out[17])
+{
+	for (int col = 0; col < SIM_LCD_COLS; col++) {
+		char c = lcd.ddram[row * 40 + (col + lcd.shift) % 40];
+		out[col] = (lcd.on && c >= 0x20 && c < 0x7F) ? c : ' ';
+	}
+	out[SIM_LCD_COLS] = '\0';
+}
+
+const sim_lcd_stats_t *sim_lcd_stats(void)
+{
+	return &lcd.stats;
+}
+
+void sim_lcd_stats_reset(void)
+{
+	memset(&lcd.stats, 0, sizeof(lcd.stats));
+}
+
+uint64_t sim_lcd_version(void)
+{
+	return lcd.version;
+}
+
+void sim_lcd_print(FILE *out)
+{
+	char line[17];
+
+	fprintf(out, "+----------------+\n");
+	for (int row = 0; row < 2; row++) {
+		sim_lcd_line(row, line);
+		fprintf(out, "|%s|\n", line);
+	}
+	fprintf(out, "+----------------+\n");
+}
+
+void sim_lcd_reset(void)
+{
+	memset(&lcd, 0, sizeof(lcd));
+	memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+	lcd.inc = 1;
+}
@@ -0,0 +1,177 @@
+/**
+  ******************************************************************************
+  * @file           : sim_lptim.c
+  * @brief          : LPTIM1 model, counting the 32768 Hz LSE.
+  *                   Runs in continuous mode through PRESC and ARR, setting
+  *                   CMPM and ARRM as the count reaches CMP and ARR and
+  *                   raising the interrupt for those enabled in IER. It keeps
+  *                   counting in Stop 2. CMPOK and ARROK are set as soon as
+  *                   CMP and ARR are written.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+#define SIM_LSE_HZ 32768U
+
+// CMP and ARR hold 16 bits. The values the firmware sees carry this reserved
+// bit, so a write shows up as the bit going missing, even of the same value.
+#define SIM_WRITE_MARK (1u << 31)
+#define SIM_VALUE 0xFFFFu
+
+// Handler the firmware may not define
+void LPTIM1_IRQHandler(void) __attribute__((weak));
+
+static struct {
+	LPTIM_TypeDef regs;
+	uint32_t cr; // Last value seen, to spot firmware writes
+	uint32_t cmp, arr; // In effect
+	bool running;
+	uint64_t start; // When the count started from 0
+	uint64_t done; // Counts already checked for matches
+	uint64_t next; // Next CMP or ARR match
+} lp;
+
+static uint32_t rate(void)
+{
+	return SIM_LSE_HZ >> ((lp.regs.CFGR & LPTIM_CFGR_PRESC) >> LPTIM_CFGR_PRESC_Pos);
+}
+
+// Counts since start at a point in time, and the time a count is reached
+static uint64_t counts(uint64_t when)
+{
+	return (uint64_t)((unsigned __int128)(when - lp.start) * rate() / SIM_MS(1000));
+}
+
+static uint64_t reached(uint64_t total)
+{
+	return lp.start + (uint64_t)(((unsigned __int128)total * SIM_MS(1000) + rate() - 1) / rate());
+}
+
+// First count after done at which the counter reads match
+static uint64_t after(uint64_t done, uint32_t match)
+{
+	uint64_t turn = (uint64_t)lp.arr + 1;
+	uint64_t total = done / turn * turn + match;
+
+	return total > done ? total : total + turn;
+}
+
+static void schedule(void)
+{
+	uint64_t cmp, arr;
+
+	if (lp.running == false) {
+		lp.next = SIM_NEVER;
+		return;
+	}
+	cmp = after(lp.done, lp.cmp);
+	arr = after(lp.done, lp.arr);
+	lp.next = reached(cmp < arr ? cmp : arr);
+}
+
+// Sets the flags of every match up to now, then raises the interrupt
+static void matches(uint64_t now)
+{
+	uint64_t total = counts(now);
+	uint32_t flags = 0;
+
+	if (after(lp.done, lp.cmp) <= total) {
+		flags |= LPTIM_ISR_CMPM;
+	}
+	if (after(lp.done, lp.arr) <= total) {
+		flags |= LPTIM_ISR_ARRM;
+	}
+	lp.done = total;
+	lp.regs.ISR |= flags;
+	if (flags & lp.regs.IER & (LPTIM_IER_CMPMIE | LPTIM_IER_ARRMIE)) {
+		sim_irq_raise(LPTIM1_IRQn, LPTIM1_IRQHandler);
+	}
+}
+
+// Brings the model up to date with firmware register writes
+static void lptimsync(void)
+{
+	bool changed = false;
+
+	// Matches so far count against the values they were made with
+	if (lp.running) {
+		matches(sim_now());
+	}
+
+	if (lp.regs.ICR != 0) { // Write-1-to-clear
+		lp.regs.ISR &= ~lp.regs.ICR;
+		lp.regs.ICR = 0;
+	}
+	if ((lp.regs.CMP & SIM_WRITE_MARK) == 0) {
+		lp.cmp = lp.regs.CMP & SIM_VALUE;
+		lp.regs.ISR |= LPTIM_ISR_CMPOK;
+		changed = true;
+	}
+	if ((lp.regs.ARR & SIM_WRITE_MARK) == 0) {
+		lp.arr = lp.regs.ARR & SIM_VALUE;
+		lp.regs.ISR |= LPTIM_ISR_ARROK;
+		changed = true;
+	}
+	lp.regs.CMP = lp.cmp | SIM_WRITE_MARK;
+	lp.regs.ARR = lp.arr | SIM_WRITE_MARK;
+
+	if ((lp.regs.CR & LPTIM_CR_ENABLE) == 0) {
+		lp.running = false;
+		lp.regs.CNT = 0;
+		changed |= lp.cr != lp.regs.CR;
+	} else if ((lp.regs.CR & LPTIM_CR_CNTSTRT) && lp.running == false) {
+		lp.running = true;
+		lp.start = sim_now();
+		lp.done = 0;
+		changed = true;
+	}
+	lp.regs.CR &= ~(LPTIM_CR_CNTSTRT | LPTIM_CR_SNGSTRT);
+	if (changed) {
+		schedule();
+		sim_reschedule();
+	}
+
+	// Publish the live count
+	if (lp.running) {
+		lp.regs.CNT = (uint32_t)(lp.done % ((uint64_t)lp.arr + 1));
+	}
+	lp.cr = lp.regs.CR;
+}
+
+LPTIM_TypeDef *sim_lptim(uint32_t timer)
+{
+	(void)timer;
+	lptimsync();
+	sim_poll(2);
+	sim_reschedule(); // A write after this access is picked up before the next event
+	return &lp.regs;
+}
+
+void sim_lptim_sync(void)
+{
+	lptimsync();
+}
+
+uint64_t sim_lptim_next(void)
+{
+	return lp.next;
+}
+
+void sim_lptim_update(uint64_t now)
+{
+	if (lp.next <= now) {
+		matches(now);
+		schedule();
+	}
+}
+
+void sim_lptim_reset(void)
+{
+	memset(&lp, 0, sizeof(lp));
+	lp.arr = 1;
+	lp.regs.ARR = lp.arr | SIM_WRITE_MARK;
+	lp.regs.CMP = SIM_WRITE_MARK;
+	lp.next = SIM_NEVER;
+}
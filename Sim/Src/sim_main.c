@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file           : sim_main.c
+  * @brief          : Command line runner for the host build of the lock.
+  *                   Feeds keys to the firmware and shows the LCD, or pushes
+  *                   a stream of generated presses through it as a benchmark.
+  *                   The console on USART2 can be opened on a pty, for a
+  *                   terminal program to talk to.
+  ******************************************************************************
+  */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "lcd.h"
+#include "event.h"
+#include "journal.h"
+
+int lock_main(void); // main() in Core/Src/main.c
+
+typedef struct {
+	const char *pattern;
+	size_t pos;
+	uint64_t left;
+} benchkeys_t;
+
+// Repeats the pattern until the requested number of keys is used
+static char benchkey(void *ctx)
+{
+	benchkeys_t *b = ctx;
+	char key;
+
+	if (b->left == 0) {
+		return 0;
+	}
+	b->left--;
+	key = b->pattern[b->pos++];
+	if (b->pattern[b->pos] == '\0') {
+		b->pos = 0;
+	}
+	return key;
+}
+
+// Prints the display whenever the firmware waits after changing it
+static void trace(void *ctx)
+{
+	uint64_t *seen = ctx;
+
+	if (sim_lcd_version() != *seen) {
+		*seen = sim_lcd_version();
+		printf("t=%llu.%03llu s\n", (unsigned long long)(sim_time_us() / 1000000),
+			(unsigned long long)(sim_time_us() / 1000 % 1000));
+		sim_lcd_print(stdout);
+	}
+}
+
+static double walltime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Ctrl-C ends the run at the next wait, so the flash image is still saved
+static void interrupted(int sig)
+{
+	(void)sig;
+	sim_interrupt();
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-t] [-p] [-u] [-f image] [-H hold_ms] [-G gap_ms] [-s settle_ms] [-b count [-k pattern]] [keys...]\n"
+		"  keys      key presses, e.g. 1234A (0-9 A-D * #)\n"
+		"  -t        print the LCD each time it changes\n"
+		"  -p        press keys on a fixed schedule even if the firmware is busy\n"
+		"  -u        open the console on a pty and keep running for it after the keys, until Ctrl-C\n"
+		"  -f        flash image to boot from (if it exists) and save back, so codes persist\n"
+		"  -H, -G    key hold time and gap between keys in ms (default 50/50)\n"
+		"  -s        virtual time to keep running after the last key (default 15000)\n"
+		"  -b        benchmark: push count generated key presses through the lock\n"
+		"  -k        benchmark key pattern, repeated (default 1234A: enroll then unlock)\n",
+		name);
+}
+
+int main(int argc, char **argv)
+{
+	benchkeys_t bench = {"1234A", 0, 0};
+	uint64_t seen = 0;
+	bool tracing = false, paced = false, console = false;
+	const char *image = NULL;
+	uint32_t hold = 50, gap = 50, settle = 15000;
+	struct sigaction sa = {0};
+	char pty[64];
+	double start, wall;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "tpuf:H:G:s:b:k:h")) != -1) {
+		switch (opt) {
+			case 't':
+				tracing = true;
+				break;
+			case 'p':
+				paced = true;
+				break;
+			case 'u':
+				console = true;
+				break;
+			case 'f':
+				image = optarg;
+				break;
+			case 'H':
+				hold = (uint32_t)atoi(optarg);
+				break;
+			case 'G':
+				gap = (uint32_t)atoi(optarg);
+				break;
+			case 's':
+				settle = (uint32_t)atoi(optarg);
+				break;
+			case 'b':
+				bench.left = strtoull(optarg, NULL, 10);
+				break;
+			case 'k':
+				bench.pattern = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? 0 : 2;
+		}
+	}
+
+	sim_settle((uint64_t)settle * 1000);
+	sim_keys_timing(hold * 1000, gap * 1000);
+	sim_keys_paced(paced);
+	sim_reset();
+	if (image != NULL) {
+		sim_flash_load(image);
+	}
+	for (int i = optind; i < argc; i++) {
+		sim_keys(argv[i]);
+	}
+	if (bench.left > 0) {
+		sim_keys_source(benchkey, &bench);
+	}
+	if (tracing) {
+		sim_idle_hook(trace, &seen);
+	}
+	if (console) {
+		if (sim_uart_pty(pty, sizeof(pty), true) < 0) {
+			fprintf(stderr, "%s: cannot open a pty\n", argv[0]);
+			return 1;
+		}
+		sa.sa_handler = interrupted; // No SA_RESTART, so a wait for the host returns
+		sigaction(SIGINT, &sa, NULL);
+		printf("console on %s\n", pty);
+		fflush(stdout);
+	}
+
+	start = walltime();
+	sim_run(lock_main);
+	wall = walltime() - start;
+	if (image != NULL && sim_flash_save(image) == false) {
+		fprintf(stderr, "%s: cannot write %s\n", argv[0], image);
+		return 1;
+	}
+
+	if (!tracing) {
+		sim_lcd_print(stdout);
+	}
+	printf("keys %llu, virtual %.3f s, wall %.3f s",
+		(unsigned long long)sim_keys_pressed(), sim_time_us() / 1e6, wall);
+	if (wall > 0) {
+		printf(" (%.0f keys/s, %.0fx real time)", sim_keys_pressed() / wall, sim_time_us() / 1e6 / wall);
+	}
+	printf("\ncpu asleep %.1f%% of virtual time, in Stop 2 %.1f%%\n",
+		sim_time_us() > 0 ? 100.0 * sim_asleep() / sim_now() : 0.0,
+		sim_time_us() > 0 ? 100.0 * sim_stopped() / sim_now() : 0.0);
+	printf("lcd bytes %llu, instructions %llu, chars %llu, clears %llu, busy violations %llu\n",
+		(unsigned long long)sim_lcd_stats()->bytes,
+		(unsigned long long)sim_lcd_stats()->instructions,
+		(unsigned long long)sim_lcd_stats()->chars,
+		(unsigned long long)sim_lcd_stats()->clears,
+		(unsigned long long)sim_lcd_stats()->busy_violations);
+	printf("lcd flushes %lu, %.1f bytes per flush, largest %u, deepest queue %u, stalls %lu\n",
+		(unsigned long)lcd_stats()->flushes,
+		lcd_stats()->flushes > 0 ? (double)lcd_stats()->bytes / lcd_stats()->flushes : 0.0,
+		(unsigned)lcd_stats()->max, (unsigned)lcd_stats()->depth, (unsigned long)lcd_stats()->stalls);
+	printf("lcd shift register bytes built %lu, sent from prebuilt screens %lu\n",
+		(unsigned long)lcd_stats()->composed, (unsigned long)lcd_stats()->streamed);
+	printf("events %lu, deepest queue %u, dropped %lu\n",
+		(unsigned long)event_stats()->handled, (unsigned)event_stats()->depth,
+		(unsigned long)event_stats()->dropped);
+	printf("journal records %lu, compactions %lu, replayed at boot %lu, torn %lu, flash errors %lu, deepest queue %u\n",
+		(unsigned long)journal_stats()->records, (unsigned long)journal_stats()->compactions,
+		(unsigned long)journal_stats()->mounted, (unsigned long)journal_stats()->torn,
+		(unsigned long)journal_stats()->errors, (unsigned)journal_stats()->depth);
+	return 0;
+}
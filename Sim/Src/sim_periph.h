@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file           : sim_periph.h
+  * @brief          : Shared state between the simulator models.
+  ******************************************************************************
+  */
+
+#ifndef __SIM_PERIPH_H
+#define __SIM_PERIPH_H
+
+#include "main.h"
+#include "sim.h"
+#include "stm32l4xx_it.h"
+
+#define SIM_NEVER UINT64_MAX
+
+typedef void (*sim_handler_t)(void);
+
+// Core
+extern bool sim_in_isr; // Set while a simulated interrupt handler runs
+void sim_activity(void); // Marks visible progress so spin detection resets
+void sim_poll(uint32_t cycles); // Main context touched hardware, charge cycles
+void sim_irq_pend(sim_handler_t handler); // Raises an interrupt
+void sim_reschedule(void); // A model changed when it next needs to run
+uint64_t sim_units(uint64_t cycles); // Core clock cycles to virtual time
+void sim_hal_reset(void);
+bool sim_nvic_enabled(IRQn_Type IRQn); // Set by HAL_NVIC_EnableIRQ
+void sim_stop2(void); // Halts the core and its clocks until an interrupt is pending
+void sim_irq_raise(IRQn_Type IRQn, sim_handler_t handler); // Pends the handler if its IRQ is enabled
+
+// GPIO
+void sim_gpio_reset(void);
+void sim_gpio_sync(void); // Applies pending register writes and refreshes inputs
+void sim_gpio_af(uint32_t port, uint32_t pin, bool level); // A peripheral drives an alternate function pin
+void sim_gpio_bus(uintptr_t addr); // DMA reached addr; if it is a port register, writes land and inputs refresh
+
+// EXTI lines 0-15 from GPIO edges
+void sim_exti_reset(void);
+void sim_exti_sync(void); // Applies pending register writes
+void sim_exti_edge(uint32_t lines); // Trigger edges seen on these lines
+void sim_exti_pin(uint32_t lines, bool rising); // An edge on alternate function pins, triggering as RTSR1/FTSR1 say
+
+// DMA channels driven by HAL_DMA_*
+void sim_dma_reset(void);
+void sim_dma_request(DMA_Channel_TypeDef *instance, uint32_t request); // A peripheral asks for one item
+uint32_t sim_dma_remaining(DMA_Channel_TypeDef *instance); // Items left, 0 when idle
+
+// SPI1 transmitter on PA5 (SCK) and PB5 (MOSI)
+void sim_spi_reset(void);
+bool sim_spi_dr_write(uintptr_t addr, uint32_t value); // false if addr is not the data register
+
+// Timers TIM1, TIM2, TIM3, TIM6, TIM7 and TIM8 (update interrupt and DMA, one-pulse mode, PWM and forced outputs)
+void sim_tim_reset(void);
+void sim_tim_sync(void); // Applies pending register writes
+uint64_t sim_tim_next(void); // Next update event, SIM_NEVER if none
+void sim_tim_update(uint64_t now); // Runs due update events
+
+// LPTIM1 on the LSE (compare and autoreload interrupts, continuous mode)
+void sim_lptim_reset(void);
+void sim_lptim_sync(void); // Applies pending register writes
+uint64_t sim_lptim_next(void); // Next CMP or ARR match, SIM_NEVER if stopped
+void sim_lptim_update(uint64_t now); // Sets due match flags and interrupts
+
+// Internal flash behind HAL_FLASH_Program and HAL_FLASHEx_Erase, kept across resets
+void sim_flash_reset(void);
+
+// Keypad matrix (rows PB8-PB11, columns PB1-PB4)
+void sim_keypad_reset(void);
+uint16_t sim_keypad_rows(uint16_t cols); // Row bits driven for the given column bits
+uint64_t sim_keypad_next(void); // Next press or release, SIM_NEVER if none
+bool sim_keypad_update(uint64_t now); // Applies due presses/releases, true if changed
+uint64_t sim_keypad_wait(uint64_t now, uint64_t settle); // Firmware idles, returns when input changes next
+bool sim_keypad_done(uint64_t now, uint64_t settle); // Keys exhausted and settled
+
+// USART2 (TX PA2, RX PA3) behind HAL_UART_*, bridged to the host
+void sim_uart_reset(void);
+void sim_uart_poll(void); // Takes what the attached descriptor has, without blocking
+bool sim_uart_wait(void); // Attached to wait for input
+uint64_t sim_uart_pace(uint64_t now, uint64_t next); // Holds next back to the wall clock while waiting for input
+
+// LCD behind the shift register (data PB5, clock PA5, latch PA10)
+void sim_lcd_reset(void);
+void sim_lcd_shift(int bit); // Rising clock edge
+void sim_lcd_latch(void); // Rising latch edge
+
+#endif /* __SIM_PERIPH_H */
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file           : sim_spi.c
+  * @brief          : SPI1 master transmit model.
+  *                   A frame written to DR is clocked straight out on SCK
+  *                   (PA5) and MOSI (PB5) through the alternate function
+  *                   pins, so whatever listens on those pins sees every bit.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+static SPI_TypeDef spi1;
+
+SPI_TypeDef *sim_spi(uint32_t spi)
+{
+	(void)spi;
+	sim_poll(2);
+	return &spi1;
+}
+
+// Shifts one frame out, mode and bit order from CR1, frame size from CR2
+static void transmit(uint32_t value)
+{
+	int bits = (int)((spi1.CR2 & SPI_CR2_DS) >> SPI_CR2_DS_Pos) + 1;
+	bool idle = (spi1.CR1 & SPI_CR1_CPOL) != 0;
+	bool lsbfirst = (spi1.CR1 & SPI_CR1_LSBFIRST) != 0;
+
+	for (int i = 0; i < bits; i++) {
+		int bit = lsbfirst ? i : bits - 1 - i;
+		sim_gpio_af(1, 5, (value >> bit) & 1); // MOSI
+		sim_gpio_af(0, 5, !idle); // Leading edge
+		sim_gpio_af(0, 5, idle); // Trailing edge
+	}
+}
+
+bool sim_spi_dr_write(uintptr_t addr, uint32_t value)
+{
+	if (addr != (uintptr_t)&spi1.DR) {
+		return false;
+	}
+	if ((spi1.CR1 & (SPI_CR1_SPE | SPI_CR1_MSTR)) == (SPI_CR1_SPE | SPI_CR1_MSTR)) {
+		transmit(value);
+	}
+	return true;
+}
+
+void sim_spi_reset(void)
+{
+	memset(&spi1, 0, sizeof(spi1));
+	spi1.CR2 = 0x0700; // 8-bit frames after reset
+	spi1.SR = SPI_SR_TXE;
+}
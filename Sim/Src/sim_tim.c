@@ -0,0 +1,321 @@
+/**
+  ******************************************************************************
+  * @file           : sim_tim.c
+  * @brief          : Timer model for TIM1, TIM2, TIM3, TIM6, TIM7 and TIM8.
+  *                   Counts up at the APB timer clock (the core clock with the
+  *                   firmware's divide-by-1 setting) through PSC and ARR. The
+  *                   update event raises the interrupt and the DMA request and
+  *                   stops the counter in one-pulse mode; on TIM1 and TIM8 it
+  *                   only comes once the repetition counter loaded from RCR
+  *                   runs out. A channel's compare DMA request is only
+  *                   modelled with CCR at 0, where it comes at every wrap,
+  *                   repetitions included. PWM mode 1 and 2 and the forced modes drive
+  *                   their pins, on TIM1 and TIM8 only once MOE is set.
+  *                   PSC and ARR take effect at once rather than at the next
+  *                   update.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "sim_periph.h"
+
+#define SIM_TIMERS 6
+
+typedef struct {
+	uint32_t number;
+	TIM_TypeDef regs;
+	uint32_t cr1, cnt; // Last values seen, to spot firmware writes
+	uint32_t ccmr1, ccmr2, ccer, bdtr, drivencnt; // Setup and count the pins were last driven for
+	uint64_t drivennext;
+	uint32_t rep; // Repetition counter, periods left before the next update event
+	uint64_t start, next; // When CNT was 0, next update event
+	uint64_t nextcc; // Next compare match that moves an output
+	IRQn_Type irqn;
+	sim_handler_t handler;
+	DMA_Channel_TypeDef *dmach; // Channel serving the update DMA request
+	DMA_Channel_TypeDef *ccdmach[4]; // Channels serving the compare DMA requests, NULL if not mapped
+	uint32_t dmareq; // Request number of all of them
+	bool advanced; // Outputs gated by BDTR.MOE, repetition counter
+	int8_t port[4], pin[4]; // Channel output pins, -1 if not bonded out
+} sim_timer_t;
+
+// Handlers the firmware may not define
+void TIM1_UP_TIM16_IRQHandler(void) __attribute__((weak));
+void TIM6_DAC_IRQHandler(void) __attribute__((weak));
+void TIM7_IRQHandler(void) __attribute__((weak));
+void TIM2_IRQHandler(void) __attribute__((weak));
+void TIM3_IRQHandler(void) __attribute__((weak));
+void TIM8_UP_IRQHandler(void) __attribute__((weak));
+
+static sim_timer_t timers[SIM_TIMERS];
+
+// Virtual time per counter tick
+static uint64_t tickunits(const sim_timer_t *t)
+{
+	return sim_units(t->regs.PSC + 1);
+}
+
+// Capture/compare register and output mode of a channel
+static uint32_t ccr(const sim_timer_t *t, int ch)
+{
+	const volatile uint32_t *regs[4] = {&t->regs.CCR1, &t->regs.CCR2, &t->regs.CCR3, &t->regs.CCR4};
+
+	return *regs[ch];
+}
+
+static uint32_t ocmode(const sim_timer_t *t, int ch)
+{
+	uint32_t ccmr = ch < 2 ? t->regs.CCMR1 : t->regs.CCMR2;
+
+	return (ccmr >> (4 + 8 * (ch & 1))) & 0x7;
+}
+
+// Channel outputs currently enabled in a PWM or forced mode
+static bool driven(const sim_timer_t *t, int ch)
+{
+	uint32_t mode = ocmode(t, ch);
+
+	if (t->port[ch] < 0 || (t->regs.CCER & (TIM_CCER_CC1E << (4 * ch))) == 0) {
+		return false;
+	}
+	if (t->advanced && (t->regs.BDTR & TIM_BDTR_MOE) == 0) {
+		return false;
+	}
+	return mode >= 4;
+}
+
+// Drives the output pins for the count reached now, then finds the next match
+static void outputs(sim_timer_t *t, uint32_t cnt)
+{
+	t->nextcc = SIM_NEVER;
+	for (int ch = 0; ch < 4; ch++) {
+		uint32_t match, mode;
+		bool high;
+
+		if (!driven(t, ch)) {
+			continue;
+		}
+		match = ccr(t, ch);
+		mode = ocmode(t, ch);
+		if (mode < 6) { // Forced, 5 = active
+			sim_gpio_af((uint32_t)t->port[ch], (uint32_t)t->pin[ch], mode == 5);
+			continue;
+		}
+		high = (cnt < match) == (mode == 6);
+		sim_gpio_af((uint32_t)t->port[ch], (uint32_t)t->pin[ch], high);
+		if (t->next != SIM_NEVER && match > cnt && match <= t->regs.ARR) {
+			uint64_t when = t->start + match * tickunits(t);
+			if (when < t->nextcc) {
+				t->nextcc = when;
+			}
+		}
+	}
+}
+
+// Brings one timer up to date with firmware register writes
+static void timsync(sim_timer_t *t)
+{
+	uint64_t tick = tickunits(t);
+	uint64_t next = t->next;
+
+	if (t->regs.EGR & TIM_EGR_UG) { // Software update restarts the count
+		t->regs.EGR = 0;
+		t->regs.CNT = 0;
+		t->rep = t->regs.RCR & 0xFFFF;
+		t->regs.SR |= TIM_SR_UIF;
+	}
+	if ((t->regs.CR1 & TIM_CR1_CEN) == 0) {
+		next = SIM_NEVER;
+	} else if ((t->cr1 & TIM_CR1_CEN) == 0 || t->regs.CNT != t->cnt) { // Started or CNT written
+		t->start = sim_now() - t->regs.CNT * tick;
+		next = t->start + ((uint64_t)t->regs.ARR + 1) * tick;
+	}
+	if (next != t->next) {
+		t->next = next;
+		sim_reschedule();
+	}
+
+	// Publish the live count
+	if (t->next != SIM_NEVER) {
+		t->regs.CNT = (uint32_t)((sim_now() - t->start) / tick);
+	}
+	t->cr1 = t->regs.CR1;
+	t->cnt = t->regs.CNT;
+}
+
+static sim_timer_t *lookup(uint32_t number)
+{
+	for (int i = 0; i < SIM_TIMERS; i++) {
+		if (timers[i].number == number) {
+			return &timers[i];
+		}
+	}
+	fprintf(stderr, "sim: TIM%u is not modelled\n", (unsigned)number);
+	return &timers[0];
+}
+
+TIM_TypeDef *sim_tim(uint32_t timer)
+{
+	sim_timer_t *t = lookup(timer);
+
+	timsync(t);
+	sim_poll(2);
+	sim_reschedule(); // A write after this access is picked up before the next event
+	return &t->regs;
+}
+
+void sim_tim_sync(void)
+{
+	for (int i = 0; i < SIM_TIMERS; i++) {
+		sim_timer_t *t = &timers[i];
+
+		// Pins follow starts, stops, count and output setup writes, which an
+		// access through sim_tim() may already have taken in
+		timsync(t);
+		if (t->next != t->drivennext || (t->next == SIM_NEVER && t->regs.CNT != t->drivencnt) ||
+			t->ccmr1 != t->regs.CCMR1 || t->ccmr2 != t->regs.CCMR2 ||
+			t->ccer != t->regs.CCER || t->bdtr != t->regs.BDTR) {
+			t->drivennext = t->next;
+			t->drivencnt = t->regs.CNT;
+			t->ccmr1 = t->regs.CCMR1;
+			t->ccmr2 = t->regs.CCMR2;
+			t->ccer = t->regs.CCER;
+			t->bdtr = t->regs.BDTR;
+			outputs(t, t->regs.CNT);
+		}
+	}
+}
+
+uint64_t sim_tim_next(void)
+{
+	uint64_t next = SIM_NEVER;
+
+	for (int i = 0; i < SIM_TIMERS; i++) {
+		if (timers[i].next < next) {
+			next = timers[i].next;
+		}
+		if (timers[i].nextcc < next) {
+			next = timers[i].nextcc;
+		}
+	}
+	return next;
+}
+
+// Compare DMA requests of channels matching at 0, which come at every wrap
+static void wrapdma(sim_timer_t *t)
+{
+	for (int ch = 0; ch < 4; ch++) {
+		if (t->ccdmach[ch] != NULL && (t->regs.DIER & (TIM_DIER_CC1DE << ch)) && ccr(t, ch) == 0) {
+			sim_dma_request(t->ccdmach[ch], t->dmareq);
+		}
+	}
+}
+
+// Counter wrapped or reached the end of its pulse
+static void update(sim_timer_t *t)
+{
+	wrapdma(t);
+	if (t->advanced && t->rep > 0) { // Overflow without an update event
+		t->rep--;
+		t->start = t->next;
+		t->next += ((uint64_t)t->regs.ARR + 1) * tickunits(t);
+		t->regs.CNT = 0;
+		t->cnt = 0;
+		t->drivennext = t->next;
+		outputs(t, 0);
+		return;
+	}
+	t->rep = t->regs.RCR & 0xFFFF;
+	t->regs.SR |= TIM_SR_UIF;
+	if (t->regs.CR1 & TIM_CR1_OPM) {
+		t->regs.CR1 &= ~TIM_CR1_CEN;
+		t->next = SIM_NEVER;
+	} else {
+		t->start = t->next;
+		t->next += ((uint64_t)t->regs.ARR + 1) * tickunits(t);
+	}
+	t->regs.CNT = 0;
+	t->cr1 = t->regs.CR1;
+	t->cnt = 0;
+	t->drivennext = t->next;
+	t->drivencnt = 0;
+	outputs(t, 0);
+
+	if ((t->regs.DIER & TIM_DIER_UDE) && t->dmach != NULL) {
+		sim_dma_request(t->dmach, t->dmareq);
+	}
+	if (t->regs.DIER & TIM_DIER_UIE) {
+		sim_irq_raise(t->irqn, t->handler);
+	}
+}
+
+void sim_tim_update(uint64_t now)
+{
+	for (int i = 0; i < SIM_TIMERS; i++) {
+		sim_timer_t *t = &timers[i];
+
+		if (t->next <= now) {
+			update(t);
+		} else if (t->nextcc <= now) {
+			outputs(t, (uint32_t)((now - t->start) / tickunits(t)));
+		}
+	}
+}
+
+void sim_tim_reset(void)
+{
+	memset(timers, 0, sizeof(timers));
+	for (int i = 0; i < SIM_TIMERS; i++) {
+		timers[i].regs.ARR = 0xFFFF;
+		timers[i].next = SIM_NEVER;
+		timers[i].nextcc = SIM_NEVER;
+		timers[i].drivennext = SIM_NEVER;
+		memset(timers[i].port, -1, sizeof(timers[i].port));
+	}
+
+	timers[0].number = 1;
+	timers[0].irqn = TIM1_UP_TIM16_IRQn;
+	timers[0].handler = TIM1_UP_TIM16_IRQHandler;
+	timers[0].dmach = DMA1_Channel6; // TIM1_UP, request 7
+	timers[0].ccdmach[0] = DMA1_Channel2; // TIM1_CH1, request 7
+	timers[0].dmareq = DMA_REQUEST_7;
+	timers[0].advanced = true;
+	timers[0].port[2] = 0; // CH3 on PA10
+	timers[0].pin[2] = 10;
+
+	timers[1].number = 6;
+	timers[1].irqn = TIM6_DAC_IRQn;
+	timers[1].handler = TIM6_DAC_IRQHandler;
+	timers[1].dmach = DMA1_Channel3; // TIM6_UP, request 6
+	timers[1].dmareq = DMA_REQUEST_6;
+
+	timers[2].number = 7;
+	timers[2].irqn = TIM7_IRQn;
+	timers[2].handler = TIM7_IRQHandler;
+	timers[2].dmach = DMA1_Channel4; // TIM7_UP, request 5
+	timers[2].dmareq = DMA_REQUEST_5;
+
+	timers[3].number = 2;
+	timers[3].irqn = TIM2_IRQn;
+	timers[3].handler = TIM2_IRQHandler;
+	timers[3].regs.ARR = 0xFFFFFFFF; // 32-bit counter
+	timers[3].port[0] = 0; // CH1 on PA0
+	timers[3].pin[0] = 0;
+	timers[3].port[1] = 0; // CH2 on PA1
+	timers[3].pin[1] = 1;
+
+	timers[4].number = 3;
+	timers[4].irqn = TIM3_IRQn;
+	timers[4].handler = TIM3_IRQHandler;
+	timers[4].port[1] = 2; // CH2 on PC7
+	timers[4].pin[1] = 7;
+	timers[4].port[2] = 2; // CH3 on PC8
+	timers[4].pin[2] = 8;
+
+	timers[5].number = 8;
+	timers[5].irqn = TIM8_UP_IRQn;
+	timers[5].handler = TIM8_UP_IRQHandler;
+	timers[5].advanced = true;
+	timers[5].port[3] = 2; // CH4 on PC9
+	timers[5].pin[3] = 9;
+}
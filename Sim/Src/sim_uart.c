@@ -0,0 +1,416 @@
+/**
+  ******************************************************************************
+  * @file           : sim_uart.c
+  * @brief          : USART2 model behind the HAL_UART_* calls the console
+  *                   uses: 8N1 frames at the firmware's baud rate, receive
+  *                   to idle over a circular DMA channel and transmit over
+  *                   another. Each received byte is one DMA request at the
+  *                   end of its frame, and the idle line event follows one
+  *                   frame of silence. Transmit DMA takes a byte per frame
+  *                   and the transfer completes once the last one is out.
+  *                   The clocks stop in Stop 2, so a byte whose start bit
+  *                   comes then is lost; its falling edge goes to EXTI line
+  *                   3, as the RX pin would.
+  *                   Bytes come from sim_uart_send() or a file descriptor,
+  *                   such as the master side of a pty, and output goes to
+  *                   that descriptor or a buffer sim_uart_take() empties.
+  *                   Attached to wait for input, the run goes at wall-clock
+  *                   speed and carries on after the keys, so the console's
+  *                   timing is what someone typing at it would see.
+  ******************************************************************************
+  */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim_periph.h"
+#include <termios.h> // After the device header, its output flags are named CR1, CR2 and CR3 too
+
+#define SIM_UART_QUEUE 65536 // Bytes held each way, power of two
+#define SIM_UART_RETRY_US 50000 // Pause before polling a pty nobody has opened again
+#define SIM_UART_SLIP_US 100000 // Falling further behind the wall clock starts pacing over
+
+// Handler the firmware may not define
+void USART2_IRQHandler(void) __attribute__((weak));
+
+typedef struct {
+	uint8_t data[SIM_UART_QUEUE];
+	uint32_t head, count;
+} sim_fifo_t;
+
+static struct {
+	USART_TypeDef regs;
+	UART_HandleTypeDef *huart;
+	uint64_t frame; // One start, 8 data and 1 stop bit, virtual time
+	sim_fifo_t in, out; // To the RX pin, from the TX pin
+	bool rxbusy; // A frame is on the RX line
+	bool rxdrop; // Its start bit came in Stop 2
+	bool rxunread; // A byte was received since the last idle event
+	uint64_t rxend; // End of the last frame on the RX line
+	bool idle, tc; // Flags for the interrupt handler
+	uint64_t lost;
+} uart;
+
+static int hostfd = -1; // Kept over resets, like the runner's settings
+static bool hostwait = false;
+static bool paced = false;
+static uint64_t base; // Wall clock at virtual time zero, us
+
+static void fifo_put(sim_fifo_t *f, uint8_t byte)
+{
+	if (f->count == SIM_UART_QUEUE) { // Oldest goes
+		f->head = (f->head + 1) & (SIM_UART_QUEUE - 1);
+		f->count--;
+	}
+	f->data[(f->head + f->count) & (SIM_UART_QUEUE - 1)] = byte;
+	f->count++;
+}
+
+static uint8_t fifo_get(sim_fifo_t *f)
+{
+	uint8_t byte = f->data[f->head];
+
+	f->head = (f->head + 1) & (SIM_UART_QUEUE - 1);
+	f->count--;
+	return byte;
+}
+
+USART_TypeDef *sim_usart(uint32_t usart)
+{
+	(void)usart;
+	return &uart.regs;
+}
+
+static void rxstart(void *arg);
+
+// Starts the next queued frame once the line is free
+static void rxkick(void)
+{
+	if (uart.rxbusy || uart.in.count == 0 || uart.frame == 0) {
+		return;
+	}
+	uart.rxbusy = true;
+	sim_event_at(uart.rxend > sim_now() ? uart.rxend : sim_now(), rxstart, NULL);
+}
+
+// One frame of silence after the last byte
+static void rxidle(void *arg)
+{
+	(void)arg;
+	if (uart.rxbusy || !uart.rxunread || sim_now() < uart.rxend + uart.frame) {
+		return;
+	}
+	uart.rxunread = false;
+	uart.idle = true;
+	sim_irq_raise(USART2_IRQn, USART2_IRQHandler);
+}
+
+// Stop bit of a frame, the byte goes to the DMA unless it was lost
+static void rxstop(void *arg)
+{
+	uint8_t byte = fifo_get(&uart.in);
+
+	(void)arg;
+	uart.rxbusy = false;
+	uart.rxend = sim_now();
+	if (!uart.rxdrop && uart.huart != NULL && uart.huart->RxState == HAL_UART_STATE_BUSY_RX) {
+		uart.regs.RDR = byte;
+		sim_dma_request(uart.huart->hdmarx->Instance, uart.huart->hdmarx->Init.Request);
+		uart.rxunread = true;
+	}
+	rxkick();
+	if (!uart.rxbusy) {
+		sim_event_at(uart.rxend + uart.frame, rxidle, NULL);
+	}
+}
+
+// Start bit of a frame, its falling edge reaches EXTI line 3
+static void rxstart(void *arg)
+{
+	(void)arg;
+	uart.rxdrop = sim_core_stopped();
+	if (uart.rxdrop) {
+		uart.lost++;
+	}
+	sim_exti_pin(1u << 3, false);
+	sim_event_at(sim_now() + uart.frame, rxstop, NULL);
+}
+
+// Last byte out
+static void txdone(void *arg)
+{
+	(void)arg;
+	sim_irq_raise(USART2_IRQn, USART2_IRQHandler);
+}
+
+// Transmit DMA request, one per frame while the channel has bytes left
+static void txnext(void *arg)
+{
+	DMA_HandleTypeDef *hdma;
+
+	(void)arg;
+	if (uart.huart == NULL) {
+		return;
+	}
+	hdma = uart.huart->hdmatx;
+	if (sim_dma_remaining(hdma->Instance) > 0) {
+		uint8_t byte;
+
+		sim_dma_request(hdma->Instance, hdma->Init.Request);
+		byte = (uint8_t)uart.regs.TDR;
+
+		if (hostfd < 0 || write(hostfd, &byte, 1) != 1) {
+			fifo_put(&uart.out, byte);
+		}
+	}
+	if (sim_dma_remaining(hdma->Instance) > 0) {
+		sim_event_at(sim_now() + uart.frame, txnext, NULL);
+	} else {
+		uart.tc = true; // Raised as the last byte's stop bit goes out
+		sim_event_at(sim_now() + uart.frame, txdone, NULL);
+	}
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+	if (huart == NULL || huart->Init.BaudRate == 0) {
+		return HAL_ERROR;
+	}
+	HAL_UART_MspInit(huart);
+	uart.huart = huart;
+	uart.frame = (SIM_US(1) * 10 * 1000000ULL + huart->Init.BaudRate / 2) / huart->Init.BaudRate;
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	sim_poll(40);
+	rxkick();
+	return HAL_OK;
+}
+
+// Half and end of the buffer, reported as receive events
+static void rxhalf(DMA_HandleTypeDef *hdma)
+{
+	UART_HandleTypeDef *huart = hdma->Parent;
+
+	HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize / 2U);
+}
+
+static void rxfull(DMA_HandleTypeDef *hdma)
+{
+	UART_HandleTypeDef *huart = hdma->Parent;
+
+	if (hdma->Init.Mode != DMA_CIRCULAR) {
+		huart->RxState = HAL_UART_STATE_READY;
+		huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+	}
+	HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+	if (huart->RxState != HAL_UART_STATE_READY || huart->hdmarx == NULL || pData == NULL || Size == 0) {
+		return HAL_BUSY;
+	}
+	huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+	huart->pRxBuffPtr = pData;
+	huart->RxXferSize = Size;
+	huart->hdmarx->XferHalfCpltCallback = rxhalf;
+	huart->hdmarx->XferCpltCallback = rxfull;
+	HAL_DMA_Start_IT(huart->hdmarx, (uint32_t)(uintptr_t)&huart->Instance->RDR, (uint32_t)(uintptr_t)pData, Size);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+	if (huart->gState != HAL_UART_STATE_READY || huart->hdmatx == NULL || pData == NULL || Size == 0) {
+		return HAL_BUSY;
+	}
+	huart->gState = HAL_UART_STATE_BUSY_TX;
+	huart->TxXferSize = Size;
+	huart->hdmatx->XferHalfCpltCallback = NULL;
+	huart->hdmatx->XferCpltCallback = NULL; // Completion comes from the USART, once the last byte is out
+	if (HAL_DMA_Start_IT(huart->hdmatx, (uint32_t)(uintptr_t)pData, (uint32_t)(uintptr_t)&huart->Instance->TDR, Size) != HAL_OK) {
+		huart->gState = HAL_UART_STATE_READY;
+		return HAL_ERROR;
+	}
+	sim_event_at(sim_now(), txnext, NULL);
+	return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
+{
+	if (uart.idle) {
+		uint32_t left = sim_dma_remaining(huart->hdmarx->Instance);
+
+		uart.idle = false;
+		if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE && huart->RxState == HAL_UART_STATE_BUSY_RX) {
+			if (left > 0 && left < huart->RxXferSize) {
+				HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize - left));
+			} else if (left == huart->RxXferSize && huart->hdmarx->Init.Mode == DMA_CIRCULAR) {
+				HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+			}
+		}
+	}
+	if (uart.tc) {
+		uart.tc = false;
+		huart->gState = HAL_UART_STATE_READY;
+		HAL_UART_TxCpltCallback(huart);
+	}
+}
+
+__attribute__((weak)) void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	(void)huart;
+	(void)Size;
+}
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	(void)huart;
+}
+
+__attribute__((weak)) void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	(void)huart;
+}
+
+void sim_uart_send(const void *data, size_t len)
+{
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < len; i++) {
+		fifo_put(&uart.in, bytes[i]);
+	}
+	rxkick();
+	sim_reschedule();
+}
+
+size_t sim_uart_take(char *out, size_t max)
+{
+	size_t n = 0;
+
+	while (n < max && uart.out.count > 0) {
+		out[n++] = (char)fifo_get(&uart.out);
+	}
+	return n;
+}
+
+uint64_t sim_uart_lost(void)
+{
+	return uart.lost;
+}
+
+void sim_uart_attach(int fd, bool wait)
+{
+	hostfd = fd;
+	hostwait = wait && fd >= 0;
+	paced = false;
+}
+
+int sim_uart_pty(char *name, size_t size, bool wait)
+{
+	struct termios raw;
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0 || ptsname(fd) == NULL) {
+		if (fd >= 0) {
+			close(fd);
+		}
+		return -1;
+	}
+	snprintf(name, size, "%s", ptsname(fd));
+
+	// Bytes pass through unchanged both ways
+	if (tcgetattr(fd, &raw) == 0) {
+		cfmakeraw(&raw);
+		tcsetattr(fd, TCSANOW, &raw);
+	}
+	sim_uart_attach(fd, wait);
+	return fd;
+}
+
+// Reads what the host has written so far, without blocking
+static bool hostread(void)
+{
+	uint8_t bytes[256];
+	struct pollfd p = {hostfd, POLLIN, 0};
+	ssize_t n;
+
+	if (poll(&p, 1, 0) <= 0 || (p.revents & POLLIN) == 0) {
+		return false;
+	}
+	n = read(hostfd, bytes, sizeof(bytes));
+	if (n <= 0) {
+		return false;
+	}
+	sim_uart_send(bytes, (size_t)n);
+	return true;
+}
+
+void sim_uart_poll(void)
+{
+	if (hostfd >= 0) {
+		hostread();
+	}
+}
+
+static uint64_t wallus(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// Someone is typing, so virtual time goes no faster than the wall clock:
+// waits until the wall clock reaches next, or returns earlier with the
+// virtual time input came in at
+uint64_t sim_uart_pace(uint64_t now, uint64_t next)
+{
+	struct pollfd p = {hostfd, POLLIN, 0};
+	uint64_t wall, target;
+	int timeout;
+
+	if (!hostwait) {
+		return next;
+	}
+	wall = wallus();
+	if (paced == false || wall > base + now / SIM_US(1) + SIM_UART_SLIP_US) { // Start, or fell behind
+		base = wall - now / SIM_US(1);
+		paced = true;
+	}
+	for (;;) {
+		wall = wallus();
+		target = next == SIM_NEVER ? UINT64_MAX : base + next / SIM_US(1);
+		if (wall >= target) {
+			return next;
+		}
+		timeout = target - wall > 1000000000ULL ? -1 : (int)((target - wall + 999) / 1000);
+		if (poll(&p, 1, timeout) < 0) {
+			return next; // A signal, sim_interrupt() may have ended the run
+		}
+		if (p.revents & POLLIN) {
+			target = (wallus() - base) * SIM_US(1);
+			return target > now ? (target < next ? target : next) : now;
+		}
+		if ((p.revents & POLLHUP) && usleep(SIM_UART_RETRY_US) != 0) { // Nobody has the pty open
+			return next;
+		}
+	}
+}
+
+bool sim_uart_wait(void)
+{
+	return hostwait;
+}
+
+void sim_uart_reset(void)
+{
+	memset(&uart, 0, sizeof(uart));
+}
@@ -0,0 +1,352 @@
+/**
+  ******************************************************************************
+  * @file           : test_codestore.c
+  * @brief          : Host test of batch removal and the browsing index in
+  *                   Core/Src/codestore.c.
+  *                   Marks hundreds of codes out of 999, and up to a full
+  *                   table, sweeps them out in one pass and checks that
+  *                   exactly the marked codes went, each reported once,
+  *                   that every other code is still found, that the prefix
+  *                   and length counts match a store built from the
+  *                   survivors, and that marks follow their codes when
+  *                   single removals shift entries back. Then checks the index holds every
+  *                   code in order and that a prefix search lands on the
+  *                   same code a walk from the start finds. Cursors
+  *                   typed and backspaced at random keep counts and found
+  *                   in step with every code compared by hand, and a
+  *                   cursor part way through a code follows the store
+  *                   changing under it, finds codes of every length and
+  *                   sees past 3 digits when none can match.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "codestore.h"
+
+static int failures;
+static uint32_t seed = 1;
+static char codes[CODESTORE_CAPACITY][CODESTORE_MAX + 1];
+static bool picked[CODESTORE_CAPACITY];
+static codestore_t store, rebuilt;
+static int reported;
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while (0)
+
+static uint32_t lcg(void)
+{
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+// Fills the store with n distinct random codes of 4 to 10 digits
+static void fill(int n)
+{
+	codestore_clear(&store);
+	for (int i = 0; i < n; i++) {
+		do {
+			int digits = CODESTORE_MIN + lcg() % (CODESTORE_MAX - CODESTORE_MIN + 1);
+
+			for (int d = 0; d < digits; d++) {
+				codes[i][d] = '0' + lcg() % 10;
+			}
+			codes[i][digits] = '\0';
+		} while (codestore_add(&store, codes[i]) == false);
+		picked[i] = false;
+	}
+}
+
+// Sweep callback, each code must have been marked and not reported before
+static void removed(const char *code)
+{
+	bool known = false;
+
+	for (int i = 0; i < CODESTORE_CAPACITY; i++) {
+		if (picked[i] && strcmp(codes[i], code) == 0) {
+			picked[i] = false; // A second report of it fails
+			known = true;
+			break;
+		}
+	}
+	CHECK(known, "%s removed but not marked, or removed twice", code);
+	reported++;
+}
+
+// Marks count codes out of total, sweeps, and checks what is left
+static void sweep(int total, int count)
+{
+	bool gone[CODESTORE_CAPACITY];
+	uint16_t result;
+
+	fill(total);
+	for (int marked = 0; marked < count; ) {
+		int i = lcg() % total;
+
+		if (picked[i] == false) {
+			CHECK(codestore_mark(&store, codes[i], true), "cannot mark %s", codes[i]);
+			picked[i] = true;
+			marked++;
+		}
+	}
+	if (codestore_contains(&store, "0000000000") == false) {
+		CHECK(codestore_mark(&store, "0000000000", true) == false, "marked a code that is not stored");
+	}
+	memcpy(gone, picked, sizeof(gone));
+
+	reported = 0;
+	result = codestore_sweep(&store, removed);
+	CHECK(result == count && reported == count, "%d of %d marked: sweep said %u, reported %d",
+		count, total, result, reported);
+	CHECK(codestore_total(&store) == total - count, "%d of %d marked: %u left",
+		count, total, codestore_total(&store));
+
+	codestore_clear(&rebuilt);
+	for (int i = 0; i < total; i++) {
+		CHECK(codestore_contains(&store, codes[i]) == !gone[i], "%d of %d marked: %s %s",
+			count, total, codes[i], gone[i] ? "still stored" : "lost");
+		CHECK(codestore_marked(&store, codes[i]) == false, "%s still marked", codes[i]);
+		if (gone[i] == false) {
+			codestore_add(&rebuilt, codes[i]);
+		}
+	}
+	CHECK(memcmp(store.prefix, rebuilt.prefix, sizeof(store.prefix)) == 0, "%d of %d marked: prefix counts off",
+		count, total);
+	CHECK(memcmp(store.lengths, rebuilt.lengths, sizeof(store.lengths)) == 0, "%d of %d marked: length counts off",
+		count, total);
+}
+
+// Marks stay with their codes when removing others shifts them back
+static void test_marks_move(void)
+{
+	int moved;
+
+	fill(CODESTORE_CAPACITY);
+	for (int i = 0; i < CODESTORE_CAPACITY; i += 3) {
+		codestore_mark(&store, codes[i], true);
+		picked[i] = true;
+	}
+	moved = (int)store.moves;
+	for (int i = 1; i < CODESTORE_CAPACITY; i += 3) {
+		codestore_remove(&store, codes[i]);
+	}
+	CHECK(store.moves != (uint32_t)moved, "no removal shifted an entry");
+	for (int i = 0; i < CODESTORE_CAPACITY; i++) {
+		if (i % 3 != 1) {
+			CHECK(codestore_marked(&store, codes[i]) == picked[i], "mark of %s %s", codes[i],
+				picked[i] ? "lost" : "appeared");
+		}
+	}
+	CHECK(store.marked == (CODESTORE_CAPACITY + 2) / 3, "%u marked", store.marked);
+	codestore_unmark(&store);
+	CHECK(codestore_marked(&store, codes[0]) == false && store.marked == 0, "unmark left marks");
+	CHECK(codestore_sweep(&store, NULL) == 0, "sweep removed codes with none marked");
+}
+
+// Index order against codestore_next(), and prefix search against the
+// first code in that order that starts with the prefix
+static void test_index(int total)
+{
+	static codestore_index_t index;
+	static char ordered[CODESTORE_CAPACITY][CODESTORE_MAX + 1];
+	codestore_cursor_t cursor;
+	codestore_key_t key = CODESTORE_NONE;
+	char prefix[CODESTORE_MAX + 1];
+
+	fill(total);
+	codestore_index(&store, &index);
+	CHECK(index.total == total, "index of %d codes has %u", total, index.total);
+	for (int i = 0; i < total; i++) {
+		key = codestore_next(&store, key);
+		CHECK(codestore_at(&store, &index, (uint16_t)i) == key, "%d codes: position %d out of order", total, i);
+		codestore_code(key, ordered[i]);
+	}
+	CHECK(codestore_at(&store, &index, (uint16_t)total) == CODESTORE_NONE, "position past the end has a code");
+
+	for (int round = 0; round < 2000; round++) {
+		int digits = 1 + lcg() % CODESTORE_MAX, expect = -1, found;
+
+		if (round % 2 == 0) {
+			strcpy(prefix, codes[lcg() % total]); // A prefix of a stored code, so most are hits
+			prefix[digits < (int)strlen(prefix) ? digits : (int)strlen(prefix)] = '\0';
+		} else {
+			for (int d = 0; d < digits; d++) {
+				prefix[d] = '0' + lcg() % 10;
+			}
+			prefix[digits] = '\0';
+		}
+		codestore_begin(&store, &cursor);
+		for (int d = 0; prefix[d] != '\0'; d++) {
+			codestore_push(&store, &cursor, prefix[d]);
+		}
+		for (int i = 0; i < total && expect < 0; i++) {
+			if (strncmp(ordered[i], prefix, strlen(prefix)) == 0) {
+				expect = i;
+			}
+		}
+		found = codestore_seek(&store, &index, &cursor);
+		CHECK(found == expect, "%d codes: prefix %s found at %d, first is at %d", total, prefix, found, expect);
+	}
+}
+
+// A code typed while it is removed and added back, as the console can
+static void test_cursor_refresh(void)
+{
+	codestore_cursor_t cursor;
+
+	fill(100);
+	codestore_begin(&store, &cursor);
+	for (int d = 0; codes[0][d] != '\0'; d++) {
+		codestore_push(&store, &cursor, codes[0][d]);
+	}
+	CHECK(codestore_found(&cursor) == true, "stored code %s not found", codes[0]);
+	codestore_remove(&store, codes[0]);
+	codestore_refresh(&store, &cursor);
+	CHECK(codestore_found(&cursor) == false, "removed code %s still found", codes[0]);
+	codestore_add(&store, codes[0]);
+	codestore_refresh(&store, &cursor);
+	CHECK(codestore_found(&cursor) == true, "code %s added back not found", codes[0]);
+	codestore_clear(&store);
+	codestore_refresh(&store, &cursor);
+	CHECK(codestore_found(&cursor) == false && cursor.matches == 0, "code %s found after a clear", codes[0]);
+}
+
+// Stored codes that start with prefix, and whether one is prefix itself
+static int starting(int total, const char *prefix, bool *exact)
+{
+	int n = 0;
+
+	*exact = false;
+	for (int i = 0; i < total; i++) {
+		if (strncmp(codes[i], prefix, strlen(prefix)) == 0) {
+			n++;
+			*exact |= strcmp(codes[i], prefix) == 0;
+		}
+	}
+	return n;
+}
+
+// Random digits and backspaces against a count over every stored code: the
+// counts are exact up to 3 digits and bound it past that, 0 exactly when
+// nothing starts with the digits
+static void test_cursor_counts(int total)
+{
+	codestore_cursor_t cursor;
+	char typed[CODESTORE_MAX + 1] = "";
+	int length = 0;
+
+	fill(total);
+	codestore_begin(&store, &cursor);
+	for (int step = 0; step < 20000; step++) {
+		bool exact;
+		int expect;
+
+		if (length > 0 && (length == CODESTORE_MAX || lcg() % 3 == 0)) {
+			codestore_pop(&store, &cursor);
+			typed[--length] = '\0';
+		} else {
+			// Mostly the next digit of a code that goes on from these, so the walk reaches long prefixes
+			char digit = '0' + lcg() % 10;
+			int from = lcg() % total;
+			bool follow = lcg() % 4 != 0;
+
+			for (int i = 0; follow && i < total; i++) {
+				const char *code = codes[(from + i) % total];
+
+				if ((int)strlen(code) > length && strncmp(code, typed, length) == 0) {
+					digit = code[length];
+					break;
+				}
+			}
+			CHECK(codestore_push(&store, &cursor, digit), "push of %c after %s refused", digit, typed);
+			typed[length++] = digit;
+			typed[length] = '\0';
+		}
+		expect = starting(total, typed, &exact);
+		CHECK(cursor.digits == length, "%s: cursor has %u digits", typed, cursor.digits);
+		CHECK(codestore_found(&cursor) == (exact && length >= CODESTORE_MIN), "%s: found %d, stored %d", typed,
+			codestore_found(&cursor), exact);
+		if (length <= 3) {
+			CHECK(cursor.matches == expect, "%d codes: %s matches %u, %d start with it", total, typed,
+				cursor.matches, expect);
+		} else {
+			CHECK(cursor.matches >= expect && (cursor.matches == 0) == (expect == 0),
+				"%d codes: %s matches %u, %d start with it", total, typed, cursor.matches, expect);
+		}
+	}
+	CHECK(codestore_push(&store, &cursor, 'x') == false, "pushed a letter");
+}
+
+// Codes of every length from 4 to 10 along one chain of digits, each found
+// as its digits are typed, and digits past 3 that no code goes on from
+// reading as no match though their first 3 still have codes
+static void test_cursor_lengths(void)
+{
+	static const char chain[] = "1234567890";
+	codestore_cursor_t cursor;
+	char code[CODESTORE_MAX + 1];
+
+	codestore_clear(&store);
+	for (int digits = CODESTORE_MIN; digits <= CODESTORE_MAX; digits += 2) {
+		memcpy(code, chain, digits);
+		code[digits] = '\0';
+		codestore_add(&store, code);
+	}
+	codestore_begin(&store, &cursor);
+	for (int d = 0; chain[d] != '\0'; d++) {
+		codestore_push(&store, &cursor, chain[d]);
+		CHECK(codestore_found(&cursor) == (d + 1 >= CODESTORE_MIN && (d + 1) % 2 == 0), "%.*s %s", d + 1, chain,
+			codestore_found(&cursor) ? "found but not stored" : "stored but not found");
+		CHECK(cursor.matches > 0, "%.*s reads as no match", d + 1, chain);
+	}
+	for (int d = CODESTORE_MAX - 1; d >= CODESTORE_MIN - 1; d--) {
+		codestore_pop(&store, &cursor);
+		CHECK(codestore_found(&cursor) == (d >= CODESTORE_MIN && d % 2 == 0), "%.*s after backspace %s", d, chain,
+			codestore_found(&cursor) ? "found but not stored" : "stored but not found");
+	}
+
+	// These share their first 3 digits with stored codes, but no code goes on from them
+	for (int i = 0; i < 3; i++) {
+		static const char *dead[] = {"1239", "12340", "12345679"};
+
+		codestore_begin(&store, &cursor);
+		for (int d = 0; dead[i][d] != '\0'; d++) {
+			codestore_push(&store, &cursor, dead[i][d]);
+		}
+		CHECK(cursor.matches == 0 && codestore_found(&cursor) == false, "%s can match %u", dead[i], cursor.matches);
+	}
+	codestore_begin(&store, &cursor); // One digit short of a code
+	for (int d = 0; d < 9; d++) {
+		codestore_push(&store, &cursor, chain[d]);
+	}
+	CHECK(cursor.matches > 0 && codestore_found(&cursor) == false, "123456789 reads as %u, %s", cursor.matches,
+		codestore_found(&cursor) ? "found" : "not found");
+}
+
+int main(void)
+{
+	static const int counts[] = {0, 1, 100, 300, 500, 998, 999};
+
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		sweep(999, counts[c]);
+	}
+	for (int round = 0; round < 20; round++) { // A full table, so probe runs are long and wrap around
+		sweep(CODESTORE_CAPACITY, (int)(lcg() % CODESTORE_CAPACITY));
+	}
+	test_marks_move();
+	test_index(1);
+	test_index(999);
+	test_index(CODESTORE_CAPACITY);
+	test_cursor_counts(1);
+	test_cursor_counts(999);
+	test_cursor_refresh();
+	test_cursor_lengths();
+	printf("%s\n", failures == 0 ? "codestore tests passed" : "codestore tests FAILED");
+	return failures == 0 ? 0 : 1;
+}
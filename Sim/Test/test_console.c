@@ -0,0 +1,228 @@
+/**
+  ******************************************************************************
+  * @file           : test_console.c
+  * @brief          : Host test of the USART2 console in Core/Src/console.c.
+  *                   Boots the whole lock with the console model attached to
+  *                   a pty and talks to it from the slave side, as a
+  *                   terminal would: each command is written once the reply
+  *                   to the one before has come back. Covers the admin
+  *                   login and its lapse, the replies to
+  *                   add and remove, bursts of commands that wrap the
+  *                   receive buffer, a list long enough to need many
+  *                   transmit buffers, the journal dump, and a wake from
+  *                   Stop 2 by a start bit, which loses that byte.
+  ******************************************************************************
+  */
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "sim.h"
+#include "console.h"
+#include "journal.h"
+#include <termios.h> // After the device header, its output flags are named CR1, CR2 and CR3 too
+
+int lock_main(void); // main() in Core/Src/main.c
+
+#define BURSTS 5 // Groups of adds written at once, together past the receive buffer
+#define BURST 10 // Adds in each group
+#define REPLY_MS 200 // Wall time the pty gets to pass bytes on
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while (0)
+
+typedef struct {
+	const char *send; // Written in one go, NULL for none
+	const char *expect; // Reply that ends the step
+	bool stopped; // Wait for Stop 2 before writing, so the console has to wake
+	uint32_t quiet; // Virtual ms to wait after the step before, in Stop 2
+} step_t;
+
+static step_t script[12 + BURSTS + 12];
+static int steps, at;
+static char bursts[BURSTS][BURST * 16], lastadd[32];
+
+static int master, slave;
+static char seen[65536]; // Everything the console sent
+static size_t seenlen, stepfrom;
+
+// Takes what the console has sent through the pty, all of it once the
+// firmware has nothing left to send
+static void drain(void)
+{
+	struct pollfd p = {slave, POLLIN, 0};
+	ssize_t n;
+
+	while (seenlen < console_stats()->sent && poll(&p, 1, REPLY_MS) > 0) {
+		n = read(slave, seen + seenlen, sizeof(seen) - 1 - seenlen);
+		if (n <= 0) {
+			break;
+		}
+		seenlen += (size_t)n;
+	}
+	seen[seenlen] = '\0';
+}
+
+// Writes to the terminal side and waits until the model can read it
+static void type(const char *text)
+{
+	struct pollfd p = {master, POLLIN, 0};
+
+	CHECK(write(slave, text, strlen(text)) == (ssize_t)strlen(text), "short write to the pty");
+	poll(&p, 1, REPLY_MS);
+}
+
+static void nothing(void *arg)
+{
+	(void)arg;
+}
+
+// Idle hook: writes each step once the one before has its reply, and ends
+// the run after the last. A quiet step first sets an event after its wait,
+// so the idle lock does not skip past it to the end of the run. Steps wait for the journal to finish writing, so
+// the log shows every change. A line typed while the lock is in Stop 2 would
+// lose its first byte, so a bare CR goes first to wake the console, as a
+// user would press Enter.
+static void converse(void *ctx)
+{
+	static bool begun;
+	static uint64_t until;
+
+	(void)ctx;
+	while (at < steps) {
+		step_t *s = &script[at];
+
+		if (begun == false) {
+			if (s->quiet > 0 && until == 0) {
+				until = sim_now() + SIM_MS(s->quiet);
+				sim_event_at(until, nothing, NULL);
+			}
+			if (journal_busy() || (s->stopped && sim_core_stopped() == false) || sim_now() < until) {
+				return;
+			}
+			s->quiet = 0; // Waited
+			until = 0;
+			if (sim_core_stopped()) {
+				type("\r");
+				s->stopped = false; // Woken
+				return;
+			}
+			stepfrom = seenlen;
+			if (s->send != NULL) {
+				type(s->send);
+			}
+			begun = true;
+		}
+		drain();
+		if (strstr(seen + stepfrom, s->expect) == NULL) {
+			return; // Not yet, the firmware still has work to do
+		}
+		at++;
+		begun = false;
+	}
+	sim_stop();
+}
+
+static void add(const char *send, const char *expect, bool stopped)
+{
+	script[steps++] = (step_t){send, expect, stopped, 0};
+}
+
+// Positions of the burst codes in the list are in ascending order
+static bool ordered(const char *list)
+{
+	const char *last = list;
+	char code[16];
+
+	for (int i = 0; i < BURSTS * BURST; i++) {
+		const char *p;
+
+		snprintf(code, sizeof(code), "\n%u\r", 200000u + i);
+		p = strstr(list, code);
+		if (p == NULL || p < last) {
+			return false;
+		}
+		last = p;
+	}
+	return true;
+}
+
+int main(void)
+{
+	char name[64], total[32], *list, *log;
+	struct termios raw;
+	const console_stats_t *stats = console_stats();
+
+	sim_flash_wipe();
+	sim_settle(3600000000ULL); // The script ends the run, this only stops a hang
+	sim_reset();
+	master = sim_uart_pty(name, sizeof(name), false);
+	CHECK(master >= 0, "cannot open a pty");
+	if (master < 0) {
+		return 1;
+	}
+	slave = open(name, O_RDWR | O_NOCTTY);
+	CHECK(slave >= 0 && tcgetattr(slave, &raw) == 0, "cannot open %s", name);
+	cfmakeraw(&raw); // No echo or line editing on the terminal side, the console does both
+	tcsetattr(slave, TCSANOW, &raw);
+
+	add(NULL, "help for commands\r\n> ", false);
+	add("help\r", "list, add <code>", false);
+	add("add 5555\r", "add: login first", false);
+	add("login 2581\r", "wrong code", false);
+	add("login 2580\r", "logged in", false);
+	add("add 12\r", "add: 4 to 10 digits", false);
+	add("add 5555\r", "added 5555, 1 codes", false);
+	add("add 5555\r", "already stored", false);
+	add("remove 777777\r", "not stored", false);
+	add("frobnicate\r", "frobnicate: unknown", false);
+	for (int b = 0; b < BURSTS; b++) {
+		char *p = bursts[b];
+
+		for (int i = 0; i < BURST; i++) {
+			p += sprintf(p, "add %u\r", 200000u + b * BURST + i);
+		}
+		snprintf(lastadd, sizeof(lastadd), "added %u, %u codes", 200000u + b * BURST + BURST - 1,
+			1u + (b + 1) * BURST);
+		add(bursts[b], strdup(lastadd), false);
+	}
+	snprintf(total, sizeof(total), "\n%u codes\r\n", 1u + BURSTS * BURST);
+	add("list\r", total, false);
+	add("remove 200000\r", "removed 200000", false);
+	add("log\r", " records\r\n", false);
+	add("stats\r", "console in", false);
+	add("cycles 5555\r", " cycles\r\n", false);
+	add("help\r", "list, add <code>", true);
+	add("list\r", "list: login first", true);
+	script[steps - 1].quiet = CONSOLE_ADMIN_MS;
+
+	sim_idle_hook(converse, NULL);
+	sim_run(lock_main);
+
+	CHECK(at == steps, "stopped at step %d, waiting for \"%s\"", at, at < steps ? script[at].expect : "");
+	list = strstr(seen, "> list\r\n");
+	CHECK(list != NULL && ordered(list), "list out of order or missing codes");
+	log = strstr(seen, "> log\r\n");
+	CHECK(log != NULL && strstr(log, " 200049\r\n") != NULL && strstr(log, "remove 200000\r\n") != NULL,
+		"journal dump is missing the adds or the remove");
+	CHECK(stats->received > CONSOLE_RX, "%u bytes received, the buffer never wrapped", (unsigned)stats->received);
+	CHECK(stats->overruns == 0 && stats->errors == 0, "%u overruns, %u errors",
+		(unsigned)stats->overruns, (unsigned)stats->errors);
+	CHECK(stats->wakes >= 1 && sim_uart_lost() >= 1, "%u wakes, %llu bytes lost",
+		(unsigned)stats->wakes, (unsigned long long)sim_uart_lost());
+	printf("%u commands, %u bytes in, %u out, %u wakes from Stop 2\n", (unsigned)stats->commands,
+		(unsigned)stats->received, (unsigned)stats->sent, (unsigned)stats->wakes);
+	printf("%s\n", failures == 0 ? "console tests passed" : "console tests FAILED");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file           : test_delay.c
+  * @brief          : Host test of the DWT delay loop in Core/Src/delay.c.
+  *                   Builds the real delay_cycles() against a model cycle
+  *                   counter that moves on a fixed number of cycles per
+  *                   read, standing in for the cost of one loop pass.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include "main.h"
+#include "delay.h"
+
+#define LOOP_CYCLES 6 // Cycles per CYCCNT read in the model, about one loop pass
+
+uint32_t SystemCoreClock;
+
+static DWT_Type dwt;
+static CoreDebug_Type coredebug;
+static uint32_t reads;
+static int failures;
+
+// Each access to DWT is one read of CYCCNT, which costs a loop pass
+DWT_Type *sim_dwt(void)
+{
+	if (dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+		dwt.CYCCNT += LOOP_CYCLES;
+	}
+	reads++;
+	return &dwt;
+}
+
+CoreDebug_Type *sim_coredebug(void)
+{
+	return &coredebug;
+}
+
+uint32_t sim_get_primask(void)
+{
+	return 0;
+}
+
+void sim_set_primask(uint32_t primask)
+{
+	(void)primask;
+}
+
+void sim_disable_irq(void)
+{
+}
+
+void sim_enable_irq(void)
+{
+}
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while (0)
+
+// Cycles a call took on the model counter, starting from a chosen count
+static uint32_t timed(void (*fn)(uint32_t), uint32_t arg, uint32_t from)
+{
+	dwt.CYCCNT = from;
+	fn(arg);
+	return dwt.CYCCNT - from;
+}
+
+// Every delay is at least as long as asked and at most two loop passes over
+static void test_bounds(void)
+{
+	static const uint32_t clocks[] = {4000000, 16000000, 80000000};
+	static const uint32_t ns[] = {1, 100, 450, 1000, 37000, 999999};
+	static const uint32_t us[] = {1, 40, 4100, 1000000};
+
+	for (unsigned c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++) {
+		uint64_t mhz;
+
+		SystemCoreClock = clocks[c];
+		mhz = SystemCoreClock / 1000000;
+		for (unsigned i = 0; i < sizeof(ns) / sizeof(ns[0]); i++) {
+			uint64_t want = (ns[i] * mhz + 999) / 1000;
+			uint32_t took = timed(delay_ns, ns[i], 0);
+			CHECK(took >= want && took <= want + 2 * LOOP_CYCLES,
+				"delay_ns(%u) at %u Hz took %u cycles, want %llu", ns[i], clocks[c], took,
+				(unsigned long long)want);
+		}
+		for (unsigned i = 0; i < sizeof(us) / sizeof(us[0]); i++) {
+			uint64_t want = us[i] * mhz;
+			uint32_t took = timed(delay_us, us[i], 0);
+			CHECK(took >= want && took <= want + 2 * LOOP_CYCLES,
+				"delay_us(%u) at %u Hz took %u cycles, want %llu", us[i], clocks[c], took,
+				(unsigned long long)want);
+		}
+	}
+}
+
+// The count is compared as a difference, so crossing 2^32 changes nothing
+static void test_wrap(void)
+{
+	SystemCoreClock = 80000000;
+	for (uint32_t before = 0; before < 1000; before += 7) {
+		uint32_t took = timed(delay_us, 10, 0xFFFFFFFFu - before);
+		CHECK(took >= 800 && took <= 800 + 2 * LOOP_CYCLES,
+			"delay_us(10) across the wrap took %u cycles", took);
+	}
+}
+
+// Long waits are split below the wrap, each piece at most two passes over
+static void test_long(void)
+{
+	uint64_t want, took;
+	uint32_t pieces;
+
+	SystemCoreClock = 80000000;
+	dwt.CYCCNT = 0x80000000u;
+	reads = 0;
+	delay_ms(2500);
+	took = reads * (uint64_t)LOOP_CYCLES;
+	want = 2500ULL * 80000;
+	pieces = 3;
+	CHECK(took >= want && took <= want + pieces * 2 * LOOP_CYCLES,
+		"delay_ms(2500) took %llu cycles, want %llu", (unsigned long long)took, (unsigned long long)want);
+}
+
+// Calibration finds the fixed cost and takes it off later delays
+static void test_calibrate(void)
+{
+	const delay_report_t *report;
+
+	SystemCoreClock = 80000000;
+	report = delay_calibrate();
+	CHECK(report->clock == SystemCoreClock, "report clock %u", report->clock);
+	CHECK(report->overhead > 0 && report->overhead <= 2 * LOOP_CYCLES, "overhead %u cycles", report->overhead);
+	printf("calibration at %u Hz, overhead %u cycles\n", report->clock, report->overhead);
+	for (int i = 0; i < DELAY_POINTS; i++) {
+		int32_t error = (int32_t)report->took[i] - (int32_t)report->asked[i];
+		printf("  %8u ns took %8u ns (%+d)\n", report->asked[i], report->took[i], error);
+		CHECK(error >= -(int32_t)(LOOP_CYCLES * 1000 / 80) && error <= (int32_t)(LOOP_CYCLES * 1000 / 80),
+			"%u ns point off by %d ns", report->asked[i], error);
+	}
+}
+
+int main(void)
+{
+	delay_init();
+	test_bounds();
+	test_wrap();
+	test_long();
+	test_calibrate();
+	printf("%s\n", failures == 0 ? "delay tests passed" : "delay tests FAILED");
+	return failures == 0 ? 0 : 1;
+}
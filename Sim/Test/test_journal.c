@@ -0,0 +1,342 @@
+/**
+  ******************************************************************************
+  * @file           : test_journal.c
+  * @brief          : Host test of the flash journal in Core/Src/journal.c.
+  *                   Runs the real journal against the simulator's flash
+  *                   model: codes must come back after a remount, boot must
+  *                   replay one segment at most, erases must spread over the
+  *                   ring, changes made while the flash is busy must all be
+  *                   kept, a queue overflowing while a record is being
+  *                   programmed must leave just that record and one
+  *                   snapshot to write, and cutting the power during any
+  *                   flash operation must leave either the codes from
+  *                   before or after the change that was being saved.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "journal.h"
+
+#define CHURN 40000
+#define KEYS 300 // Codes the random changes pick from, so removes often hit
+#define FILL 2500 // Codes stored before the busy and power cut tests, a near-full snapshot
+#define STRETCH 4096 // Changes the power cut test runs, enough to fill a segment and compact
+#define CHECKPOINT 128 // Changes between the images the power cut test restarts from
+
+static int failures;
+static uint32_t seed = 1;
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while (0)
+
+static uint32_t lcg(void)
+{
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+// Code number n, 4 to 10 digits long depending on n
+static void codeof(int n, char *code)
+{
+	snprintf(code, CODESTORE_MAX + 1, "%0*d", CODESTORE_MIN + n % (CODESTORE_MAX - CODESTORE_MIN + 1), n);
+}
+
+// Same codes, wherever they sit in the tables
+static bool same(const codestore_t *a, const codestore_t *b)
+{
+	char code[CODESTORE_MAX + 1];
+
+	if (a->total != b->total) {
+		return false;
+	}
+	for (uint32_t slot = 0; slot < CODESTORE_SLOTS; slot++) {
+		if (a->slots[slot] != CODESTORE_NONE) {
+			codestore_code(a->slots[slot], code);
+			if (codestore_contains(b, code) == false) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Stores codes 0 to n - 1 without journaling them
+static void fill(codestore_t *store, int n)
+{
+	char code[CODESTORE_MAX + 1];
+
+	for (int i = 0; i < n; i++) {
+		codeof(KEYS + i, code);
+		codestore_add(store, code);
+	}
+}
+
+// Waits for the next flash completion and hands it to the journal, as the
+// main loop would
+static void step(void)
+{
+	if (journal_ready()) {
+		journal_poll();
+	} else {
+		sim_wfi();
+	}
+}
+
+// Runs the flash until the journal has written what it can
+static void settle(void)
+{
+	while (journal_busy()) {
+		step();
+	}
+}
+
+// One random change to the store, or one batch of adds, journaled the way
+// main.c does it
+static void edit(codestore_t *store)
+{
+	uint32_t pick = lcg();
+	char code[CODESTORE_MAX + 1];
+
+	codeof((int)(pick % KEYS), code);
+	if (pick % 1000 == 0) {
+		codestore_clear(store);
+		codestore_add(store, code);
+		journal_clear(code);
+	} else if (pick % 1000 < 20) { // Bulk enrollment, one batch of adds
+		journal_begin();
+		for (uint32_t n = 1 + (pick >> 12) % JOURNAL_BATCH; n > 0; n--) {
+			codeof((int)(lcg() % KEYS), code);
+			if (codestore_add(store, code) == true) {
+				journal_add(code);
+			}
+		}
+		journal_commit();
+	} else if ((pick >> 10) & 1) {
+		if (codestore_add(store, code) == true) {
+			journal_add(code);
+		}
+	} else if (codestore_remove(store, code) == true) {
+		journal_remove(code);
+	}
+}
+
+// One change written out, false if a flash operation failed
+static bool change(codestore_t *store)
+{
+	uint32_t errors = journal_stats()->errors;
+
+	edit(store);
+	settle();
+	return journal_stats()->errors == errors;
+}
+
+// Mounts into a fresh store, as after a power cycle
+static bool remount(codestore_t *store)
+{
+	sim_reset();
+	return journal_mount(store);
+}
+
+// Blank flash mounts empty, and the first change is saved
+static void test_empty(void)
+{
+	static codestore_t store, back;
+
+	sim_flash_wipe();
+	CHECK(remount(&store) == false, "blank flash mounted");
+	CHECK(codestore_total(&store) == 0, "blank flash gave %u codes", codestore_total(&store));
+	codestore_add(&store, "1234");
+	journal_clear("1234");
+	settle();
+	CHECK(journal_stats()->errors == 0, "first code not saved");
+	CHECK(remount(&back) == true && same(&store, &back), "first code lost");
+	CHECK(codestore_contains(&back, "1234"), "1234 missing after remount");
+}
+
+// Thousands of changes: every remount matches, boot stays within one
+// segment, and the ring wears evenly
+static void test_churn(void)
+{
+	static codestore_t store, saved;
+	uint32_t low = UINT32_MAX, high = 0, before;
+
+	sim_flash_wipe();
+	remount(&store);
+	for (int i = 0; i < CHURN; i++) {
+		CHECK(change(&store), "change %d not saved", i);
+		if (i % 250 == 249) {
+			saved = store;
+			before = journal_stats()->mounted;
+			CHECK(remount(&store) == true && same(&store, &saved), "codes differ after change %d", i);
+			CHECK(journal_stats()->mounted - before <= JOURNAL_RECORDS,
+				"boot replayed %u records", (unsigned)(journal_stats()->mounted - before));
+		}
+	}
+	for (uint32_t page = 0; page < JOURNAL_PAGES; page++) {
+		uint32_t n = sim_flash_erases(JOURNAL_BASE + page * JOURNAL_PAGE);
+
+		low = n < low ? n : low;
+		high = n > high ? n : high;
+	}
+	CHECK(low > 0 && high - low <= 1, "page erases range %u to %u", low, high);
+	CHECK(journal_stats()->errors == 0, "%u flash errors", (unsigned)journal_stats()->errors);
+	printf("%d changes, %u compactions, page erases %u to %u, %llu double-words programmed\n",
+		CHURN, (unsigned)journal_stats()->compactions, low, high,
+		(unsigned long long)sim_flash_programs());
+}
+
+// Changes keep coming while the flash is busy, snapshots included, and
+// bursts overflow the queue: everything is still there after a remount
+static void test_busy(void)
+{
+	static codestore_t store, saved;
+	uint32_t compactions;
+
+	sim_flash_wipe();
+	remount(&store);
+	fill(&store, FILL);
+	compactions = journal_stats()->compactions;
+	for (int i = 0; i < CHURN; i++) {
+		edit(&store);
+		for (uint32_t n = lcg() % (i % 500 < 100 ? 1 : 4); n > 0 && journal_busy(); n--) {
+			step();
+		}
+	}
+	settle();
+	saved = store;
+	CHECK(remount(&store) == true && same(&store, &saved), "codes differ after writing while busy");
+	CHECK(journal_stats()->errors == 0, "%u flash errors", (unsigned)journal_stats()->errors);
+	CHECK(journal_stats()->overflows > 0, "queue never overflowed");
+	printf("%d changes while busy, %u compactions, deepest queue %u, %u overflows\n", CHURN,
+		(unsigned)(journal_stats()->compactions - compactions), (unsigned)journal_stats()->depth,
+		(unsigned)journal_stats()->overflows);
+}
+
+// One change being programmed, then JOURNAL_QUEUE more: the queue fills and
+// the last one overflows it. What is left is the record in flight, then a
+// snapshot holding everything, and nothing stale programmed after it.
+static void test_overflow(void)
+{
+	static codestore_t store, saved;
+	char code[CODESTORE_MAX + 1];
+	uint64_t programs;
+	uint32_t overflows;
+
+	sim_flash_wipe();
+	remount(&store);
+	codeof(0, code);
+	codestore_add(&store, code);
+	journal_clear(code);
+	settle();
+	programs = sim_flash_programs();
+	overflows = journal_stats()->overflows;
+	for (int i = 1; i <= JOURNAL_QUEUE + 1; i++) {
+		codeof(i, code);
+		codestore_add(&store, code);
+		journal_add(code);
+	}
+	CHECK(journal_stats()->overflows == overflows + 1, "%u overflows", (unsigned)(journal_stats()->overflows - overflows));
+	CHECK(journal_stats()->queued == 1, "%u queued after the overflow, the record in flight is 1",
+		(unsigned)journal_stats()->queued);
+	settle();
+	CHECK(journal_stats()->queued == 0, "%u queued once idle", (unsigned)journal_stats()->queued);
+	CHECK(sim_flash_programs() - programs == 1 + 1 + codestore_total(&store) + 1,
+		"%llu programs, expected the record in flight, then a header, %u codes and a commit",
+		(unsigned long long)(sim_flash_programs() - programs), (unsigned)codestore_total(&store));
+	saved = store;
+	CHECK(remount(&store) == true && same(&store, &saved), "codes differ after the overflow");
+}
+
+// Power cut during each flash operation over a stretch of changes that
+// includes compactions: the codes after reboot are the ones from before the
+// interrupted change or after it, and saving works again afterwards. The
+// stretch is run once to save an image every CHECKPOINT changes; each cut
+// then starts from the last image before it instead of from the beginning.
+static void test_powercut(const char *image)
+{
+	static codestore_t store, back, before;
+	static struct {
+		uint64_t operations; // Flash operations before the image
+		uint32_t seed;
+	} marks[STRETCH / CHECKPOINT];
+	uint64_t cut, end;
+	uint32_t compactions;
+	char code[CODESTORE_MAX + 1], path[64];
+	int i, mark = 0;
+
+	// Thousands of codes stored, so a compaction has thousands of
+	// operations to interrupt
+	sim_flash_wipe();
+	remount(&store);
+	fill(&store, FILL);
+	codeof(KEYS + FILL - 1, code);
+	journal_add(code); // First write opens a segment with the snapshot
+	settle();
+	seed = 15; // A stretch with no clear before its compaction, so the snapshot is full
+	compactions = journal_stats()->compactions;
+	for (i = 0; i < STRETCH; i++) {
+		if (i % CHECKPOINT == 0) {
+			marks[i / CHECKPOINT].operations = sim_flash_operations();
+			marks[i / CHECKPOINT].seed = seed;
+			snprintf(path, sizeof(path), "%s.%d", image, i / CHECKPOINT);
+			CHECK(sim_flash_save(path), "cannot save %s", path);
+		}
+		change(&store);
+	}
+	end = sim_flash_operations();
+	CHECK(journal_stats()->compactions != compactions && end - marks[0].operations > JOURNAL_RECORDS,
+		"stretch had no full compaction");
+
+	for (cut = marks[0].operations + 1; cut <= end; cut++) {
+		while (mark + 1 < STRETCH / CHECKPOINT && marks[mark + 1].operations < cut) {
+			mark++;
+		}
+		snprintf(path, sizeof(path), "%s.%d", image, mark);
+		CHECK(sim_flash_load(path), "cannot load %s", path);
+		remount(&store);
+		seed = marks[mark].seed;
+		sim_flash_cut((uint32_t)(cut - marks[mark].operations));
+		for (i = mark * CHECKPOINT; i < STRETCH; i++) {
+			before = store;
+			if (change(&store) == false) {
+				break;
+			}
+		}
+		sim_flash_restore();
+		CHECK(i < STRETCH, "cut at operation %llu never came", (unsigned long long)cut);
+		remount(&back);
+		CHECK(same(&back, &before) || same(&back, &store),
+			"cut at operation %llu: %u codes after reboot, %u before the change, %u after",
+			(unsigned long long)cut, codestore_total(&back), codestore_total(&before), codestore_total(&store));
+		codestore_add(&back, "99999998");
+		journal_add("99999998");
+		settle();
+		remount(&store);
+		CHECK(same(&back, &store), "cut at operation %llu: saving failed afterwards", (unsigned long long)cut);
+	}
+	for (mark = 0; mark < STRETCH / CHECKPOINT; mark++) {
+		snprintf(path, sizeof(path), "%s.%d", image, mark);
+		remove(path);
+	}
+	printf("%llu power cuts, %u torn records found at boot\n", (unsigned long long)(end - marks[0].operations),
+		(unsigned)journal_stats()->torn);
+}
+
+int main(void)
+{
+	test_empty();
+	test_churn();
+	test_busy();
+	test_overflow();
+	test_powercut("test_journal.img");
+	printf("%s\n", failures == 0 ? "journal tests passed" : "journal tests FAILED");
+	return failures == 0 ? 0 : 1;
+}
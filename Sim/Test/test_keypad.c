@@ -0,0 +1,239 @@
+/**
+  ******************************************************************************
+  * @file           : test_keypad.c
+  * @brief          : Host test of the keypad scanner and debouncer in
+  *                   Core/Src/keypad.c.
+  *                   Runs the real driver, timers and DMA included, against
+  *                   the simulator's keypad with contact traces in place of
+  *                   clean presses. Every press and release bounces the way
+  *                   a membrane key does, closing and opening for a couple
+  *                   of milliseconds before it settles. Each key must give
+  *                   exactly one press and one release, no sooner than the
+  *                   debounce window allows and no later than one scan past
+  *                   it. Glitches and chatter shorter than the window must
+  *                   give nothing, overlapping keys must come out in order,
+  *                   a fourth key closing a rectangle of three held ones
+  *                   must give nothing since it may be a ghost, and the
+  *                   scanner must stop once every key is up.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "keypad.h"
+
+#define EVENTS 128
+#define SPACING_MS 100 // Between the starts of the presses in the trace
+#define HOLD_MS 60
+#define GLITCH_US ((KEYPAD_SAMPLES - 1) * KEYPAD_SCAN_US - 1) // Longest glitch that must be ignored, seen by one scan too few
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while (0)
+
+// Contact edges after the finger lands and after it lifts, in us. Even
+// entries move towards the new state, so the contact ends settled there.
+static const uint32_t landing[] = {0, 180, 420, 650, 1100, 1500, 2300};
+static const uint32_t lifting[] = {0, 90, 260, 600, 900};
+
+typedef struct {
+	unsigned char event;
+	uint64_t from, to; // Window in us it must arrive in
+} expect_t;
+
+typedef struct {
+	unsigned char event;
+	uint64_t at; // us
+} seen_t;
+
+static expect_t expected[EVENTS];
+static seen_t seen[EVENTS];
+static int nexpected, nseen;
+static uint64_t end; // us, trace over and the scanner given time to stop
+static uint64_t latency, worst; // us from settling to the event
+
+// Plays one bounce of a key's contact starting at us
+static void bounce(char key, uint64_t at, const uint32_t *edges, int n, bool closing)
+{
+	for (int i = 0; i < n; i++) {
+		sim_keys_contact(SIM_US(at + edges[i]), key, (i % 2 == 0) == closing);
+	}
+}
+
+// The event must come between the window after the first edge and the
+// window after the last, plus the rest of the scan it is seen in
+static void expect(unsigned char event, uint64_t at, const uint32_t *edges, int n)
+{
+	expected[nexpected++] = (expect_t){event, at + (KEYPAD_SAMPLES - 1) * KEYPAD_SCAN_US,
+		at + edges[n - 1] + KEYPAD_DEBOUNCE_MS * 1000 + KEYPAD_SCAN_US};
+}
+
+// One bouncing press and release
+static void press(char key, uint64_t at, uint32_t hold)
+{
+	int nl = sizeof(landing) / sizeof(landing[0]), nf = sizeof(lifting) / sizeof(lifting[0]);
+
+	bounce(key, at, landing, nl, true);
+	expect((unsigned char)key, at, landing, nl);
+	bounce(key, at + hold, lifting, nf, false);
+	expect((unsigned char)key | KEYPAD_RELEASED, at + hold, lifting, nf);
+	if (at + hold + 2 * KEYPAD_DEBOUNCE_MS * 1000 > end) {
+		end = at + hold + 2 * KEYPAD_DEBOUNCE_MS * 1000;
+	}
+}
+
+// A contact closed, or opened while held, too briefly to count
+static void glitch(char key, uint64_t at, bool closing)
+{
+	sim_keys_contact(SIM_US(at), key, closing);
+	sim_keys_contact(SIM_US(at + GLITCH_US), key, !closing);
+}
+
+// Takes the queued events, stamped with the time the core woke to them
+static void collect(void)
+{
+	unsigned char event;
+
+	while (keypad_getevent(&event) == true) {
+		if (nseen < EVENTS) {
+			seen[nseen++] = (seen_t){event, sim_time_us()};
+		}
+	}
+}
+
+// Pins as MX_GPIO_Init() sets them: columns out, rows in with EXTI on press
+static void pins(void)
+{
+	GPIO_InitTypeDef init = {0};
+
+	__HAL_RCC_GPIOB_CLK_ENABLE();
+	init.Pin = KEYPAD_COLS;
+	init.Mode = GPIO_MODE_OUTPUT_PP;
+	init.Pull = GPIO_NOPULL;
+	init.Speed = GPIO_SPEED_LOW;
+	HAL_GPIO_Init(GPIOB, &init);
+	init.Pin = KEYPAD_ROWS;
+	init.Mode = GPIO_MODE_IT_RISING;
+	init.Pull = GPIO_PULLDOWN;
+	HAL_GPIO_Init(GPIOB, &init);
+	HAL_NVIC_SetPriority(EXTI9_5_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+	HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+}
+
+// Firmware side: the driver alone, woken by its interrupts until the trace ends
+static int scanner(void)
+{
+	HAL_Init();
+	SystemClock_Config();
+	pins();
+	keypad_init();
+	while (sim_time_us() < end) {
+		__WFI();
+		collect();
+	}
+	return 0;
+}
+
+// Every key once, each bouncing on the way down and up
+static void trace_keys(void)
+{
+	static const char keys[] = "123A456B789C*0#D";
+
+	for (int i = 0; i < 16; i++) {
+		press(keys[i], 50000 + (uint64_t)i * SPACING_MS * 1000, HOLD_MS * 1000);
+	}
+}
+
+// Glitches on an idle pad and chatter on a held key, then two keys rolled over
+static void trace_noise(uint64_t at)
+{
+	glitch('5', at, true);
+	glitch('9', at + 30000, true);
+	press('8', at + 60000, 3 * HOLD_MS * 1000);
+	glitch('8', at + 60000 + HOLD_MS * 1000, false);
+	press('1', at + 300000, HOLD_MS * 1000);
+	press('D', at + 330000, HOLD_MS * 1000);
+}
+
+// Three keys held on two rows and two columns, then the fourth corner
+// bouncing closed and open again while they are down
+static void trace_ghost(uint64_t at)
+{
+	int nl = sizeof(landing) / sizeof(landing[0]), nf = sizeof(lifting) / sizeof(lifting[0]);
+
+	press('1', at, 4 * HOLD_MS * 1000);
+	press('2', at + 20000, 4 * HOLD_MS * 1000);
+	press('4', at + 40000, 4 * HOLD_MS * 1000);
+	bounce('5', at + 80000, landing, nl, true);
+	bounce('5', at + 80000 + HOLD_MS * 1000, lifting, nf, false);
+}
+
+// Puts the expected events in the order they must arrive, the press of a
+// rolled-over key before the release of the one held before it
+static void sortexpected(void)
+{
+	for (int i = 1; i < nexpected; i++) {
+		expect_t e = expected[i];
+		int j = i;
+
+		for (; j > 0 && expected[j - 1].from > e.from; j--) {
+			expected[j] = expected[j - 1];
+		}
+		expected[j] = e;
+	}
+}
+
+// Events came in the order and windows expected, nothing extra
+static void check(void)
+{
+	int n = nseen < nexpected ? nseen : nexpected;
+
+	CHECK(nseen == nexpected, "%d events, %d expected", nseen, nexpected);
+	for (int i = 0; i < n; i++) {
+		const expect_t *e = &expected[i];
+		const seen_t *s = &seen[i];
+		uint64_t settled = e->to - KEYPAD_DEBOUNCE_MS * 1000 - KEYPAD_SCAN_US;
+
+		CHECK(s->event == e->event, "event %d is %c%s, expected %c%s", i, s->event & ~KEYPAD_RELEASED,
+			(s->event & KEYPAD_RELEASED) ? " up" : " down", e->event & ~KEYPAD_RELEASED,
+			(e->event & KEYPAD_RELEASED) ? " up" : " down");
+		CHECK(s->at >= e->from && s->at <= e->to, "event %d at %llu us, expected %llu to %llu", i,
+			(unsigned long long)s->at, (unsigned long long)e->from, (unsigned long long)e->to);
+		if (s->at > settled) {
+			latency += s->at - settled;
+			if (s->at - settled > worst) {
+				worst = s->at - settled;
+			}
+		}
+	}
+}
+
+int main(void)
+{
+	sim_reset();
+	trace_keys();
+	trace_noise(end + 100000);
+	trace_ghost(end + 100000);
+	sortexpected();
+	sim_run(scanner);
+
+	check();
+	CHECK(keypad_busy() == false, "still scanning with every key up");
+	CHECK(keypad_stats()->ghosts > 0, "no scan seen as a possible ghost");
+	CHECK(keypad_stats()->dropped == 0, "%u events dropped", (unsigned)keypad_stats()->dropped);
+	printf("%d events, settled to event average %llu us, worst %llu us, window %u ms over %u scans\n",
+		nseen, (unsigned long long)(nseen > 0 ? latency / (uint64_t)nseen : 0), (unsigned long long)worst,
+		(unsigned)KEYPAD_DEBOUNCE_MS, (unsigned)KEYPAD_SAMPLES);
+	printf("%s\n", failures == 0 ? "keypad tests passed" : "keypad tests FAILED");
+	return failures == 0 ? 0 : 1;
+}
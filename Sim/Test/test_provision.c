@@ -0,0 +1,542 @@
+/**
+  ******************************************************************************
+  * @file           : test_provision.c
+  * @brief          : Host test of the binary provisioning protocol in
+  *                   Core/Src/provision.c.
+  *                   Plays the host end against the real decoder, store and
+  *                   journal on the simulator's flash model, with its own
+  *                   COBS coder and a bit-at-a-time CRC-16 so the lock's
+  *                   table-driven one is checked against the definition.
+  *                   Frames carrying zero bytes must come through intact
+  *                   both ways, a flipped bit, a short frame or one too long
+  *                   for the buffer must be dropped with a NAK and store
+  *                   nothing, a lost frame must get one NAK however many
+  *                   follow it and store everything once the window goes
+  *                   back, a window sent again after its ACK must add
+  *                   nothing, an export must go back when NEXT repeats,
+  *                   thousands of codes imported as fast as the line allows
+  *                   must never overflow the journal queue, and a session
+  *                   without an admin login must be denied.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "journal.h"
+#include "provision.h"
+
+#define BULK 2000 // Codes the flow control test imports
+#define REPLIES 64
+
+static int failures;
+static codestore_t store, back;
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while (0)
+
+typedef struct {
+	uint8_t type, seq;
+	uint8_t payload[PROVISION_PAYLOAD];
+	uint16_t len;
+} frame_t;
+
+static frame_t replies[REPLIES]; // Good frames from the lock since the last collect()
+static int nreplies, garbled;
+
+// CRC-16/CCITT-FALSE a bit at a time
+static uint16_t crc16(const uint8_t *data, size_t len)
+{
+	uint16_t crc = 0xFFFF;
+
+	while (len-- > 0) {
+		crc ^= (uint16_t)(*data++ << 8);
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+// COBS encodes raw into out and adds the delimiter, returns the length
+static size_t cobs(const uint8_t *raw, size_t n, uint8_t *out)
+{
+	size_t code = 0, pos = 1;
+
+	for (size_t i = 0; i < n; i++) {
+		if (raw[i] == 0) {
+			out[code] = (uint8_t)(pos - code);
+			code = pos++;
+			continue;
+		}
+		out[pos++] = raw[i];
+		if (pos - code == 0xFF) {
+			out[code] = 0xFF;
+			code = pos++;
+		}
+	}
+	out[code] = (uint8_t)(pos - code);
+	out[pos++] = 0;
+	return pos;
+}
+
+// Hands bytes to the decoder as the console does, up to a frame at a time
+static void deliver(const uint8_t *data, size_t len)
+{
+	while (len > 0) {
+		uint32_t used = provision_take(data, (uint32_t)len);
+
+		CHECK(used > 0, "session ended with %u bytes left", (unsigned)len);
+		if (used == 0) {
+			return;
+		}
+		data += used;
+		len -= used;
+	}
+}
+
+// Frames type, seq and payload with its CRC, flipping one bit first if bit
+// is not negative, and sends it
+static void send(uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len, int bit)
+{
+	uint8_t raw[2 + PROVISION_PAYLOAD + 2], out[PROVISION_FRAME + 8];
+	uint16_t crc;
+	size_t n = 2 + len;
+
+	raw[0] = type;
+	raw[1] = seq;
+	memcpy(&raw[2], payload, len);
+	crc = crc16(raw, n);
+	raw[n++] = (uint8_t)(crc >> 8);
+	raw[n++] = (uint8_t)crc;
+	if (bit >= 0) {
+		raw[bit / 8] ^= (uint8_t)(1 << bit % 8);
+	}
+	deliver(out, cobs(raw, n, out));
+}
+
+// Decodes one delimited chunk from the lock, false if it is not a good frame
+static bool decode(const uint8_t *in, size_t len, frame_t *f)
+{
+	uint8_t raw[2 + PROVISION_PAYLOAD + 2];
+	size_t n = 0, i = 0;
+
+	while (i < len) {
+		uint8_t code = in[i++];
+
+		if (code == 0 || i + code - 1 > len || n + code > sizeof(raw)) {
+			return false;
+		}
+		for (uint8_t k = 1; k < code; k++) {
+			raw[n++] = in[i++];
+		}
+		if (code != 0xFF && i < len) {
+			raw[n++] = 0;
+		}
+	}
+	if (n < 4 || crc16(raw, n) != 0) {
+		return false;
+	}
+	f->type = raw[0];
+	f->seq = raw[1];
+	f->len = (uint16_t)(n - 4);
+	memcpy(f->payload, &raw[2], f->len);
+	return true;
+}
+
+// Takes everything the lock has to send and decodes it into replies
+static void collect(void)
+{
+	static uint8_t out[4096];
+	uint16_t len = provision_send(out, sizeof(out));
+	size_t from = 0;
+
+	nreplies = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (out[i] != 0) {
+			continue;
+		}
+		CHECK(nreplies < REPLIES, "more than %d replies at once", REPLIES);
+		if (nreplies < REPLIES && decode(&out[from], i - from, &replies[nreplies]) == true) {
+			nreplies++;
+		} else {
+			garbled++;
+		}
+		from = i + 1;
+	}
+	CHECK(from == len, "reply cut short");
+}
+
+// Runs the flash until the journal is idle, as the main loop would
+static void settle(void)
+{
+	while (journal_busy()) {
+		if (journal_ready()) {
+			journal_poll();
+		} else {
+			sim_wfi();
+		}
+	}
+}
+
+// Lets the journal write everything, then collects the replies
+static void drain(void)
+{
+	settle();
+	collect();
+}
+
+// The only reply is type with seq
+static bool answered(uint8_t type, uint8_t seq)
+{
+	return nreplies == 1 && replies[0].type == type && replies[0].seq == seq;
+}
+
+// BCD packs a code as the wire format has it, returns its size
+static uint16_t pack(const char *code, uint8_t *out)
+{
+	uint16_t digits = (uint16_t)strlen(code);
+
+	out[0] = (uint8_t)digits;
+	for (uint16_t i = 0; i < digits; i += 2) {
+		out[1 + i / 2] = (uint8_t)((code[i] - '0') << 4 | (i + 1 < digits ? code[i + 1] - '0' : 0x0F));
+	}
+	return 1 + (digits + 1) / 2;
+}
+
+// Packs n codes into one payload
+static uint16_t payload(const char *const *codes, int n, uint8_t *out)
+{
+	uint16_t len = 0;
+
+	for (int i = 0; i < n; i++) {
+		len += pack(codes[i], &out[len]);
+	}
+	return len;
+}
+
+// Code number n, 4 to 10 digits long depending on n
+static void codeof(int n, char *code)
+{
+	snprintf(code, CODESTORE_MAX + 1, "%0*d", CODESTORE_MIN + n % (CODESTORE_MAX - CODESTORE_MIN + 1), n);
+}
+
+// Blank flash, an empty store and a session opened with OPEN
+static void session(void)
+{
+	sim_flash_wipe();
+	sim_reset();
+	journal_mount(&store);
+	provision_init(&store);
+	provision_start(true);
+	deliver((const uint8_t *)"", 1); // A stray delimiter is an empty frame, ignored
+	send(PROVISION_OPEN, 0, NULL, 0, -1);
+	collect();
+	CHECK(answered(PROVISION_READY, 0) && replies[0].len == 6, "no READY to OPEN");
+}
+
+// Codes with zero bytes packed come through the COBS and CRC on both sides,
+// and codes that cannot be stored are counted as skipped
+static void test_framing(void)
+{
+	static const char *const codes[] = {"1000", "0000", "100000", "00000", "2008001", "0101010101"};
+	const provision_stats_t *stats = provision_stats();
+	uint8_t data[PROVISION_PAYLOAD];
+	uint16_t len;
+
+	session();
+	CHECK(replies[0].payload[0] == PROVISION_WINDOW && replies[0].payload[1] == PROVISION_PAYLOAD &&
+		(replies[0].payload[4] | replies[0].payload[5] << 8) == CODESTORE_CAPACITY, "READY fields wrong");
+	len = payload(codes, 6, data);
+	send(PROVISION_IMPORT, 0, data, len, -1);
+	collect();
+	CHECK(nreplies == 0, "ACK sent before the journal wrote the codes");
+	drain();
+	CHECK(answered(PROVISION_ACK, 1) && replies[0].payload[0] == 6 && replies[0].payload[1] == 0 &&
+		replies[0].payload[2] == 6, "6 codes with zero bytes not all added");
+	for (int i = 0; i < 6; i++) {
+		CHECK(codestore_contains(&store, codes[i]), "%s missing", codes[i]);
+	}
+
+	// Bad digits and a count cut short are skipped, as are codes past
+	// PROVISION_CODES
+	memset(data, 0, sizeof(data));
+	data[0] = 4; // "0000" again, already stored, so neither added nor skipped
+	data[3] = 4;
+	data[4] = 0x1A; // Not a digit
+	data[5] = 0x11;
+	len = 6;
+	for (int i = 0; i < PROVISION_CODES; i++) {
+		char code[CODESTORE_MAX + 1];
+
+		codeof(7000 + i, code);
+		len += pack(code, &data[len]);
+	}
+	data[len++] = 9; // 9 digits with one byte of them
+	data[len++] = 0x99;
+	send(PROVISION_IMPORT, 1, data, len, -1);
+	drain();
+	CHECK(answered(PROVISION_ACK, 2) && replies[0].payload[0] == PROVISION_CODES - 2 &&
+		replies[0].payload[1] == 1 + 2 + 1, "added %u and skipped %u, expected %u and 4",
+		replies[0].payload[0], replies[0].payload[1], PROVISION_CODES - 2);
+	CHECK(stats->imported == 6 + PROVISION_CODES - 2, "%u codes imported", (unsigned)stats->imported);
+
+	// SYNC once the journal is idle, and the codes are in flash
+	send(PROVISION_SYNC, 0, NULL, 0, -1);
+	drain();
+	CHECK(answered(PROVISION_SYNCED, 0) && (replies[0].payload[0] | replies[0].payload[1] << 8) ==
+		codestore_total(&store), "no SYNCED with the total");
+	send(PROVISION_CLOSE, 0, NULL, 0, -1);
+	collect();
+	CHECK(answered(PROVISION_CLOSED, 0) && provision_active() == false, "CLOSE did not end the session");
+	sim_reset();
+	CHECK(journal_mount(&back) && back.total == store.total, "%u codes after remount, %u before",
+		codestore_total(&back), codestore_total(&store));
+
+	// Without an admin login OPEN is denied and IMPORT stores nothing
+	provision_start(false);
+	send(PROVISION_OPEN, 0, NULL, 0, -1);
+	collect();
+	CHECK(answered(PROVISION_DENIED, 0), "OPEN without a login not denied");
+	codestore_remove(&store, codes[0]);
+	len = payload(codes, 1, data);
+	send(PROVISION_IMPORT, 0, data, len, -1);
+	drain();
+	CHECK(nreplies == 0 && codestore_contains(&store, codes[0]) == false, "IMPORT taken without a login");
+	send(PROVISION_CLOSE, 0, NULL, 0, -1);
+	collect();
+	CHECK(answered(PROVISION_CLOSED, 0) && provision_active() == false, "CLOSE without a login ignored");
+	CHECK(garbled == 0, "%d replies failed their CRC", garbled);
+}
+
+// A flipped bit in any byte, a frame shorter than its header and CRC, and
+// one too long for the buffer are dropped with one NAK, storing nothing
+static void test_crc(void)
+{
+	static const char *const codes[] = {"4321", "87654321"};
+	const provision_stats_t *stats = provision_stats();
+	uint8_t data[PROVISION_PAYLOAD], toolong[2 * 0xFF + 2];
+	uint16_t len;
+	uint32_t bad = stats->bad, naks;
+
+	session();
+	len = payload(codes, 2, data);
+	for (int bit = 0; bit < (2 + len + 2) * 8; bit += 5) {
+		send(PROVISION_IMPORT, 0, data, len, bit);
+		drain();
+		CHECK(bit == 0 ? answered(PROVISION_NAK, 0) : nreplies == 0, "bit %d: %d replies", bit, nreplies);
+	}
+	CHECK(codestore_total(&store) == 0, "%u codes stored from damaged frames", codestore_total(&store));
+	CHECK(stats->bad - bad == (uint32_t)((2 + len + 2) * 8 + 4) / 5, "%u frames dropped",
+		(unsigned)(stats->bad - bad));
+
+	naks = stats->naks;
+	send(PROVISION_IMPORT, 0, data, len, -1);
+	drain();
+	CHECK(answered(PROVISION_ACK, 1), "good frame after damaged ones not taken");
+	deliver((const uint8_t *)"\x02\x02\x01\x00", 4); // Type and seq with no CRC
+	drain();
+	CHECK(answered(PROVISION_NAK, 1), "short frame not NAKed");
+	memset(toolong, 0x5A, sizeof(toolong));
+	toolong[0] = 0xFF; // Two full COBS blocks, no zero in them, past the frame buffer
+	toolong[0xFF] = 0xFF;
+	toolong[2 * 0xFF] = 1;
+	toolong[2 * 0xFF + 1] = 0;
+	send(PROVISION_IMPORT, 1, (const uint8_t *)"", 0, -1); // Answered first, so the next NAK is new
+	drain();
+	deliver(toolong, sizeof(toolong));
+	drain();
+	CHECK(answered(PROVISION_NAK, 2), "frame past the buffer not NAKed");
+	CHECK(stats->naks - naks == 2 && codestore_total(&store) == 2, "%u NAKs, %u codes",
+		(unsigned)(stats->naks - naks), codestore_total(&store));
+}
+
+// Frame 1 of 4 lost: one NAK for it however many come after, then the
+// window from it again stores everything. Sent once more after its ACK,
+// the window is answered but adds nothing and writes no flash.
+static void test_gap(void)
+{
+	uint8_t data[4][PROVISION_PAYLOAD];
+	uint16_t len[4];
+	char codes[4][PROVISION_CODES][CODESTORE_MAX + 1];
+	const char *list[PROVISION_CODES];
+	uint64_t programs;
+
+	session();
+	for (int f = 0; f < 4; f++) {
+		for (int i = 0; i < PROVISION_CODES; i++) {
+			codeof(100 + f * PROVISION_CODES + i, codes[f][i]);
+			list[i] = codes[f][i];
+		}
+		len[f] = payload(list, PROVISION_CODES, data[f]);
+	}
+	send(PROVISION_IMPORT, 0, data[0], len[0], -1);
+	send(PROVISION_IMPORT, 2, data[2], len[2], -1);
+	send(PROVISION_IMPORT, 3, data[3], len[3], -1);
+	collect();
+	CHECK(nreplies == 0, "ACK or NAK before frame 0 was written");
+	drain();
+	CHECK(nreplies == 2 && replies[0].type == PROVISION_ACK && replies[0].seq == 1 &&
+		replies[1].type == PROVISION_NAK && replies[1].seq == 1, "expected ACK 1 and one NAK 1, got %d replies",
+		nreplies);
+	for (int f = 1; f < 4; f++) {
+		send(PROVISION_IMPORT, (uint8_t)f, data[f], len[f], -1);
+	}
+	drain();
+	CHECK(answered(PROVISION_ACK, 4) && replies[0].payload[0] == 3 * PROVISION_CODES,
+		"window sent again not ACKed with its codes");
+	CHECK(codestore_total(&store) == 4 * PROVISION_CODES, "%u codes stored", codestore_total(&store));
+
+	programs = sim_flash_programs();
+	for (int f = 0; f < 4; f++) {
+		send(PROVISION_IMPORT, (uint8_t)f, data[f], len[f], -1);
+	}
+	drain();
+	CHECK(answered(PROVISION_ACK, 4) && replies[0].payload[0] == 0 && replies[0].payload[1] == 0,
+		"window replayed after its ACK changed something");
+	CHECK(sim_flash_programs() == programs && codestore_total(&store) == 4 * PROVISION_CODES,
+		"replay wrote %llu double-words", (unsigned long long)(sim_flash_programs() - programs));
+}
+
+// Thousands of codes, go-back-N with the window full as long as there are
+// ACKs, each frame taken the moment it is sent: the journal never drops a
+// change to catch up with a snapshot, and the codes survive a remount
+static void test_flow(void)
+{
+	static char codes[BULK][CODESTORE_MAX + 1];
+	static uint8_t data[BULK][PROVISION_PAYLOAD];
+	static uint16_t len[BULK];
+	const journal_stats_t *journal = journal_stats();
+	const char *list[PROVISION_CODES];
+	unsigned frames = 0, base = 0, next = 0, added = 0, idle = 0;
+	uint32_t overflows, compactions, records;
+
+	session();
+	for (int c = 0; c < BULK; c += PROVISION_CODES) {
+		int n = BULK - c < PROVISION_CODES ? BULK - c : PROVISION_CODES;
+
+		for (int i = 0; i < n; i++) {
+			codeof(c + i, codes[c + i]);
+			list[i] = codes[c + i];
+		}
+		len[frames] = payload(list, n, data[frames]);
+		frames++;
+	}
+	overflows = journal->overflows;
+	compactions = journal->compactions;
+	records = journal->records;
+	while (base < frames && idle < 8) {
+		while (next < frames && next - base < PROVISION_WINDOW) {
+			send(PROVISION_IMPORT, (uint8_t)next, data[next], len[next], -1);
+			next++;
+		}
+		collect();
+		if (nreplies == 0) {
+			idle += journal_busy() == false; // Nothing due, so nothing will come
+			if (journal_ready()) {
+				journal_poll();
+			} else if (journal_busy()) {
+				sim_wfi();
+			}
+			continue;
+		}
+		for (int r = 0; r < nreplies; r++) {
+			unsigned acked = (uint8_t)(replies[r].seq - (uint8_t)base);
+
+			CHECK(replies[r].type == PROVISION_ACK && acked <= next - base, "reply %02X seq %u at base %u",
+				replies[r].type, replies[r].seq, base);
+			added += replies[r].payload[0];
+			base += acked;
+		}
+	}
+	CHECK(base == frames && added == BULK, "%u of %u frames ACKed, %u codes added", base, frames, added);
+	CHECK(journal->overflows == overflows && journal->compactions - compactions <= 1,
+		"%u overflows and %u compactions for %d codes", (unsigned)(journal->overflows - overflows),
+		(unsigned)(journal->compactions - compactions), BULK);
+	CHECK(journal->records - records >= BULK + frames, "%u records for %d codes in %u frames",
+		(unsigned)(journal->records - records), BULK, frames);
+	sim_reset();
+	CHECK(journal_mount(&back) && back.total == BULK, "%u codes after remount", codestore_total(&back));
+	printf("%d codes in %u frames: %u records, %u compactions, deepest queue %u of %d\n", BULK, frames,
+		(unsigned)(journal->records - records), (unsigned)(journal->compactions - compactions),
+		(unsigned)journal->depth, JOURNAL_QUEUE);
+}
+
+// Export: DATA up to the window ahead of NEXT, a repeated NEXT goes back to
+// the frame the host lacks, and every stored code comes out once
+static void test_export(void)
+{
+	static char codes[300][CODESTORE_MAX + 1];
+	static uint8_t seen[300];
+	const provision_stats_t *stats = provision_stats();
+	uint32_t rewinds;
+	uint8_t expect = 0;
+	int count = 0, ended = -1, resent = 0;
+
+	session();
+	for (int i = 0; i < 300; i++) {
+		codeof(5000 + i, codes[i]);
+		codestore_add(&store, codes[i]);
+	}
+	rewinds = stats->rewinds;
+	send(PROVISION_EXPORT, 0, NULL, 0, -1);
+	for (int round = 0; round < 64 && ended < 0; round++) {
+		collect();
+		CHECK(nreplies <= PROVISION_WINDOW, "%d frames past the window", nreplies);
+		for (int r = 0; r < nreplies; r++) {
+			frame_t *f = &replies[r];
+			char code[CODESTORE_MAX + 1];
+
+			if (f->seq != expect) {
+				continue; // After a lost one, dropped until it comes again
+			}
+			if (round == 1 && r == 1 && resent++ == 0) {
+				continue; // Lost once
+			}
+			expect++;
+			if (f->type == PROVISION_END) {
+				ended = f->payload[0] | f->payload[1] << 8;
+				break;
+			}
+			for (uint16_t at = 0; at < f->len; at += 1 + (f->payload[at] + 1) / 2) {
+				uint8_t digits = f->payload[at];
+
+				for (uint8_t d = 0; d < digits; d++) {
+					uint8_t b = f->payload[at + 1 + d / 2];
+
+					code[d] = (char)('0' + ((d & 1) ? b & 15 : b >> 4));
+				}
+				code[digits] = '\0';
+				for (int i = 0; i < 300; i++) {
+					if (strcmp(codes[i], code) == 0) {
+						seen[i]++;
+					}
+				}
+				count++;
+			}
+		}
+		send(PROVISION_NEXT, expect, NULL, 0, -1);
+	}
+	CHECK(ended == 300 && count == 300, "END said %d, %d codes came", ended, count);
+	for (int i = 0; i < 300; i++) {
+		CHECK(seen[i] == 1, "%s came %u times", codes[i], seen[i]);
+	}
+	CHECK(stats->rewinds - rewinds == 1, "%u rewinds for one lost frame", (unsigned)(stats->rewinds - rewinds));
+}
+
+int main(void)
+{
+	test_framing();
+	test_crc();
+	test_gap();
+	test_flow();
+	test_export();
+	printf("%s\n", failures == 0 ? "provision tests passed" : "provision tests FAILED");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+/**
+  ******************************************************************************
+  * @file           : test_swtimer.c
+  * @brief          : Host test of the software timer wheel in
+  *                   Core/Src/swtimer.c.
+  *                   Runs the real wheel off the simulator's SysTick, one
+  *                   virtual millisecond at a time, and logs the tick each
+  *                   callback fires on. One-shots must fire once on the
+  *                   tick asked for, periodic timers on every period after
+  *                   it, and timers several turns of the wheel away, or
+  *                   sharing a slot with nearer ones, only on their own
+  *                   turn. A timer stopped by another's callback on the
+  *                   tick both are due must not fire, a callback may
+  *                   restart itself, ticks missed in Stop 2 must fire what
+  *                   fell due on the way in order, and all of it must hold
+  *                   across the 32-bit tick counter wrapping.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "swtimer.h"
+
+#define TIMERS 6
+#define FIRES 256
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(__VA_ARGS__); \
+		printf("\n"); \
+		failures++; \
+	} \
+} while (0)
+
+typedef struct {
+	int timer;
+	uint32_t tick;
+} fire_t;
+
+static int ids[TIMERS];
+static fire_t fires[FIRES];
+static int nfires;
+static int victim = -1; // Timer the next firing of timer 0 stops, -1 for none
+static int again; // Times timer 1 restarts itself from its callback
+
+// Logs each firing with the tick it came on
+static void fired(void *arg)
+{
+	int timer = (int)(intptr_t)arg;
+
+	if (nfires < FIRES) {
+		fires[nfires++] = (fire_t){timer, swtimer_ticks()};
+	}
+	if (timer == 0 && victim >= 0) {
+		swtimer_stop(ids[victim]);
+		victim = -1;
+	}
+	if (timer == 1 && again > 0) {
+		again--;
+		swtimer_start(ids[1], 3, 0);
+	}
+}
+
+// Runs the wheel for ms of SysTick
+static void run(uint32_t ms)
+{
+	sim_advance_to(sim_now() + SIM_MS(ms));
+}
+
+// Starts a test from an empty log, every timer stopped
+static uint32_t begin(void)
+{
+	for (int i = 0; i < TIMERS; i++) {
+		swtimer_stop(ids[i]);
+	}
+	nfires = 0;
+	return swtimer_ticks();
+}
+
+// The log must hold exactly these firings, ticks from start
+static void expect(const char *name, uint32_t start, const fire_t *want, int n)
+{
+	CHECK(nfires == n, "%s: %d firings, expected %d", name, nfires, n);
+	for (int i = 0; i < n && i < nfires; i++) {
+		CHECK(fires[i].timer == want[i].timer && fires[i].tick - start == want[i].tick,
+			"%s: firing %d was timer %d at +%lu, expected timer %d at +%lu", name, i, fires[i].timer,
+			(unsigned long)(fires[i].tick - start), want[i].timer, (unsigned long)want[i].tick);
+	}
+}
+
+static void test_oneshot(void)
+{
+	uint32_t start = begin();
+	static const fire_t want[] = {{0, 1}, {2, 10}};
+
+	swtimer_start(ids[0], 0, 0); // 0 still waits for the next tick
+	swtimer_start(ids[2], 10, 0);
+	CHECK(swtimer_next() == 1, "next due in %lu ticks, expected 1", (unsigned long)swtimer_next());
+	run(50);
+	expect("one-shot", start, want, 2);
+	CHECK(swtimer_active(ids[0]) == false && swtimer_active(ids[2]) == false, "one-shot still active");
+	CHECK(swtimer_next() == SWTIMER_NONE, "next due with nothing running");
+}
+
+static void test_periodic(void)
+{
+	uint32_t start = begin();
+	fire_t want[8];
+
+	for (int i = 0; i < 8; i++) {
+		want[i] = (fire_t){2, 5 + 7 * (uint32_t)i};
+	}
+	swtimer_start(ids[2], 5, 7);
+	run(5 + 7 * 7);
+	expect("periodic", start, want, 8);
+	CHECK(swtimer_active(ids[2]) == true, "periodic timer stopped by itself");
+	swtimer_stop(ids[2]);
+	run(30);
+	CHECK(nfires == 8, "periodic timer fired after it was stopped");
+}
+
+// Timers due in the same slot on different turns, one a whole turn away in
+// the slot being ticked, and one several turns away, fire only on their own
+static void test_turns(void)
+{
+	uint32_t start = begin();
+	static const fire_t want[] = {
+		{2, 9}, {4, SWTIMER_SLOTS}, {3, 9 + SWTIMER_SLOTS}, {5, 9 + 3 * SWTIMER_SLOTS}
+	};
+
+	swtimer_start(ids[5], 9 + 3 * SWTIMER_SLOTS, 0);
+	swtimer_start(ids[3], 9 + SWTIMER_SLOTS, 0);
+	swtimer_start(ids[2], 9, 0);
+	swtimer_start(ids[4], SWTIMER_SLOTS, 0);
+	run(9 + SWTIMER_SLOTS - 1);
+	CHECK(nfires == 2, "%d firings before the second turn reached slot 9, expected 2", nfires);
+	run(2 * SWTIMER_SLOTS + 20);
+	expect("turns", start, want, 4);
+}
+
+// Two due on one tick, the first stopping the second from its callback,
+// then a callback restarting its own timer
+static void test_cancel(void)
+{
+	uint32_t start = begin();
+	static const fire_t want[] = {{0, 20}, {1, 40}, {1, 43}, {1, 46}};
+
+	swtimer_start(ids[2], 20, 0); // Started first, so it is behind timer 0 in the slot list
+	swtimer_start(ids[0], 20, 0);
+	victim = 2;
+	run(30);
+	CHECK(swtimer_active(ids[2]) == false, "stopped timer still active");
+	again = 2;
+	swtimer_start(ids[1], 10, 0);
+	run(30);
+	expect("cancel and restart", start, want, 4);
+	CHECK(victim == -1 && again == 0, "callbacks did not run as set up");
+}
+
+// Ticks missed with SysTick stopped, as after Stop 2
+static void test_advance(void)
+{
+	uint32_t start = begin();
+	static const fire_t want[] = {{2, 4}, {0, 10}, {3, 100}, {0, 110}, {0, 210}, {0, 310}, {0, 410}};
+
+	swtimer_start(ids[3], 100, 0);
+	swtimer_start(ids[2], 4, 0);
+	__disable_irq();
+	swtimer_advance(4 + 5);
+	CHECK(nfires == 1 && swtimer_ticks() - start == 4 + 5, "%d firings, %lu ticks after advancing 9",
+		nfires, (unsigned long)(swtimer_ticks() - start));
+	swtimer_start(ids[0], 1, 100);
+	swtimer_advance(500);
+	__enable_irq();
+	expect("advance", start, want, 7);
+	CHECK(swtimer_ticks() - start == 4 + 5 + 500, "%lu ticks after advancing 509",
+		(unsigned long)(swtimer_ticks() - start));
+	swtimer_stop(ids[0]);
+}
+
+int main(void)
+{
+	sim_reset();
+	HAL_Init();
+	(void)SysTick->CTRL; // The model takes in register writes on the next access
+	for (int i = 0; i < TIMERS; i++) {
+		ids[i] = swtimer_create(fired, (void *)(intptr_t)i);
+		CHECK(ids[i] >= 0, "pool ran out at timer %d", i);
+	}
+
+	test_oneshot();
+	test_periodic();
+	test_turns();
+	test_cancel();
+	test_advance();
+
+	// The same again with the tick counter about to wrap
+	__disable_irq();
+	swtimer_advance(UINT32_MAX - swtimer_ticks() - 2 * SWTIMER_SLOTS);
+	__enable_irq();
+	test_oneshot();
+	test_periodic();
+	test_turns();
+	test_cancel();
+	test_advance();
+	CHECK(swtimer_ticks() < 2000, "tick counter at %lu, never wrapped",
+		(unsigned long)swtimer_ticks());
+
+	printf("%d timers, tick counter wrapped to %lu\n", TIMERS, (unsigned long)swtimer_ticks());
+	printf("%s\n", failures == 0 ? "swtimer tests passed" : "swtimer tests FAILED");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+/**
+  ******************************************************************************
+  * @file           : lcd_streams.c
+  * @brief          : Build step that writes Core/Src/lcd_screens.c from the
+  *                   static screens listed in Core/Inc/lcd_screens.h.
+  *                   Each screen becomes the exact shift register bytes
+  *                   lcd.c would send to write every visible cell, blanks
+  *                   included, over whatever was shown: the address of
+  *                   each line, then its LCD_WIDTH cells, each byte split
+  *                   into its nibbles with RS and EN and followed by the
+  *                   repeats covering its execution time, and the trailing
+  *                   slot DMA needs to finish. No clear, so a stream takes
+  *                   no longer than sending the cells that differ from a
+  *                   screen it replaces all of. The arrays are const, so they stay in
+  *                   flash and go to SPI1 by DMA as they are.
+  *                   Usage: lcd_streams [output.c], stdout by default.
+  ******************************************************************************
+  */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include "lcd.h"
+
+#define STREAM 4096
+
+typedef struct {
+	const char *name, *top, *bottom;
+} screen_t;
+
+static const screen_t screens[LCD_SCREENS] = {
+#define LCD_SCREEN_TEXT(name, top, bottom) {#name, top, bottom},
+	LCD_SCREEN_LIST(LCD_SCREEN_TEXT)
+#undef LCD_SCREEN_TEXT
+};
+
+static uint8_t stream[STREAM];
+static int length;
+
+// Appends one controller byte as the queue drain in lcd.c splits it
+static void put(uint8_t code, uint8_t rs)
+{
+	int hold = (rs == 0 && code <= 0x03) ? LCD_LONG_SLOTS : LCD_SHORT_SLOTS; // Clear and home take longer
+
+	stream[length++] = (code & 0xF0) | rs | 0x02; // EN high, then low to clock the nibble in
+	stream[length++] = (code & 0xF0) | rs;
+	stream[length++] = (uint8_t)(code << 4) | rs | 0x02;
+	stream[length++] = (uint8_t)(code << 4) | rs;
+	for (int i = 0; i < hold; i++) {
+		stream[length] = stream[length - 1];
+		length++;
+	}
+}
+
+// Builds one screen's stream, returning where it leaves the address counter
+static int build(const screen_t *screen)
+{
+	char cells[LCD_CELLS];
+	int at = 0;
+
+	memset(cells, ' ', sizeof(cells));
+	memcpy(cells, screen->top, strlen(screen->top));
+	if (screen->bottom != NULL) {
+		memcpy(&cells[LCD_LINE], screen->bottom, strlen(screen->bottom));
+	}
+
+	length = 0;
+	for (int line = 0; line < 2; line++) {
+		put(0x80 | (line * 0x40), 0);
+		for (int i = line * LCD_LINE; i < line * LCD_LINE + LCD_WIDTH; i++) {
+			put((uint8_t)cells[i], 1);
+		}
+		at = line * LCD_LINE + LCD_WIDTH;
+	}
+	stream[length] = stream[length - 1];
+	length++;
+	return at;
+}
+
+// Array name for a screen, its enum name in lower case
+static void arrayname(const screen_t *screen, char *out, size_t size)
+{
+	size_t i;
+
+	for (i = 0; screen->name[i] != '\0' && i + 1 < size; i++) {
+		out[i] = (char)tolower((unsigned char)screen->name[i]);
+	}
+	out[i] = '\0';
+}
+
+// Text as a C string literal, or NULL
+static void literal(FILE *out, const char *text)
+{
+	if (text == NULL) {
+		fprintf(out, "NULL");
+		return;
+	}
+	fputc('"', out);
+	for (; *text != '\0'; text++) {
+		if (*text == '"' || *text == '\\') {
+			fputc('\\', out);
+		}
+		fputc(*text, out);
+	}
+	fputc('"', out);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *out = argc > 1 ? fopen(argv[1], "w") : stdout;
+	int address[LCD_SCREENS], total = 0;
+	char name[64];
+
+	if (out == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	fprintf(out, "/**\n"
+		"  ******************************************************************************\n"
+		"  * @file           : lcd_screens.c\n"
+		"  * @brief          : Shift register streams for the static screens listed\n"
+		"  *                   in lcd_screens.h. Generated by Tools/lcd_streams.c,\n"
+		"  *                   do not edit.\n"
+		"  ******************************************************************************\n"
+		"  */\n\n"
+		"#include \"lcd_screens.h\"\n");
+
+	for (int s = 0; s < LCD_SCREENS; s++) {
+		address[s] = build(&screens[s]);
+		total += length;
+		arrayname(&screens[s], name, sizeof(name));
+		fprintf(out, "\n// ");
+		literal(out, screens[s].top);
+		fprintf(out, ", ");
+		literal(out, screens[s].bottom);
+		fprintf(out, ", %d bytes\nstatic const uint8_t %s[] = {", length, name);
+		for (int i = 0; i < length; i++) {
+			fprintf(out, "%s0x%02X%s", i % 16 == 0 ? "\n\t" : "", stream[i], i + 1 < length ? (i % 16 == 15 ? "," : ", ") : "\n");
+		}
+		fprintf(out, "};\n");
+	}
+
+	fprintf(out, "\nconst lcd_screen_t lcd_screens[LCD_SCREENS] = {\n");
+	for (int s = 0; s < LCD_SCREENS; s++) {
+		arrayname(&screens[s], name, sizeof(name));
+		fprintf(out, "\t{");
+		literal(out, screens[s].top);
+		fprintf(out, ", ");
+		literal(out, screens[s].bottom);
+		fprintf(out, ", %s, sizeof(%s), %d},\n", name, name, address[s]);
+	}
+	fprintf(out, "};\n");
+
+	if (out != stdout && fclose(out) != 0) {
+		perror(argv[1]);
+		return 1;
+	}
+	fprintf(stderr, "%d screens, %d bytes\n", LCD_SCREENS, total);
+	return 0;
+}
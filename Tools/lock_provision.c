@@ -0,0 +1,542 @@
+/**
+  ******************************************************************************
+  * @file           : lock_provision.c
+  * @brief          : Linux host tool for bulk code import and export over
+  *                   the lock's console UART, speaking the binary protocol
+  *                   in Core/Inc/provision.h.
+  *                   It logs in on the console with the admin code first,
+  *                   as the lock refuses a session without one.
+  *                   Import reads codes one per line and keeps a window of
+  *                   IMPORT frames in flight, going back to the first frame
+  *                   not acknowledged after a NAK or a timeout, then waits
+  *                   until the lock has journaled everything. Export writes
+  *                   the lock's codes one per line, acknowledging each DATA
+  *                   frame as it arrives. Both report the bytes moved
+  *                   against what the line could carry.
+  *                   Works on a USB serial adapter, the ST-LINK virtual COM
+  *                   port or the simulator's pty (digital_lock_sim -u).
+  ******************************************************************************
+  */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "provision.h"
+
+#define TIMEOUT_MS 500 // No reply for this long, the window goes out again
+#define SYNC_MS 5000 // The journal may be compacting, which takes a while
+#define TRIES 8 // Timeouts in a row before giving up
+#define LOGIN_MS 1000 // For the console to answer the login line
+#define MAXCODES 65536
+
+typedef struct {
+	uint8_t type, seq;
+	uint8_t payload[PROVISION_PAYLOAD];
+	uint16_t len;
+} frame_t;
+
+static int fd = -1;
+static unsigned baud = 115200;
+static unsigned window = PROVISION_WINDOW;
+static const char *admin = "2580"; // The lock's ADMIN code as built
+static uint64_t sent, received; // Bytes on the line, delimiters included
+static unsigned resends, timeouts;
+
+static uint16_t crc16(const uint8_t *data, size_t len)
+{
+	uint16_t crc = 0xFFFF;
+
+	while (len-- > 0) {
+		crc ^= (uint16_t)(*data++ << 8);
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static speed_t speedof(unsigned rate)
+{
+	switch (rate) {
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 230400: return B230400;
+		case 460800: return B460800;
+		case 921600: return B921600;
+		default: return B115200;
+	}
+}
+
+// Raw 8N1 at the chosen rate; a pty takes the settings and ignores the rate
+static int openport(const char *path)
+{
+	struct termios tio;
+	int port = open(path, O_RDWR | O_NOCTTY);
+
+	if (port < 0) {
+		return -1;
+	}
+	if (tcgetattr(port, &tio) == 0) {
+		cfmakeraw(&tio);
+		cfsetspeed(&tio, speedof(baud));
+		tio.c_cflag |= CLOCAL | CREAD;
+		tcsetattr(port, TCSANOW, &tio);
+		tcflush(port, TCIOFLUSH);
+	}
+	return port;
+}
+
+static void writeall(const uint8_t *data, size_t len)
+{
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(fd, data, len);
+		if (n < 0 && errno != EINTR && errno != EAGAIN) {
+			perror("write");
+			exit(1);
+		}
+		if (n > 0) {
+			data += n;
+			len -= (size_t)n;
+			sent += (uint64_t)n;
+		}
+	}
+}
+
+// COBS encodes type, seq, payload and CRC, ended by a zero
+static void sendframe(uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len)
+{
+	uint8_t raw[2 + PROVISION_PAYLOAD + 2], out[PROVISION_FRAME + 1];
+	size_t n = 2 + len, code = 0, pos = 1;
+	uint16_t crc;
+
+	raw[0] = type;
+	raw[1] = seq;
+	if (len > 0) {
+		memcpy(&raw[2], payload, len);
+	}
+	crc = crc16(raw, n);
+	raw[n++] = (uint8_t)(crc >> 8);
+	raw[n++] = (uint8_t)crc;
+	for (size_t i = 0; i < n; i++) {
+		if (raw[i] == 0) {
+			out[code] = (uint8_t)(pos - code);
+			code = pos++;
+			continue;
+		}
+		out[pos++] = raw[i];
+		if (pos - code == 0xFF) {
+			out[code] = 0xFF;
+			code = pos++;
+		}
+	}
+	out[code] = (uint8_t)(pos - code);
+	out[pos++] = 0;
+	writeall(out, pos);
+}
+
+// Decodes one delimited chunk, false if it is not a good frame (console
+// text before the session, or damage on the line)
+static bool decode(const uint8_t *in, size_t len, frame_t *f)
+{
+	uint8_t raw[2 + PROVISION_PAYLOAD + 2];
+	size_t n = 0, i = 0;
+
+	while (i < len) {
+		uint8_t code = in[i++];
+
+		if (code == 0 || i + code - 1 > len) {
+			return false;
+		}
+		for (uint8_t k = 1; k < code; k++) {
+			if (n == sizeof(raw)) {
+				return false;
+			}
+			raw[n++] = in[i++];
+		}
+		if (code != 0xFF && i < len) {
+			if (n == sizeof(raw)) {
+				return false;
+			}
+			raw[n++] = 0;
+		}
+	}
+	if (n < 4 || crc16(raw, n) != 0) {
+		return false;
+	}
+	f->type = raw[0];
+	f->seq = raw[1];
+	f->len = (uint16_t)(n - 4);
+	memcpy(f->payload, &raw[2], f->len);
+	return true;
+}
+
+// Next good frame from the lock, false after timeout ms without one
+static bool readframe(frame_t *f, int timeout)
+{
+	static uint8_t chunk[1024];
+	static size_t have;
+	double until = now() + timeout / 1000.0;
+	struct pollfd p = {fd, POLLIN, 0};
+	uint8_t byte;
+
+	for (;;) {
+		int left = (int)((until - now()) * 1000);
+
+		if (left < 0 || poll(&p, 1, left) <= 0) {
+			return false;
+		}
+		if (read(fd, &byte, 1) != 1) {
+			continue;
+		}
+		received++;
+		if (byte != 0) {
+			if (have < sizeof(chunk)) {
+				chunk[have++] = byte;
+			}
+			continue;
+		}
+		if (have > 0 && decode(chunk, have, f)) {
+			have = 0;
+			return true;
+		}
+		have = 0;
+	}
+}
+
+// Waits for a reply of the given type, sending the request again on each
+// timeout
+static bool request(uint8_t type, uint8_t reply, frame_t *f, int timeout)
+{
+	for (int tries = 0; tries < TRIES; tries++) {
+		if (type == PROVISION_OPEN) {
+			writeall((const uint8_t *)"\0", 1); // Wakes the lock from Stop 2, that byte is lost
+			usleep(20000);
+			writeall((const uint8_t *)"\0", 1); // Starts the session, or ends junk before the frame
+		}
+		sendframe(type, 0, NULL, 0);
+		while (readframe(f, timeout)) {
+			if (f->type == reply) {
+				return true;
+			}
+			if (f->type == PROVISION_DENIED) {
+				fprintf(stderr, "lock refused the session, check the admin code (-a)\n");
+				exit(1);
+			}
+		}
+		timeouts++;
+	}
+	return false;
+}
+
+// Logs in on the console, waking the lock with a CR first since the byte
+// that wakes it from Stop 2 is lost. False if it never said logged in.
+static bool login(void)
+{
+	char line[64], reply[256];
+	size_t have = 0;
+	struct pollfd p = {fd, POLLIN, 0};
+	double until;
+
+	writeall((const uint8_t *)"\r", 1);
+	usleep(20000);
+	snprintf(line, sizeof(line), "\rlogin %s\r", admin);
+	writeall((const uint8_t *)line, strlen(line));
+	until = now() + LOGIN_MS / 1000.0;
+	while (now() < until && poll(&p, 1, LOGIN_MS) > 0 && have + 1 < sizeof(reply)) {
+		ssize_t n = read(fd, reply + have, sizeof(reply) - 1 - have);
+
+		if (n <= 0) {
+			continue;
+		}
+		received += (uint64_t)n;
+		have += (size_t)n;
+		reply[have] = '\0';
+		if (strstr(reply, "logged in\r\n> ") != NULL) { // The prompt too, so no text is left ahead of READY
+			return true;
+		}
+		if (strstr(reply, "wrong code") != NULL) {
+			break;
+		}
+	}
+	fprintf(stderr, "console login failed, check the admin code (-a)\n");
+	return false;
+}
+
+// Packs a code as its digit count then BCD, 0 if it is not 4 to 10 digits
+static uint16_t pack(const char *code, uint8_t *out)
+{
+	size_t digits = strlen(code);
+
+	if (digits < CODESTORE_MIN || digits > CODESTORE_MAX || strspn(code, "0123456789") != digits) {
+		return 0;
+	}
+	out[0] = (uint8_t)digits;
+	for (size_t i = 0; i < digits; i += 2) {
+		out[1 + i / 2] = (uint8_t)((code[i] - '0') << 4 | (i + 1 < digits ? code[i + 1] - '0' : 0x0F));
+	}
+	return (uint16_t)(1 + (digits + 1) / 2);
+}
+
+static void report(const char *what, unsigned codes, uint64_t bytes, double seconds)
+{
+	double line = baud / 10.0;
+
+	fprintf(stderr, "%s %u codes in %.2f s, %.0f codes/s, %llu bytes at %.0f bytes/s, %.0f%% of the line\n",
+		what, codes, seconds, codes / seconds, (unsigned long long)bytes, bytes / seconds,
+		100.0 * bytes / seconds / line);
+	fprintf(stderr, "%u frames sent again, %u timeouts\n", resends, timeouts);
+}
+
+// Sends the codes in in as IMPORT frames, go-back-N
+static int import(FILE *in)
+{
+	static uint8_t packed[MAXCODES][PROVISION_CODE_BYTES];
+	static uint16_t sizes[MAXCODES];
+	static uint32_t starts[MAXCODES + 1]; // First code of each frame
+	char line[64];
+	unsigned codes = 0, frames = 0, added = 0, skipped = 0, base = 0, next = 0, highest = 0, tries = 0;
+	uint16_t size = 0;
+	uint8_t payload[PROVISION_PAYLOAD];
+	frame_t f;
+	double start, streamed;
+
+	while (codes < MAXCODES && fgets(line, sizeof(line), in) != NULL) {
+		line[strcspn(line, "\r\n \t")] = '\0';
+		if (line[0] == '\0') {
+			continue;
+		}
+		sizes[codes] = pack(line, packed[codes]);
+		if (sizes[codes] == 0) {
+			fprintf(stderr, "skipping %s: not 4 to 10 digits\n", line);
+			continue;
+		}
+		if (codes == 0 || size + sizes[codes] > PROVISION_PAYLOAD || codes - starts[frames - 1] == PROVISION_CODES) {
+			starts[frames++] = codes;
+			size = 0;
+		}
+		size += sizes[codes++];
+	}
+	starts[frames] = codes;
+
+	start = now();
+	if (!request(PROVISION_OPEN, PROVISION_READY, &f, TIMEOUT_MS) || f.len < 6) {
+		fprintf(stderr, "no answer from the lock\n");
+		return 1;
+	}
+	window = window < f.payload[0] ? window : f.payload[0];
+	fprintf(stderr, "lock has %u of %u codes, window %u\n", f.payload[2] | f.payload[3] << 8,
+		f.payload[4] | f.payload[5] << 8, window);
+
+	while (base < frames) {
+		while (next < frames && next - base < window) {
+			uint16_t len = 0;
+
+			for (uint32_t c = starts[next]; c < starts[next + 1]; c++) {
+				memcpy(&payload[len], packed[c], sizes[c]);
+				len += sizes[c];
+			}
+			resends += next < highest;
+			sendframe(PROVISION_IMPORT, (uint8_t)next, payload, len);
+			next++;
+			highest = next > highest ? next : highest;
+		}
+		if (!readframe(&f, TIMEOUT_MS)) {
+			timeouts++;
+			if (++tries == TRIES) {
+				fprintf(stderr, "lock stopped answering at frame %u of %u\n", base, frames);
+				return 1;
+			}
+			next = base;
+			continue;
+		}
+		tries = 0;
+		if (f.type == PROVISION_ACK || f.type == PROVISION_NAK) {
+			unsigned acked = (uint8_t)(f.seq - (uint8_t)base);
+
+			if (acked > next - base) {
+				continue; // Stale
+			}
+			if (f.type == PROVISION_ACK && acked > 0 && f.len >= 2) {
+				added += f.payload[0];
+				skipped += f.payload[1];
+			}
+			base += acked;
+			if (f.type == PROVISION_NAK) {
+				next = base;
+			}
+		}
+	}
+
+	streamed = now() - start;
+	if (!request(PROVISION_SYNC, PROVISION_SYNCED, &f, SYNC_MS) || f.len < 4) {
+		fprintf(stderr, "lock did not confirm the codes were saved\n");
+		return 1;
+	}
+	fprintf(stderr, "%u added, %u skipped, lock now has %u codes, %u flash errors\n", added, skipped,
+		f.payload[0] | f.payload[1] << 8, f.payload[2] | f.payload[3] << 8);
+	fprintf(stderr, "all in flash after %.2f s\n", now() - start);
+	request(PROVISION_CLOSE, PROVISION_CLOSED, &f, TIMEOUT_MS);
+	report("sent", codes, sent, streamed);
+	return 0;
+}
+
+// Prints the lock's codes, acknowledging each DATA frame in order
+static int export(void)
+{
+	char code[CODESTORE_MAX + 1];
+	uint8_t expect = 0;
+	unsigned codes = 0, tries = 0;
+	bool nakked = false, any = false;
+	frame_t f;
+	double start;
+
+	start = now();
+	if (!request(PROVISION_OPEN, PROVISION_READY, &f, TIMEOUT_MS)) {
+		fprintf(stderr, "no answer from the lock\n");
+		return 1;
+	}
+	sendframe(PROVISION_EXPORT, 0, NULL, 0);
+	for (;;) {
+		if (!readframe(&f, TIMEOUT_MS)) {
+			timeouts++;
+			if (++tries == TRIES) {
+				fprintf(stderr, "lock stopped answering after %u codes\n", codes);
+				return 1;
+			}
+			if (any == false) {
+				sendframe(PROVISION_EXPORT, 0, NULL, 0);
+			} else {
+				sendframe(PROVISION_NEXT, expect, NULL, 0); // Same seq again, the lock goes back
+			}
+			continue;
+		}
+		tries = 0;
+		if (f.type != PROVISION_DATA && f.type != PROVISION_END) {
+			continue;
+		}
+		if (f.seq != expect) {
+			if (nakked == false) {
+				nakked = true;
+				resends++;
+				sendframe(PROVISION_NEXT, expect, NULL, 0);
+			}
+			continue;
+		}
+		any = true;
+		nakked = false;
+		expect++;
+		sendframe(PROVISION_NEXT, expect, NULL, 0);
+		if (f.type == PROVISION_END) {
+			unsigned count = f.len >= 2 ? (unsigned)(f.payload[0] | f.payload[1] << 8) : 0;
+
+			if (count != codes) {
+				fprintf(stderr, "lock sent %u codes, %u arrived\n", count, codes);
+			}
+			if (f.len >= 3 && f.payload[2] != 0) {
+				fprintf(stderr, "codes changed during the export, some may be missing\n");
+			}
+			break;
+		}
+		for (uint16_t at = 0; at < f.len; ) {
+			uint8_t digits = f.payload[at];
+
+			if (digits < CODESTORE_MIN || digits > CODESTORE_MAX || at + 1 + (digits + 1) / 2 > f.len) {
+				break;
+			}
+			for (uint8_t d = 0; d < digits; d++) {
+				uint8_t b = f.payload[at + 1 + d / 2];
+
+				code[d] = (char)('0' + ((d & 1) ? b & 15 : b >> 4));
+			}
+			code[digits] = '\0';
+			puts(code);
+			codes++;
+			at += 1 + (digits + 1) / 2;
+		}
+	}
+	request(PROVISION_CLOSE, PROVISION_CLOSED, &f, TIMEOUT_MS);
+	report("exported", codes, received, now() - start);
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-a code] [-b baud] [-w window] device import [file]\n"
+		"       %s [-a code] [-b baud] [-w window] device export\n"
+		"  import    adds the codes in file (default stdin), one per line, and waits until they are in flash\n"
+		"  export    prints the lock's codes, one per line\n"
+		"  -a        the lock's admin code, to log in on the console (default %s)\n"
+		"  -b        line rate (default 115200)\n"
+		"  -w        frames in flight, up to the lock's (default %d)\n",
+		name, name, admin, PROVISION_WINDOW);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	int opt, result;
+
+	while ((opt = getopt(argc, argv, "a:b:w:h")) != -1) {
+		switch (opt) {
+			case 'a':
+				admin = optarg;
+				break;
+			case 'b':
+				baud = (unsigned)atoi(optarg);
+				break;
+			case 'w':
+				window = (unsigned)atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? 0 : 2;
+		}
+	}
+	if (argc - optind < 2 || window == 0) {
+		usage(argv[0]);
+		return 2;
+	}
+	fd = openport(argv[optind]);
+	if (fd < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if (login() == false) {
+		close(fd);
+		return 1;
+	}
+	if (strcmp(argv[optind + 1], "import") == 0) {
+		if (argc - optind > 2 && (in = fopen(argv[optind + 2], "r")) == NULL) {
+			perror(argv[optind + 2]);
+			return 1;
+		}
+		result = import(in);
+	} else if (strcmp(argv[optind + 1], "export") == 0) {
+		result = export();
+	} else {
+		usage(argv[0]);
+		result = 2;
+	}
+	close(fd);
+	return result;
+}